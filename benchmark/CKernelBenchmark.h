@@ -0,0 +1,218 @@
+#pragma once
+
+/**
+ * @file CKernelBenchmark.h
+ * @brief Contains the declaration of the CKernelBenchmark class used by benchmark/main.cpp.
+ *
+ * CDrawBenchmark times frames through a draw manager; this times the library's standalone kernels,
+ * e.g. spatial ordering or hull construction, on inputs built by the caller.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Cali
+{
+    /**
+     * @brief Result of a CKernelBenchmark run.
+     * */
+    struct SKernelResult
+    {
+        const char *m_szName = "";
+
+        /**
+         * @brief Items processed per run, e.g. points or vertices.
+         * */
+        size_t m_nItems = 0;
+
+        /**
+         * @brief Wall time of the fastest run.
+         * */
+        double m_flMilliseconds = 0.0;
+
+        double m_flNsPerItem = 0.0;
+        double m_flItemsPerSecond = 0.0;
+
+        /**
+         * @brief Last level cache misses per item in the fastest run, or -1 when the counter is unavailable.
+         * */
+        double m_flCacheMissesPerItem = -1.0;
+
+        /**
+         * @brief Value returned by the kernel, to compare runs and keep the work alive.
+         * */
+        uint64_t m_nChecksum = 0;
+    };
+
+    /**
+     * @class CCacheMissCounter
+     * @brief Counts last level cache misses of the calling thread and the threads it starts, through perf_event_open.
+     *
+     * Only available on Linux with access to hardware counters; IsAvailable() is false in virtual machines
+     * without a PMU or when perf_event_paranoid forbids it.
+     */
+    class CCacheMissCounter
+    {
+    private:
+        int m_nFile = -1;
+
+    public:
+        CCacheMissCounter()
+        {
+#if defined(__linux__)
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.inherit = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            m_nFile = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+
+        ~CCacheMissCounter()
+        {
+#if defined(__linux__)
+            if (m_nFile >= 0)
+                close(m_nFile);
+#endif
+        }
+
+        CCacheMissCounter(const CCacheMissCounter &) = delete;
+        CCacheMissCounter &operator=(const CCacheMissCounter &) = delete;
+
+        bool IsAvailable() const { return m_nFile >= 0; }
+
+        void Start()
+        {
+#if defined(__linux__)
+            if (m_nFile < 0)
+                return;
+
+            ioctl(m_nFile, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_nFile, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+
+        /**
+         * @brief Stop counting.
+         * @return The misses since Start(), 0 if unavailable.
+         * */
+        uint64_t Stop()
+        {
+            uint64_t nMisses = 0;
+#if defined(__linux__)
+            if (m_nFile < 0)
+                return 0;
+
+            ioctl(m_nFile, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_nFile, &nMisses, sizeof(nMisses)) != static_cast<ssize_t>(sizeof(nMisses)))
+                nMisses = 0;
+#endif
+            return nMisses;
+        }
+    };
+
+    /**
+     * @class CKernelBenchmark
+     * @brief Times a kernel over several runs and keeps the fastest, which is the least disturbed by the system.
+     */
+    class CKernelBenchmark
+    {
+    private:
+        size_t m_nRuns = 5;
+        CCacheMissCounter m_CacheMisses;
+
+    public:
+        explicit CKernelBenchmark(size_t nRuns = 5) : m_nRuns(nRuns ? nRuns : 1) {}
+
+        /**
+         * @brief Time a kernel.
+         * @param szName The row name, must outlive the result.
+         * @param nItems The items the kernel processes per call.
+         * @param fnKernel Called once per run as uint64_t fnKernel(); returns a checksum of its output.
+         * Inputs it modifies must be restored by the caller outside the timed call, e.g. in fnSetup.
+         * @param fnSetup Called untimed before every run.
+         * @return The result of the fastest run.
+         * */
+        template <typename TKernel, typename TSetup>
+        SKernelResult Run(const char *szName, size_t nItems, TKernel &&fnKernel, TSetup &&fnSetup)
+        {
+            SKernelResult result;
+            result.m_szName = szName;
+            result.m_nItems = nItems;
+
+            uint64_t nBestNs = UINT64_MAX;
+
+            for (size_t nRun = 0; nRun < m_nRuns; nRun++)
+            {
+                fnSetup();
+
+                m_CacheMisses.Start();
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                const uint64_t nChecksum = fnKernel();
+                const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                const uint64_t nMisses = m_CacheMisses.Stop();
+
+                const uint64_t nNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                if (nNs < nBestNs)
+                {
+                    nBestNs = nNs;
+                    result.m_nChecksum = nChecksum;
+
+                    if (m_CacheMisses.IsAvailable() && nItems)
+                        result.m_flCacheMissesPerItem = static_cast<double>(nMisses) / static_cast<double>(nItems);
+                }
+            }
+
+            result.m_flMilliseconds = static_cast<double>(nBestNs) / 1e6;
+            if (nItems)
+                result.m_flNsPerItem = static_cast<double>(nBestNs) / static_cast<double>(nItems);
+            if (nBestNs)
+                result.m_flItemsPerSecond = static_cast<double>(nItems) * 1e9 / static_cast<double>(nBestNs);
+
+            return result;
+        }
+
+        template <typename TKernel>
+        SKernelResult Run(const char *szName, size_t nItems, TKernel &&fnKernel)
+        {
+            return Run(szName, nItems, fnKernel, [] {});
+        }
+
+        /**
+         * @brief Print results as a table.
+         * @param vecResults The results.
+         * @param pFile The stream to print to.
+         * */
+        static void Print(const std::vector<SKernelResult> &vecResults, FILE *pFile = stdout)
+        {
+            std::fprintf(pFile, "%-24s %10s %10s %10s %14s %12s %18s\n", "kernel", "items", "ms", "ns/item", "items/s", "misses/item", "checksum");
+
+            for (const SKernelResult &result : vecResults)
+            {
+                char szMisses[32] = "n/a";
+                if (result.m_flCacheMissesPerItem >= 0.0)
+                    std::snprintf(szMisses, sizeof(szMisses), "%.3f", result.m_flCacheMissesPerItem);
+
+                std::fprintf(pFile, "%-24s %10zu %10.2f %10.2f %14.0f %12s %18llx\n", result.m_szName, result.m_nItems, result.m_flMilliseconds,
+                             result.m_flNsPerItem, result.m_flItemsPerSecond, szMisses, static_cast<unsigned long long>(result.m_nChecksum));
+            }
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,406 @@
+/**
+ * @file main.cpp
+ * @brief Runs the CDrawBenchmark workloads against the null and software backends, then the CKernelBenchmark kernels.
+ *
+ * Build and run from the repository root, see README.md:
+ *
+ *     g++ -std=c++17 -O2 -DNDEBUG -Iinclude benchmark/main.cpp include/CDynamicDrawManager.cpp -o cali_benchmark -lpthread
+ *     ./cali_benchmark [frames]
+ *
+ * Build it once more with -DCALI_VECTOR_EXPRESSIONS to time the vector kernels with expression templates.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+
+#include "CDrawBenchmark.h"
+#include "CDynamicDrawManager.h"
+#include "CGeometry2D.h"
+#include "CKernelBenchmark.h"
+#include "CSpatialOrder.h"
+#include "CVector2D.h"
+#include "CVector3D.h"
+#include "CVertexWelder.h"
+#include "DrawManagers/CDrawManager_Null.h"
+#include "DrawManagers/CDrawManager_Software.h"
+
+#if defined(_MSC_VER)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif
+
+namespace
+{
+    std::atomic<size_t> g_nAllocations{0};
+
+    size_t GetAllocationCount() { return g_nAllocations.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gather one value per point from a 16 MB grid with the points in random, Morton and Hilbert order,
+     * and time the sorts themselves.
+     *
+     * The 4 KB page switches between consecutive lookups are printed as well, a portable stand-in for
+     * the cache miss counter where hardware counters are unavailable.
+     * */
+    void RunSpatialOrderBenchmarks(Cali::CKernelBenchmark &benchmark)
+    {
+        using namespace Cali;
+
+        constexpr size_t GRID_SIZE = 2048;
+        constexpr size_t POINT_COUNT = 2 * 1024 * 1024;
+
+        CBenchmarkRandom random(42);
+        std::vector<uint32_t> vecGrid(GRID_SIZE * GRID_SIZE);
+        for (uint32_t &nValue : vecGrid)
+            nValue = random.Next();
+
+        std::vector<CVector2D<float>> vecRandom(POINT_COUNT);
+        for (CVector2D<float> &vec : vecRandom)
+            vec = CVector2D<float>(random.NextFloat(0.0f, static_cast<float>(GRID_SIZE)), random.NextFloat(0.0f, static_cast<float>(GRID_SIZE)));
+
+        CSpatialOrder spatialOrder;
+        std::vector<CVector2D<float>> vecMorton = vecRandom;
+        std::vector<CVector2D<float>> vecHilbert = vecRandom;
+        spatialOrder.Sort(vecMorton, SPATIAL_CURVE_MORTON);
+        spatialOrder.Sort(vecHilbert, SPATIAL_CURVE_HILBERT);
+
+        const auto GetCell = [](const CVector2D<float> &vec)
+        { return static_cast<size_t>(vec.GetY()) * GRID_SIZE + static_cast<size_t>(vec.GetX()); };
+
+        const auto Gather = [&](const std::vector<CVector2D<float>> &vecPoints)
+        {
+            uint64_t nSum = 0;
+            for (const CVector2D<float> &vec : vecPoints)
+                nSum += vecGrid[GetCell(vec)];
+
+            return nSum;
+        };
+
+        const auto CountPageSwitches = [&](const std::vector<CVector2D<float>> &vecPoints)
+        {
+            size_t nSwitches = 0;
+            for (size_t i = 1; i < vecPoints.size(); i++)
+                nSwitches += GetCell(vecPoints[i]) * sizeof(uint32_t) / 4096 != GetCell(vecPoints[i - 1]) * sizeof(uint32_t) / 4096;
+
+            return nSwitches;
+        };
+
+        std::vector<CVector2D<float>> vecSorted;
+        const auto Sort = [&](SpatialCurve_e nCurve)
+        {
+            spatialOrder.Sort(vecSorted, nCurve);
+            return static_cast<uint64_t>(GetCell(vecSorted.front())) << 32 | GetCell(vecSorted.back());
+        };
+
+        std::vector<SKernelResult> vecResults;
+        vecResults.push_back(benchmark.Run("Gather random", POINT_COUNT, [&] { return Gather(vecRandom); }));
+        vecResults.push_back(benchmark.Run("Gather Morton", POINT_COUNT, [&] { return Gather(vecMorton); }));
+        vecResults.push_back(benchmark.Run("Gather Hilbert", POINT_COUNT, [&] { return Gather(vecHilbert); }));
+        vecResults.push_back(benchmark.Run("Sort Morton", POINT_COUNT, [&] { return Sort(SPATIAL_CURVE_MORTON); }, [&] { vecSorted = vecRandom; }));
+        vecResults.push_back(benchmark.Run("Sort Hilbert", POINT_COUNT, [&] { return Sort(SPATIAL_CURVE_HILBERT); }, [&] { vecSorted = vecRandom; }));
+
+        std::printf("\nCSpatialOrder, %zu points over a %zux%zu grid of uint32\n", POINT_COUNT, GRID_SIZE, GRID_SIZE);
+        CKernelBenchmark::Print(vecResults);
+        std::printf("4 KB page switches per point: random %.3f, Morton %.3f, Hilbert %.3f\n",
+                    static_cast<double>(CountPageSwitches(vecRandom)) / POINT_COUNT, static_cast<double>(CountPageSwitches(vecMorton)) / POINT_COUNT,
+                    static_cast<double>(CountPageSwitches(vecHilbert)) / POINT_COUNT);
+    }
+
+#if defined(CALI_VECTOR_EXPRESSIONS)
+    constexpr const char *VECTOR_MODE = "expression templates";
+#else
+    constexpr const char *VECTOR_MODE = "eager operators";
+#endif
+
+    /**
+     * @brief Kernels of RunVectorBenchmarks(), kept out of line so their code can be compared between the two modes.
+     * */
+    BENCHMARK_NOINLINE void IntegrateParticles(Cali::CVector3D<float> *pPositions, const Cali::CVector3D<float> *pVelocities,
+                                               const Cali::CVector3D<float> *pAccelerations, size_t nCount, float flStep, float flDrag)
+    {
+        for (size_t i = 0; i < nCount; i++)
+            pPositions[i] = pPositions[i] + pVelocities[i] * flStep - pAccelerations[i] * flDrag;
+    }
+
+    BENCHMARK_NOINLINE void LerpPoints(const Cali::CVector2D<double> *pFrom, const Cali::CVector2D<double> *pTo, Cali::CVector2D<double> *pOut,
+                                       size_t nCount, double flT)
+    {
+        for (size_t i = 0; i < nCount; i++)
+            pOut[i] = pFrom[i] + (pTo[i] - pFrom[i]) * flT;
+    }
+
+    template <typename T>
+    uint64_t HashComponents(const T *pValues, size_t nCount)
+    {
+        uint64_t nHash = 14695981039346656037ull;
+        for (size_t i = 0; i < nCount; i++)
+        {
+            uint64_t nBits = 0;
+            std::memcpy(&nBits, &pValues[i], sizeof(T) < sizeof(nBits) ? sizeof(T) : sizeof(nBits));
+            nHash = (nHash ^ nBits) * 1099511628211ull;
+        }
+
+        return nHash;
+    }
+
+    /**
+     * @brief Time CVector2D/CVector3D arithmetic chains in the mode this file was built in, eager
+     * operators or expression templates.
+     * */
+    void RunVectorBenchmarks(Cali::CKernelBenchmark &benchmark)
+    {
+        using namespace Cali;
+
+        constexpr size_t VECTOR_COUNT = 1024 * 1024;
+        constexpr size_t STEPS = 16;
+
+        CBenchmarkRandom random(7);
+        std::vector<CVector3D<float>> vecPositions(VECTOR_COUNT), vecVelocities(VECTOR_COUNT), vecAccelerations(VECTOR_COUNT);
+        std::vector<CVector2D<double>> vecFrom(VECTOR_COUNT), vecTo(VECTOR_COUNT), vecLerped(VECTOR_COUNT);
+
+        for (size_t i = 0; i < VECTOR_COUNT; i++)
+        {
+            vecVelocities[i] = CVector3D<float>(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+            vecAccelerations[i] = CVector3D<float>(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+            vecFrom[i] = CVector2D<double>(random.NextFloat(0.0f, 1920.0f), random.NextFloat(0.0f, 1080.0f));
+            vecTo[i] = CVector2D<double>(random.NextFloat(0.0f, 1920.0f), random.NextFloat(0.0f, 1080.0f));
+        }
+
+        std::vector<SKernelResult> vecResults;
+        vecResults.push_back(benchmark.Run(
+            "p + v * dt - a * k", VECTOR_COUNT * STEPS,
+            [&]
+            {
+                for (size_t nStep = 0; nStep < STEPS; nStep++)
+                    IntegrateParticles(vecPositions.data(), vecVelocities.data(), vecAccelerations.data(), VECTOR_COUNT, 1.0f / 60.0f, 0.01f);
+
+                return HashComponents(vecPositions.data(), vecPositions.size());
+            },
+            [&] { std::fill(vecPositions.begin(), vecPositions.end(), CVector3D<float>()); }));
+        vecResults.push_back(benchmark.Run("a + (b - a) * t", VECTOR_COUNT * STEPS,
+                                           [&]
+                                           {
+                                               for (size_t nStep = 0; nStep < STEPS; nStep++)
+                                                   LerpPoints(vecFrom.data(), vecTo.data(), vecLerped.data(), VECTOR_COUNT, static_cast<double>(nStep) / STEPS);
+
+                                               return HashComponents(vecLerped.data(), vecLerped.size());
+                                           }));
+
+        std::printf("\nCVector3D<float> and CVector2D<double> arithmetic, %s\n", VECTOR_MODE);
+        CKernelBenchmark::Print(vecResults);
+    }
+
+    /**
+     * @brief Time CVertexWelder on the triangle soup of a height field, in mesh order and shuffled, with
+     * and without jitter below the epsilon.
+     * */
+    void RunVertexWeldBenchmarks(Cali::CKernelBenchmark &benchmark)
+    {
+        using namespace Cali;
+
+        constexpr size_t GRID_SIZE = 512;
+        constexpr size_t VERTEX_COUNT = GRID_SIZE * GRID_SIZE * 6;
+        constexpr double EPSILON = 1e-3;
+
+        CBenchmarkRandom random(3);
+        std::vector<double> vecHeights((GRID_SIZE + 1) * (GRID_SIZE + 1));
+        for (double &flHeight : vecHeights)
+            flHeight = random.NextFloat(0.0f, 16.0f);
+
+        // Every quad is two triangles; every corner is shared by up to 6 of them.
+        std::vector<CVector3D<double>> vecSoup;
+        vecSoup.reserve(VERTEX_COUNT);
+        const auto GetCorner = [&](size_t x, size_t y)
+        { return CVector3D<double>(static_cast<double>(x), static_cast<double>(y), vecHeights[y * (GRID_SIZE + 1) + x]); };
+
+        for (size_t y = 0; y < GRID_SIZE; y++)
+        {
+            for (size_t x = 0; x < GRID_SIZE; x++)
+            {
+                const CVector3D<double> arrCorners[6] = {GetCorner(x, y), GetCorner(x + 1, y), GetCorner(x + 1, y + 1),
+                                                         GetCorner(x, y), GetCorner(x + 1, y + 1), GetCorner(x, y + 1)};
+                vecSoup.insert(vecSoup.end(), std::begin(arrCorners), std::end(arrCorners));
+            }
+        }
+
+        // Swap whole triangles, so the soup stays a valid mesh.
+        std::vector<CVector3D<double>> vecShuffled = vecSoup;
+        for (size_t nTriangle = VERTEX_COUNT / 3 - 1; nTriangle > 0; nTriangle--)
+        {
+            const size_t nOther = random.Next() % (nTriangle + 1);
+            std::swap_ranges(vecShuffled.begin() + nTriangle * 3, vecShuffled.begin() + nTriangle * 3 + 3, vecShuffled.begin() + nOther * 3);
+        }
+
+        std::vector<CVector3D<double>> vecJittered = vecShuffled;
+        for (CVector3D<double> &vec : vecJittered)
+        {
+            const float flJitter = static_cast<float>(EPSILON) * 0.25f;
+            vec += CVector3D<double>(random.NextFloat(-flJitter, flJitter), random.NextFloat(-flJitter, flJitter), random.NextFloat(-flJitter, flJitter));
+        }
+
+        CVertexWelder<double> welder;
+        SIndexedMesh<double> mesh;
+        const auto Weld = [&](const std::vector<CVector3D<double>> &vecVertices, double flEpsilon)
+        {
+            welder.SetEpsilon(flEpsilon);
+            welder.Weld(vecVertices.data(), vecVertices.size(), mesh);
+
+            uint64_t nHash = 14695981039346656037ull;
+            for (const uint32_t nIndex : mesh.m_vecIndices)
+                nHash = (nHash ^ nIndex) * 1099511628211ull;
+
+            return static_cast<uint64_t>(mesh.m_vecVertices.size()) << 40 ^ (nHash & 0xFFFFFFFFFFull);
+        };
+
+        std::vector<SKernelResult> vecResults;
+        vecResults.push_back(benchmark.Run("Weld exact, in order", VERTEX_COUNT, [&] { return Weld(vecSoup, 0.0); }));
+        vecResults.push_back(benchmark.Run("Weld exact, shuffled", VERTEX_COUNT, [&] { return Weld(vecShuffled, 0.0); }));
+        vecResults.push_back(benchmark.Run("Weld in order", VERTEX_COUNT, [&] { return Weld(vecSoup, EPSILON); }));
+        vecResults.push_back(benchmark.Run("Weld shuffled", VERTEX_COUNT, [&] { return Weld(vecShuffled, EPSILON); }));
+        vecResults.push_back(benchmark.Run("Weld jittered", VERTEX_COUNT, [&] { return Weld(vecJittered, EPSILON); }));
+
+        std::printf("\nCVertexWelder, %zu vertices of a %zux%zu height field, %zu unique, epsilon %g\n", VERTEX_COUNT, GRID_SIZE, GRID_SIZE,
+                    (GRID_SIZE + 1) * (GRID_SIZE + 1), EPSILON);
+        CKernelBenchmark::Print(vecResults);
+        std::printf("The checksum holds the unique vertex count above bit 40.\n");
+    }
+
+    /**
+     * @brief Time CGeometry2D::ComputeConvexHull() on point sets from few to all points on the hull.
+     *
+     * The last set is a circle filling the first chunk and a cluster filling the other three: every later
+     * chunk lies inside the octagon and has an empty chunk hull.
+     * */
+    void RunConvexHullBenchmarks(Cali::CKernelBenchmark &benchmark)
+    {
+        using namespace Cali;
+
+        constexpr size_t POINT_COUNT = 1024 * 1024;
+        constexpr size_t RING_COUNT = CGeometry2D::CHUNK_SIZE;
+        constexpr size_t CORE_COUNT = 3 * CGeometry2D::CHUNK_SIZE;
+        constexpr double TWO_PI = 6.283185307179586;
+
+        CBenchmarkRandom random(11);
+        std::vector<CVector2D<double>> vecSquare(POINT_COUNT), vecDisk, vecCircle(POINT_COUNT), vecRingAndCore;
+
+        for (CVector2D<double> &vec : vecSquare)
+            vec = CVector2D<double>(random.NextFloat(-1000.0f, 1000.0f), random.NextFloat(-1000.0f, 1000.0f));
+
+        vecDisk.reserve(POINT_COUNT);
+        while (vecDisk.size() < POINT_COUNT)
+        {
+            const CVector2D<double> vec(random.NextFloat(-1000.0f, 1000.0f), random.NextFloat(-1000.0f, 1000.0f));
+            if (vec.GetX() * vec.GetX() + vec.GetY() * vec.GetY() <= 1000.0 * 1000.0)
+                vecDisk.push_back(vec);
+        }
+
+        for (size_t i = 0; i < POINT_COUNT; i++)
+            vecCircle[i] = CVector2D<double>(1000.0 * std::cos(TWO_PI * i / POINT_COUNT), 1000.0 * std::sin(TWO_PI * i / POINT_COUNT));
+
+        vecRingAndCore.reserve(RING_COUNT + CORE_COUNT);
+        for (size_t i = 0; i < RING_COUNT; i++)
+            vecRingAndCore.emplace_back(1000.0 * std::cos(TWO_PI * i / RING_COUNT), 1000.0 * std::sin(TWO_PI * i / RING_COUNT));
+        for (size_t i = 0; i < CORE_COUNT; i++)
+            vecRingAndCore.emplace_back(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+
+        std::vector<CVector2D<double>> vecHull;
+        const auto Hull = [&](const std::vector<CVector2D<double>> &vecPoints)
+        {
+            CGeometry2D::ComputeConvexHull(vecPoints.data(), vecPoints.size(), vecHull);
+
+            uint64_t nHash = 14695981039346656037ull;
+            for (const CVector2D<double> &vec : vecHull)
+            {
+                uint64_t nBits = 0;
+                const double flSum = vec.GetX() + vec.GetY();
+                std::memcpy(&nBits, &flSum, sizeof(nBits));
+                nHash = (nHash ^ nBits) * 1099511628211ull;
+            }
+
+            return static_cast<uint64_t>(vecHull.size()) << 40 ^ (nHash & 0xFFFFFFFFFFull);
+        };
+
+        std::vector<SKernelResult> vecResults;
+        vecResults.push_back(benchmark.Run("Hull square", POINT_COUNT, [&] { return Hull(vecSquare); }));
+        vecResults.push_back(benchmark.Run("Hull disk", POINT_COUNT, [&] { return Hull(vecDisk); }));
+        vecResults.push_back(benchmark.Run("Hull circle", POINT_COUNT, [&] { return Hull(vecCircle); }));
+        vecResults.push_back(benchmark.Run("Hull ring and core", vecRingAndCore.size(), [&] { return Hull(vecRingAndCore); }));
+
+        std::printf("\nCGeometry2D::ComputeConvexHull, %zu points in a square, a disk and on a circle, then %zu on a circle around %zu in its centre\n",
+                    POINT_COUNT, RING_COUNT, CORE_COUNT);
+        CKernelBenchmark::Print(vecResults);
+        std::printf("The checksum holds the hull vertex count above bit 40.\n");
+    }
+} // namespace
+
+void *operator new(size_t nSize)
+{
+    g_nAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *pMemory = std::malloc(nSize ? nSize : 1))
+        return pMemory;
+
+    throw std::bad_alloc();
+}
+
+// GCC pairs the inlined free() with the library's new expressions and warns, although both sides are replaced here.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *pMemory) noexcept { std::free(pMemory); }
+void operator delete(void *pMemory, size_t) noexcept { std::free(pMemory); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main(int argc, char **argv)
+{
+    using namespace Cali;
+
+    const size_t nFrames = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 100;
+
+    CDrawBenchmark benchmark(nFrames);
+    benchmark.SetAllocationCounter(&GetAllocationCount);
+
+    std::printf("CDrawManager_Null, %zu frames\n", nFrames);
+    CDrawManager<CDrawManager_Null> nullManager;
+    nullManager.Initialize();
+    CDrawBenchmark::Print(benchmark.RunSuite(nullManager));
+
+    CDynamicDrawManager dynamicManager(CDynamicDrawManager::Null);
+    dynamicManager.Initialize();
+    CDrawBenchmark::Print(benchmark.RunDispatch(nullManager, dynamicManager));
+    dynamicManager.Shutdown();
+    nullManager.Shutdown();
+
+    // Rasterising is three orders of magnitude slower than dispatch, so the software backend gets a tenth of the frames.
+    const size_t nSoftwareFrames = nFrames / 10 ? nFrames / 10 : 1;
+    CDrawBenchmark softwareBenchmark(nSoftwareFrames, 1);
+    softwareBenchmark.SetAllocationCounter(&GetAllocationCount);
+
+    std::printf("\nCDrawManager_Software at 1920x1080, %zu frames\n", nSoftwareFrames);
+    CDrawManager<CDrawManager_Software> softwareManager;
+    softwareManager.GetBackend().GetTarget().Resize(1920, 1080);
+    softwareManager.Initialize();
+    CDrawBenchmark::Print(softwareBenchmark.RunSuite(softwareManager));
+    softwareManager.Shutdown();
+
+    // Kernels keep the fastest of a few runs; their inputs are large enough that more add little.
+    CKernelBenchmark kernelBenchmark(5);
+    RunSpatialOrderBenchmarks(kernelBenchmark);
+    RunVectorBenchmarks(kernelBenchmark);
+    RunVertexWeldBenchmarks(kernelBenchmark);
+    RunConvexHullBenchmarks(kernelBenchmark);
+
+    return 0;
+}
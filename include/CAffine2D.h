@@ -0,0 +1,317 @@
+#pragma once
+
+/**
+ * @file CAffine2D.h
+ * @brief Contains the declaration of the CAffine2D class.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "CVector2D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief An affine transform split into translation, rotation, shear and scale.
+     *
+     * The linear part is Rotation(m_flRotation) * [1 m_flShear; 0 1] * Scale(m_vecScale). A reflection
+     * shows up as a negative Y scale.
+     * */
+    template <typename T = double>
+    struct SAffine2DDecomposition
+    {
+        CVector2D<T> m_vecTranslation = {};
+        T m_flRotation = T(0);
+        T m_flShear = T(0);
+        CVector2D<T> m_vecScale = CVector2D<T>(T(1), T(1));
+    };
+
+    /**
+     * @class CAffine2D
+     * @brief A 2D affine transform, stored as the top two rows of a 3x3 matrix.
+     *
+     * A point p maps to (m00 * x + m01 * y + m02, m10 * x + m11 * y + m12). a * b applies b first, then a.
+     *
+     * The batch Apply() overloads take interleaved CVector2D arrays or SoA coordinate arrays and
+     * transform two float or one double point per SSE2 operation on interleaved input, and four float
+     * or two double points on SoA input.
+     */
+    template <typename T = double>
+    class CAffine2D
+    {
+    private:
+        T m_flM00 = T(1);
+        T m_flM01 = T(0);
+        T m_flM02 = T(0);
+        T m_flM10 = T(0);
+        T m_flM11 = T(1);
+        T m_flM12 = T(0);
+
+    public:
+        /**
+         * @brief Default constructor.
+         * Initializes the identity transform.
+         * */
+        CAffine2D() = default;
+
+        /**
+         * @brief Parameterized constructor.
+         * Initializes the transform from its two rows.
+         * */
+        CAffine2D(T flM00, T flM01, T flM02, T flM10, T flM11, T flM12) : m_flM00(flM00), m_flM01(flM01), m_flM02(flM02), m_flM10(flM10), m_flM11(flM11), m_flM12(flM12) {}
+
+        static CAffine2D Identity() { return CAffine2D(); }
+
+        static CAffine2D Translation(const CVector2D<T> &vecOffset) { return CAffine2D(T(1), T(0), vecOffset.GetX(), T(0), T(1), vecOffset.GetY()); }
+
+        static CAffine2D Scale(T flScaleX, T flScaleY) { return CAffine2D(flScaleX, T(0), T(0), T(0), flScaleY, T(0)); }
+
+        /**
+         * @brief Counter-clockwise rotation in a Y-up frame, clockwise on screen where Y points down.
+         * @param flRadians The angle in radians.
+         * */
+        static CAffine2D Rotation(T flRadians)
+        {
+            const T flCos = std::cos(flRadians);
+            const T flSin = std::sin(flRadians);
+            return CAffine2D(flCos, -flSin, T(0), flSin, flCos, T(0));
+        }
+
+        /**
+         * @brief Build a transform from its decomposition, the inverse of Decompose().
+         * */
+        static CAffine2D Compose(const SAffine2DDecomposition<T> &decomposition)
+        {
+            const T flCos = std::cos(decomposition.m_flRotation);
+            const T flSin = std::sin(decomposition.m_flRotation);
+            const T flScaleX = decomposition.m_vecScale.GetX();
+            const T flScaleY = decomposition.m_vecScale.GetY();
+            const T flShear = decomposition.m_flShear;
+
+            return CAffine2D(flCos * flScaleX, (flCos * flShear - flSin) * flScaleY, decomposition.m_vecTranslation.GetX(), flSin * flScaleX,
+                             (flSin * flShear + flCos) * flScaleY, decomposition.m_vecTranslation.GetY());
+        }
+
+        T GetM00() const { return m_flM00; }
+        T GetM01() const { return m_flM01; }
+        T GetM02() const { return m_flM02; }
+        T GetM10() const { return m_flM10; }
+        T GetM11() const { return m_flM11; }
+        T GetM12() const { return m_flM12; }
+
+        CVector2D<T> GetTranslation() const { return CVector2D<T>(m_flM02, m_flM12); }
+
+        T GetDeterminant() const { return m_flM00 * m_flM11 - m_flM01 * m_flM10; }
+
+        bool IsIdentity() const
+        {
+            return m_flM00 == T(1) && m_flM01 == T(0) && m_flM02 == T(0) && m_flM10 == T(0) && m_flM11 == T(1) && m_flM12 == T(0);
+        }
+
+        /**
+         * @brief Check whether the transform keeps axis-aligned rectangles axis-aligned, i.e. has no rotation or shear.
+         * */
+        bool IsAxisAligned() const { return m_flM01 == T(0) && m_flM10 == T(0); }
+
+        /**
+         * @brief Compose two transforms.
+         * @return The transform applying transform first, then this one.
+         * */
+        CAffine2D operator*(const CAffine2D &transform) const
+        {
+            return CAffine2D(m_flM00 * transform.m_flM00 + m_flM01 * transform.m_flM10, m_flM00 * transform.m_flM01 + m_flM01 * transform.m_flM11,
+                             m_flM00 * transform.m_flM02 + m_flM01 * transform.m_flM12 + m_flM02, m_flM10 * transform.m_flM00 + m_flM11 * transform.m_flM10,
+                             m_flM10 * transform.m_flM01 + m_flM11 * transform.m_flM11, m_flM10 * transform.m_flM02 + m_flM11 * transform.m_flM12 + m_flM12);
+        }
+
+        CAffine2D &operator*=(const CAffine2D &transform)
+        {
+            *this = *this * transform;
+            return *this;
+        }
+
+        bool operator==(const CAffine2D &transform) const
+        {
+            return m_flM00 == transform.m_flM00 && m_flM01 == transform.m_flM01 && m_flM02 == transform.m_flM02 && m_flM10 == transform.m_flM10 &&
+                   m_flM11 == transform.m_flM11 && m_flM12 == transform.m_flM12;
+        }
+
+        bool operator!=(const CAffine2D &transform) const { return !(*this == transform); }
+
+        /**
+         * @brief Compute the inverse transform.
+         * @param inverse Receives the inverse, left untouched if there is none.
+         * @return False if the transform is singular.
+         * */
+        bool GetInverse(CAffine2D &inverse) const
+        {
+            const T flDeterminant = GetDeterminant();
+            if (flDeterminant == T(0) || !std::isfinite(static_cast<double>(flDeterminant)))
+                return false;
+
+            const T flInvDeterminant = T(1) / flDeterminant;
+            const T flM00 = m_flM11 * flInvDeterminant;
+            const T flM01 = -m_flM01 * flInvDeterminant;
+            const T flM10 = -m_flM10 * flInvDeterminant;
+            const T flM11 = m_flM00 * flInvDeterminant;
+
+            inverse = CAffine2D(flM00, flM01, -(flM00 * m_flM02 + flM01 * m_flM12), flM10, flM11, -(flM10 * m_flM02 + flM11 * m_flM12));
+            return true;
+        }
+
+        /**
+         * @brief Split the transform into translation, rotation, shear and scale, see SAffine2DDecomposition.
+         *
+         * Compose() of the result gives the transform back, up to rounding, with one exception: a singular
+         * transform whose two columns are parallel and non-zero has no such decomposition, and comes back
+         * with its Y column dropped. A transform that collapses X takes its rotation from the Y column.
+         * */
+        SAffine2DDecomposition<T> Decompose() const
+        {
+            SAffine2DDecomposition<T> decomposition;
+            decomposition.m_vecTranslation = GetTranslation();
+
+            const T flScaleX = std::sqrt(m_flM00 * m_flM00 + m_flM10 * m_flM10);
+            if (flScaleX == T(0))
+            {
+                // Rotate the Y axis onto the Y column, so the Y scale is its length and there is no shear.
+                const T flScaleY = std::sqrt(m_flM01 * m_flM01 + m_flM11 * m_flM11);
+                decomposition.m_flRotation = flScaleY != T(0) ? std::atan2(-m_flM01, m_flM11) : T(0);
+                decomposition.m_vecScale = CVector2D<T>(T(0), flScaleY);
+                decomposition.m_flShear = T(0);
+                return decomposition;
+            }
+
+            const T flCos = m_flM00 / flScaleX;
+            const T flSin = m_flM10 / flScaleX;
+            const T flScaleY = flCos * m_flM11 - flSin * m_flM01;
+
+            decomposition.m_flRotation = std::atan2(flSin, flCos);
+            decomposition.m_vecScale = CVector2D<T>(flScaleX, flScaleY);
+            decomposition.m_flShear = flScaleY != T(0) ? (flCos * m_flM01 + flSin * m_flM11) / flScaleY : T(0);
+            return decomposition;
+        }
+
+        /**
+         * @brief Transform a point.
+         * */
+        CVector2D<T> Apply(const CVector2D<T> &vec) const
+        {
+            return CVector2D<T>(m_flM00 * vec.GetX() + m_flM01 * vec.GetY() + m_flM02, m_flM10 * vec.GetX() + m_flM11 * vec.GetY() + m_flM12);
+        }
+
+        /**
+         * @brief Transform a direction, ignoring the translation.
+         * */
+        CVector2D<T> ApplyVector(const CVector2D<T> &vec) const
+        {
+            return CVector2D<T>(m_flM00 * vec.GetX() + m_flM01 * vec.GetY(), m_flM10 * vec.GetX() + m_flM11 * vec.GetY());
+        }
+
+        /**
+         * @brief Transform an interleaved array of points.
+         * @param pIn The points.
+         * @param pOut Receives the transformed points, may be pIn.
+         * @param nCount The number of points.
+         * */
+        void Apply(const CVector2D<T> *pIn, CVector2D<T> *pOut, size_t nCount) const
+        {
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            if constexpr (std::is_same<T, float>::value)
+            {
+                // Two points per register: (x0, y0, x1, y1).
+                const __m128 vecColumnX = _mm_setr_ps(m_flM00, m_flM10, m_flM00, m_flM10);
+                const __m128 vecColumnY = _mm_setr_ps(m_flM01, m_flM11, m_flM01, m_flM11);
+                const __m128 vecTranslation = _mm_setr_ps(m_flM02, m_flM12, m_flM02, m_flM12);
+
+                for (; i + 2 <= nCount; i += 2)
+                {
+                    const __m128 vecPoints = _mm_setr_ps(pIn[i].GetX(), pIn[i].GetY(), pIn[i + 1].GetX(), pIn[i + 1].GetY());
+                    const __m128 vecX = _mm_shuffle_ps(vecPoints, vecPoints, _MM_SHUFFLE(2, 2, 0, 0));
+                    const __m128 vecY = _mm_shuffle_ps(vecPoints, vecPoints, _MM_SHUFFLE(3, 3, 1, 1));
+
+                    float arrResult[4];
+                    _mm_storeu_ps(arrResult, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vecX, vecColumnX), _mm_mul_ps(vecY, vecColumnY)), vecTranslation));
+                    pOut[i] = CVector2D<float>(arrResult[0], arrResult[1]);
+                    pOut[i + 1] = CVector2D<float>(arrResult[2], arrResult[3]);
+                }
+            }
+            else if constexpr (std::is_same<T, double>::value)
+            {
+                const __m128d vecColumnX = _mm_setr_pd(m_flM00, m_flM10);
+                const __m128d vecColumnY = _mm_setr_pd(m_flM01, m_flM11);
+                const __m128d vecTranslation = _mm_setr_pd(m_flM02, m_flM12);
+
+                for (; i < nCount; i++)
+                {
+                    const __m128d vecX = _mm_set1_pd(pIn[i].GetX());
+                    const __m128d vecY = _mm_set1_pd(pIn[i].GetY());
+
+                    double arrResult[2];
+                    _mm_storeu_pd(arrResult, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vecX, vecColumnX), _mm_mul_pd(vecY, vecColumnY)), vecTranslation));
+                    pOut[i] = CVector2D<double>(arrResult[0], arrResult[1]);
+                }
+            }
+#endif
+
+            for (; i < nCount; i++)
+                pOut[i] = Apply(pIn[i]);
+        }
+
+        /**
+         * @brief Transform points stored as separate X and Y arrays.
+         * @param pOutX Receives the transformed X coordinates, may be pX.
+         * @param pOutY Receives the transformed Y coordinates, may be pY.
+         * */
+        void Apply(const T *pX, const T *pY, T *pOutX, T *pOutY, size_t nCount) const
+        {
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            if constexpr (std::is_same<T, float>::value)
+            {
+                const __m128 arrMatrix[6] = {_mm_set1_ps(m_flM00), _mm_set1_ps(m_flM01), _mm_set1_ps(m_flM02),
+                                             _mm_set1_ps(m_flM10), _mm_set1_ps(m_flM11), _mm_set1_ps(m_flM12)};
+
+                // Round down to whole registers up front, an i + 4 <= nCount bound hides the tail's trip count from GCC.
+                const size_t nVectorEnd = nCount & ~size_t(3);
+                for (; i < nVectorEnd; i += 4)
+                {
+                    const __m128 vecX = _mm_loadu_ps(pX + i);
+                    const __m128 vecY = _mm_loadu_ps(pY + i);
+                    _mm_storeu_ps(pOutX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vecX, arrMatrix[0]), _mm_mul_ps(vecY, arrMatrix[1])), arrMatrix[2]));
+                    _mm_storeu_ps(pOutY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vecX, arrMatrix[3]), _mm_mul_ps(vecY, arrMatrix[4])), arrMatrix[5]));
+                }
+            }
+            else if constexpr (std::is_same<T, double>::value)
+            {
+                const __m128d arrMatrix[6] = {_mm_set1_pd(m_flM00), _mm_set1_pd(m_flM01), _mm_set1_pd(m_flM02),
+                                              _mm_set1_pd(m_flM10), _mm_set1_pd(m_flM11), _mm_set1_pd(m_flM12)};
+
+                const size_t nVectorEnd = nCount & ~size_t(1);
+                for (; i < nVectorEnd; i += 2)
+                {
+                    const __m128d vecX = _mm_loadu_pd(pX + i);
+                    const __m128d vecY = _mm_loadu_pd(pY + i);
+                    _mm_storeu_pd(pOutX + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vecX, arrMatrix[0]), _mm_mul_pd(vecY, arrMatrix[1])), arrMatrix[2]));
+                    _mm_storeu_pd(pOutY + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vecX, arrMatrix[3]), _mm_mul_pd(vecY, arrMatrix[4])), arrMatrix[5]));
+                }
+            }
+#endif
+
+            for (; i < nCount; i++)
+            {
+                const T flX = pX[i];
+                const T flY = pY[i];
+                pOutX[i] = m_flM00 * flX + m_flM01 * flY + m_flM02;
+                pOutY[i] = m_flM10 * flX + m_flM11 * flY + m_flM12;
+            }
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,166 @@
+#pragma once
+
+/**
+ * @file CCircleCache.h
+ * @brief Contains the declaration of the CCircleCache class.
+ */
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "Constants.h"
+#include "CVector2D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @class CCircleCache
+     * @brief Precomputed unit circles used to tessellate circles without per-segment sin/cos.
+     *
+     * Unit circles are built once for LEVELS segment counts, doubling from MIN_SEGMENTS to
+     * MAX_SEGMENTS. The segment count of a circle is picked from its on-screen radius so the
+     * distance between the true circle and the polygon stays below the configured maximum error.
+     * Tessellating is then a scale and offset of the cached table.
+     */
+    class CCircleCache
+    {
+    public:
+        static constexpr size_t LEVELS = 7;
+        static constexpr size_t MIN_SEGMENTS = 8;
+        static constexpr size_t MAX_SEGMENTS = MIN_SEGMENTS << (LEVELS - 1);
+
+    private:
+        /**
+         * @brief Interleaved x, y unit circle per level, closed by repeating the first vertex.
+         * */
+        std::array<std::vector<float>, LEVELS> m_UnitCircles;
+
+        /**
+         * @brief Maximum distance in pixels between a circle and its polygon.
+         * */
+        float m_flMaxError = 0.25f;
+
+        static size_t GetSegments(size_t nLevel) { return MIN_SEGMENTS << nLevel; }
+
+        size_t GetLevel(float flRadius) const
+        {
+            // A chord over an angle of 2*pi/n deviates r * (1 - cos(pi/n)) from the arc.
+            if (flRadius <= m_flMaxError)
+                return 0;
+
+            const float flSegments = CONST_PI_F / std::acos(1.0f - m_flMaxError / flRadius);
+
+            size_t nLevel = 0;
+            while (nLevel + 1 < LEVELS && static_cast<float>(GetSegments(nLevel)) < flSegments)
+                nLevel++;
+
+            return nLevel;
+        }
+
+    public:
+        CCircleCache()
+        {
+            for (size_t nLevel = 0; nLevel < LEVELS; nLevel++)
+            {
+                const size_t nSegments = GetSegments(nLevel);
+                std::vector<float> &vecUnitCircle = m_UnitCircles[nLevel];
+                vecUnitCircle.resize((nSegments + 1) * 2);
+
+                for (size_t i = 0; i <= nSegments; i++)
+                {
+                    const float flAngle = 2.0f * CONST_PI_F * static_cast<float>(i % nSegments) / static_cast<float>(nSegments);
+                    vecUnitCircle[i * 2] = std::cos(flAngle);
+                    vecUnitCircle[i * 2 + 1] = std::sin(flAngle);
+                }
+            }
+        }
+
+        /**
+         * @brief Set the maximum distance between a circle and its polygon.
+         * @param flMaxError The distance in pixels.
+         * */
+        void SetMaxError(float flMaxError) { m_flMaxError = flMaxError; }
+
+        /**
+         * @brief Get the maximum distance between a circle and its polygon.
+         * @return The distance in pixels.
+         * */
+        float GetMaxError() const { return m_flMaxError; }
+
+        /**
+         * @brief Get the number of segments used for a circle.
+         * @param flRadius The on-screen radius in pixels.
+         * @return The number of segments.
+         * */
+        size_t GetSegmentCount(float flRadius) const { return GetSegments(GetLevel(flRadius)); }
+
+        /**
+         * @brief Get the cached unit circle used for a circle.
+         * @param flRadius The on-screen radius in pixels.
+         * @return GetSegmentCount(flRadius) + 1 interleaved x, y pairs, the last repeating the first.
+         * */
+        const float *GetUnitCircle(float flRadius) const { return m_UnitCircles[GetLevel(flRadius)].data(); }
+
+        /**
+         * @brief Append the outline of a circle.
+         * @param vecCenter The center.
+         * @param flRadius The radius in pixels.
+         * @param vecOutline Receives GetSegmentCount(flRadius) + 1 vertices, the last repeating the first.
+         * */
+        void Tessellate(const CVector2D<float> &vecCenter, float flRadius, std::vector<CVector2D<float>> &vecOutline) const
+        {
+            const size_t nLevel = GetLevel(flRadius);
+            const float *pUnitCircle = m_UnitCircles[nLevel].data();
+
+            for (size_t i = 0; i <= GetSegments(nLevel); i++)
+                vecOutline.emplace_back(vecCenter.GetX() + pUnitCircle[i * 2] * flRadius, vecCenter.GetY() + pUnitCircle[i * 2 + 1] * flRadius);
+        }
+
+        /**
+         * @brief Tessellate a batch of circles into one interleaved x, y buffer.
+         * @param pCenters The centers.
+         * @param pRadii The radii in pixels.
+         * @param nCount The number of circles.
+         * @param vecXY Receives the closed outlines of all circles as interleaved x, y pairs.
+         * @param vecOffsets Receives nCount + 1 offsets; circle i uses vertices [vecOffsets[i], vecOffsets[i + 1]).
+         * */
+        void TessellateBatch(const CVector2D<float> *pCenters, const float *pRadii, size_t nCount, std::vector<float> &vecXY, std::vector<size_t> &vecOffsets) const
+        {
+            vecOffsets.resize(nCount + 1);
+            vecOffsets[0] = 0;
+
+            for (size_t i = 0; i < nCount; i++)
+                vecOffsets[i + 1] = vecOffsets[i] + GetSegmentCount(pRadii[i]) + 1;
+
+            vecXY.resize(vecOffsets[nCount] * 2);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const float *pUnitCircle = GetUnitCircle(pRadii[i]);
+                const size_t nFloats = (vecOffsets[i + 1] - vecOffsets[i]) * 2;
+                const float flCenterX = pCenters[i].GetX();
+                const float flCenterY = pCenters[i].GetY();
+                const float flRadius = pRadii[i];
+                float *pOut = &vecXY[vecOffsets[i] * 2];
+                size_t j = 0;
+
+#ifdef CALI_SIMD_SSE2
+                const __m128 vecCenter = _mm_setr_ps(flCenterX, flCenterY, flCenterX, flCenterY);
+                const __m128 vecRadius = _mm_set1_ps(flRadius);
+
+                for (; j + 4 <= nFloats; j += 4)
+                    _mm_storeu_ps(pOut + j, _mm_add_ps(vecCenter, _mm_mul_ps(_mm_loadu_ps(pUnitCircle + j), vecRadius)));
+#endif
+
+                for (; j < nFloats; j += 2)
+                {
+                    pOut[j] = flCenterX + pUnitCircle[j] * flRadius;
+                    pOut[j + 1] = flCenterY + pUnitCircle[j + 1] * flRadius;
+                }
+            }
+        }
+    };
+
+} // namespace Cali
@@ -6,8 +6,11 @@
  */
 
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include "Constants.h"
+#include "CProfiler.h"
 
 #ifdef CALI_SUPPORT_IMGUI_COLORS
 #include <imgui.h>
@@ -121,6 +124,8 @@ namespace Cali
          * */
         CColorKey(const RGBA &colorRGBA)
         {
+            CALI_PROFILE_SCOPE("CColorKey::Convert");
+
             m_ColorRGBA = colorRGBA;
 
             m_ColorRGB = {
@@ -138,6 +143,8 @@ namespace Cali
          * */
         CColorKey(const RGB &colorRGB)
         {
+            CALI_PROFILE_SCOPE("CColorKey::Convert");
+
             m_ColorRGB = colorRGB;
 
             m_ColorRGBA = {
@@ -156,6 +163,8 @@ namespace Cali
          * */
         CColorKey(const HEX_STRING &colorHEX)
         {
+            CALI_PROFILE_SCOPE("CColorKey::Convert");
+
             m_ColorHEX = colorHEX;
 
             m_ColorRGBA = {
@@ -178,6 +187,8 @@ namespace Cali
          * */
         CColorKey(const HEX_NUMBER &colorHEXNumber)
         {
+            CALI_PROFILE_SCOPE("CColorKey::Convert");
+
             m_ColorHEXNumber = colorHEXNumber;
 
             m_ColorRGBA = {
@@ -230,6 +241,34 @@ namespace Cali
             return m_ColorHEXNumber;
         }
 
+        /**
+         * @brief equality operator for CColorKey class.
+         * @param colorKey color key data.
+         * */
+        bool operator==(const CColorKey &colorKey) const
+        {
+            return m_ColorRGBA == colorKey.m_ColorRGBA && m_ColorRGB == colorKey.m_ColorRGB && m_ColorHEX == colorKey.m_ColorHEX && m_ColorHEXNumber == colorKey.m_ColorHEXNumber;
+        }
+
+        /**
+         * @brief inequality operator for CColorKey class.
+         * @param colorKey color key data.
+         * */
+        bool operator!=(const CColorKey &colorKey) const
+        {
+            return !(*this == colorKey);
+        }
+
+        /**
+         * @brief Get the RGBA color data packed into an integer with format 0xAARRGGBB.
+         * This is the layout draw backends consume, e.g. D3DCOLOR.
+         * @return Packed color data.
+         * */
+        uint32_t GetColorARGB() const
+        {
+            return static_cast<uint32_t>(m_ColorRGBA[3]) << 24 | static_cast<uint32_t>(m_ColorRGBA[0]) << 16 | static_cast<uint32_t>(m_ColorRGBA[1]) << 8 | static_cast<uint32_t>(m_ColorRGBA[2]);
+        }
+
         /**
          * @brief Set the RGBA color data.
          * @param colorRGBA RGBA color data.
@@ -267,6 +306,20 @@ namespace Cali
         }
     };
 
+    /**
+     * @brief Get color nIndex of an optional color array of a bulk draw call.
+     * @return The color packed as 0xAARRGGBB, CONST_COLOR_DEFAULT if pColors is null.
+     * */
+    inline uint32_t GetColor(const CColorKey *pColors, size_t nIndex)
+    {
+        return pColors ? pColors[nIndex].GetColorARGB() : CONST_COLOR_DEFAULT;
+    }
+
+    inline uint32_t GetColor(const uint32_t *pColors, size_t nIndex)
+    {
+        return pColors ? pColors[nIndex] : CONST_COLOR_DEFAULT;
+    }
+
     /**
      * @brief Color class.
      * */
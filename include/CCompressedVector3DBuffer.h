@@ -0,0 +1,507 @@
+#pragma once
+
+/**
+ * @file CCompressedVector3DBuffer.h
+ * @brief Contains the declaration of the CCompressedVector3DBuffer class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "CProfiler.h"
+#include "CVector3D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief Storage format of CCompressedVector3DBuffer.
+     * */
+    enum VectorEncoding_e
+    {
+        /**
+         * @brief IEEE half floats relative to the centre of the bounds, 6 bytes per point.
+         * Relative error of 2^-11, so points near the centre keep the most precision.
+         * */
+        VECTOR_ENCODING_HALF = 0,
+
+        /**
+         * @brief 16-bit integers spread evenly over the bounds, 6 bytes per point.
+         * */
+        VECTOR_ENCODING_INT16,
+
+        /**
+         * @brief 32-bit integers spread evenly over the bounds, 12 bytes per point.
+         * */
+        VECTOR_ENCODING_INT32
+    };
+
+    /**
+     * @class CCompressedVector3DBuffer
+     * @brief Stores CVector3D positions as half floats or as integers quantised against their bounding box.
+     *
+     * Each point is stored relative to the centre of the bounds, with x, y and z interleaved, so any
+     * point can be decoded on its own. Bulk encoding and decoding work in blocks of BLOCK_SIZE points
+     * and use SSE2 for the integer formats and F16C for half floats. Stream() hands out decoded
+     * blocks, so a transform can read the compressed data without decompressing it all first.
+     *
+     * Compared to CVector3D<double> the 16-bit formats use 4x less memory and INT32 2x less.
+     * GetMaxError() gives the largest per-axis error the chosen format can introduce.
+     *
+     * @tparam T The coordinate type of the decoded vectors.
+     */
+    template <typename T = double>
+    class CCompressedVector3DBuffer
+    {
+    public:
+        static constexpr size_t BLOCK_SIZE = 256;
+
+        /**
+         * @brief The largest finite half float. VECTOR_ENCODING_HALF needs half the bounds to fit within it.
+         * */
+        static constexpr double HALF_MAX = 65504.0;
+
+    private:
+        static constexpr double INT16_MAX_STEPS = 32767.0;
+        static constexpr double INT32_MAX_STEPS = 2147483647.0;
+
+        VectorEncoding_e m_nEncoding = VECTOR_ENCODING_INT16;
+        size_t m_nCount = 0;
+
+        /**
+         * @brief The centre of the bounds, which every stored value is relative to.
+         * */
+        double m_arrOrigin[3] = {0.0, 0.0, 0.0};
+
+        /**
+         * @brief The largest distance of a stored value from the origin, half the size of the bounds up to rounding.
+         * */
+        double m_arrHalfExtent[3] = {0.0, 0.0, 0.0};
+
+        /**
+         * @brief The distance between two quantised values, 1 for VECTOR_ENCODING_HALF.
+         * */
+        double m_arrStep[3] = {1.0, 1.0, 1.0};
+
+        std::vector<uint16_t> m_vec16 = {};
+        std::vector<uint32_t> m_vec32 = {};
+
+        static uint16_t FloatToHalf(float flValue)
+        {
+            // Round to nearest even, with overflow to infinity and correctly rounded subnormals.
+            uint32_t nBits;
+            std::memcpy(&nBits, &flValue, sizeof(nBits));
+
+            const uint32_t nSign = (nBits >> 16) & 0x8000;
+            nBits &= 0x7FFFFFFF;
+
+            if (nBits >= 0x47800000)
+                return static_cast<uint16_t>(nSign | (nBits > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+            if (nBits < 0x38800000)
+            {
+                // Adding 0.5 lets the FPU round the subnormal mantissa into the low bits.
+                float flAbsolute;
+                std::memcpy(&flAbsolute, &nBits, sizeof(flAbsolute));
+                flAbsolute += 0.5f;
+                std::memcpy(&nBits, &flAbsolute, sizeof(nBits));
+                return static_cast<uint16_t>(nSign | (nBits - 0x3F000000));
+            }
+
+            const uint32_t nMantissaOdd = (nBits >> 13) & 1;
+            nBits += 0xC8000FFF + nMantissaOdd;
+            return static_cast<uint16_t>(nSign | (nBits >> 13));
+        }
+
+        static float HalfToFloat(uint16_t nHalf)
+        {
+            uint32_t nBits = static_cast<uint32_t>(nHalf & 0x7FFF) << 13;
+            const uint32_t nExponent = nBits & 0x0F800000;
+            nBits += 0x38000000;
+
+            float flValue;
+            if (nExponent == 0x0F800000)
+            {
+                nBits += 0x38000000;
+                std::memcpy(&flValue, &nBits, sizeof(flValue));
+            }
+            else if (nExponent == 0)
+            {
+                // Renormalise subnormals by subtracting the implicit bit as a float.
+                nBits += 0x00800000;
+                std::memcpy(&flValue, &nBits, sizeof(flValue));
+                flValue -= 6.103515625e-05f;
+            }
+            else
+                std::memcpy(&flValue, &nBits, sizeof(flValue));
+
+            return (nHalf & 0x8000) ? -flValue : flValue;
+        }
+
+        /**
+         * @brief Write one block of relative values, nComponents = 3 * points, in the current format.
+         * */
+        void EncodeBlock(const double *pRelative, size_t nComponents, size_t nFirstComponent)
+        {
+            size_t i = 0;
+
+            switch (m_nEncoding)
+            {
+            case VECTOR_ENCODING_HALF:
+            {
+                uint16_t *pOut = m_vec16.data() + nFirstComponent;
+#ifdef CALI_SIMD_F16C
+                for (; i + 4 <= nComponents; i += 4)
+                {
+                    const __m128 vecValues = _mm_setr_ps(static_cast<float>(pRelative[i]), static_cast<float>(pRelative[i + 1]),
+                                                         static_cast<float>(pRelative[i + 2]), static_cast<float>(pRelative[i + 3]));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(pOut + i), _mm_cvtps_ph(vecValues, _MM_FROUND_TO_NEAREST_INT));
+                }
+#endif
+                for (; i < nComponents; i++)
+                    pOut[i] = FloatToHalf(static_cast<float>(pRelative[i]));
+                break;
+            }
+
+            case VECTOR_ENCODING_INT16:
+            {
+                const float arrScale[3] = {static_cast<float>(GetScale(0)), static_cast<float>(GetScale(1)), static_cast<float>(GetScale(2))};
+                uint16_t *pOut = m_vec16.data() + nFirstComponent;
+#ifdef CALI_SIMD_SSE2
+                // Four points are twelve components, so the per-axis scales repeat every three registers.
+                const __m128 vecScale0 = _mm_setr_ps(arrScale[0], arrScale[1], arrScale[2], arrScale[0]);
+                const __m128 vecScale1 = _mm_setr_ps(arrScale[1], arrScale[2], arrScale[0], arrScale[1]);
+                const __m128 vecScale2 = _mm_setr_ps(arrScale[2], arrScale[0], arrScale[1], arrScale[2]);
+
+                const auto Load = [&](size_t n)
+                { return _mm_setr_ps(static_cast<float>(pRelative[n]), static_cast<float>(pRelative[n + 1]),
+                                     static_cast<float>(pRelative[n + 2]), static_cast<float>(pRelative[n + 3])); };
+
+                for (; i + 12 <= nComponents; i += 12)
+                {
+                    const __m128i vec0 = _mm_cvtps_epi32(_mm_mul_ps(Load(i), vecScale0));
+                    const __m128i vec1 = _mm_cvtps_epi32(_mm_mul_ps(Load(i + 4), vecScale1));
+                    const __m128i vec2 = _mm_cvtps_epi32(_mm_mul_ps(Load(i + 8), vecScale2));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + i), _mm_packs_epi32(vec0, vec1));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(pOut + i + 8), _mm_packs_epi32(vec2, vec2));
+                }
+#endif
+                for (; i < nComponents; i++)
+                {
+                    const float flValue = std::nearbyint(static_cast<float>(pRelative[i]) * arrScale[(nFirstComponent + i) % 3]);
+                    pOut[i] = static_cast<uint16_t>(static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, flValue))));
+                }
+                break;
+            }
+
+            case VECTOR_ENCODING_INT32:
+            {
+                const double arrScale[3] = {GetScale(0), GetScale(1), GetScale(2)};
+                uint32_t *pOut = m_vec32.data() + nFirstComponent;
+#ifdef CALI_SIMD_SSE2
+                // Two points are six components in three registers of two doubles.
+                const __m128d vecScale0 = _mm_setr_pd(arrScale[0], arrScale[1]);
+                const __m128d vecScale1 = _mm_setr_pd(arrScale[2], arrScale[0]);
+                const __m128d vecScale2 = _mm_setr_pd(arrScale[1], arrScale[2]);
+
+                // Out of range conversions give INT_MIN, so clamp like the scalar tail.
+                const __m128d vecMaxSteps = _mm_set1_pd(INT32_MAX_STEPS);
+                const __m128d vecMinSteps = _mm_set1_pd(-INT32_MAX_STEPS);
+
+                const auto Quantise = [&](size_t n, __m128d vecScale)
+                { return _mm_cvtpd_epi32(_mm_max_pd(vecMinSteps, _mm_min_pd(vecMaxSteps, _mm_mul_pd(_mm_loadu_pd(pRelative + n), vecScale)))); };
+
+                for (; i + 6 <= nComponents; i += 6)
+                {
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(pOut + i), Quantise(i, vecScale0));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(pOut + i + 2), Quantise(i + 2, vecScale1));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(pOut + i + 4), Quantise(i + 4, vecScale2));
+                }
+#endif
+                for (; i < nComponents; i++)
+                {
+                    const double flValue = std::nearbyint(pRelative[i] * arrScale[(nFirstComponent + i) % 3]);
+                    pOut[i] = static_cast<uint32_t>(static_cast<int32_t>(std::max(-INT32_MAX_STEPS, std::min(INT32_MAX_STEPS, flValue))));
+                }
+                break;
+            }
+            }
+        }
+
+        /**
+         * @brief Read one block of components back as values relative to the origin.
+         * */
+        void DecodeBlock(size_t nFirstComponent, size_t nComponents, double *pRelative) const
+        {
+            size_t i = 0;
+
+            switch (m_nEncoding)
+            {
+            case VECTOR_ENCODING_HALF:
+            {
+                const uint16_t *pIn = m_vec16.data() + nFirstComponent;
+#ifdef CALI_SIMD_F16C
+                for (; i + 4 <= nComponents; i += 4)
+                {
+                    float arrValues[4];
+                    _mm_storeu_ps(arrValues, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pIn + i))));
+                    for (size_t j = 0; j < 4; j++)
+                        pRelative[i + j] = arrValues[j];
+                }
+#endif
+                for (; i < nComponents; i++)
+                    pRelative[i] = HalfToFloat(pIn[i]);
+                break;
+            }
+
+            case VECTOR_ENCODING_INT16:
+            {
+                const float arrStep[3] = {static_cast<float>(m_arrStep[0]), static_cast<float>(m_arrStep[1]), static_cast<float>(m_arrStep[2])};
+                const uint16_t *pIn = m_vec16.data() + nFirstComponent;
+#ifdef CALI_SIMD_SSE2
+                const __m128 vecStep0 = _mm_setr_ps(arrStep[0], arrStep[1], arrStep[2], arrStep[0]);
+                const __m128 vecStep1 = _mm_setr_ps(arrStep[1], arrStep[2], arrStep[0], arrStep[1]);
+                const __m128 vecStep2 = _mm_setr_ps(arrStep[2], arrStep[0], arrStep[1], arrStep[2]);
+
+                const auto Store = [&](size_t n, __m128 vecValues)
+                {
+                    float arrValues[4];
+                    _mm_storeu_ps(arrValues, vecValues);
+                    for (size_t j = 0; j < 4; j++)
+                        pRelative[n + j] = arrValues[j];
+                };
+
+                for (; i + 12 <= nComponents; i += 12)
+                {
+                    // Sign-extend by unpacking into the high half and shifting back down.
+                    const __m128i vec01 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i));
+                    const __m128i vec2 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pIn + i + 8));
+
+                    Store(i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vec01, vec01), 16)), vecStep0));
+                    Store(i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(vec01, vec01), 16)), vecStep1));
+                    Store(i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vec2, vec2), 16)), vecStep2));
+                }
+#endif
+                for (; i < nComponents; i++)
+                    pRelative[i] = static_cast<float>(static_cast<int16_t>(pIn[i])) * arrStep[(nFirstComponent + i) % 3];
+                break;
+            }
+
+            case VECTOR_ENCODING_INT32:
+            {
+                const uint32_t *pIn = m_vec32.data() + nFirstComponent;
+#ifdef CALI_SIMD_SSE2
+                const __m128d vecStep0 = _mm_setr_pd(m_arrStep[0], m_arrStep[1]);
+                const __m128d vecStep1 = _mm_setr_pd(m_arrStep[2], m_arrStep[0]);
+                const __m128d vecStep2 = _mm_setr_pd(m_arrStep[1], m_arrStep[2]);
+
+                for (; i + 6 <= nComponents; i += 6)
+                {
+                    _mm_storeu_pd(pRelative + i, _mm_mul_pd(_mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pIn + i))), vecStep0));
+                    _mm_storeu_pd(pRelative + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pIn + i + 2))), vecStep1));
+                    _mm_storeu_pd(pRelative + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pIn + i + 4))), vecStep2));
+                }
+#endif
+                for (; i < nComponents; i++)
+                    pRelative[i] = static_cast<double>(static_cast<int32_t>(pIn[i])) * m_arrStep[(nFirstComponent + i) % 3];
+                break;
+            }
+            }
+        }
+
+        /**
+         * @brief The factor from a relative value to quantised steps, 0 for flat axes.
+         * */
+        double GetScale(int nAxis) const { return m_arrHalfExtent[nAxis] > 0.0 ? 1.0 / m_arrStep[nAxis] : 0.0; }
+
+    public:
+        /**
+         * @brief Replace the contents with compressed copies of the points.
+         * @param pPoints The points.
+         * @param nCount The number of points.
+         * @param nEncoding The storage format.
+         * @return False, leaving the buffer unchanged, if VECTOR_ENCODING_HALF cannot hold the bounds.
+         * */
+        bool Encode(const CVector3D<T> *pPoints, size_t nCount, VectorEncoding_e nEncoding)
+        {
+            CALI_PROFILE_SCOPE("CCompressedVector3DBuffer::Encode");
+
+            double arrMin[3] = {0.0, 0.0, 0.0};
+            double arrMax[3] = {0.0, 0.0, 0.0};
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const double arrPoint[3] = {static_cast<double>(pPoints[i].GetX()), static_cast<double>(pPoints[i].GetY()), static_cast<double>(pPoints[i].GetZ())};
+                for (int j = 0; j < 3; j++)
+                {
+                    arrMin[j] = i == 0 ? arrPoint[j] : std::min(arrMin[j], arrPoint[j]);
+                    arrMax[j] = i == 0 ? arrPoint[j] : std::max(arrMax[j], arrPoint[j]);
+                }
+            }
+
+            for (int j = 0; j < 3; j++)
+            {
+                if (nEncoding == VECTOR_ENCODING_HALF && (arrMax[j] - arrMin[j]) * 0.5 > HALF_MAX)
+                    return false;
+            }
+
+            m_nEncoding = nEncoding;
+            m_nCount = nCount;
+
+            for (int j = 0; j < 3; j++)
+            {
+                m_arrOrigin[j] = (arrMin[j] + arrMax[j]) * 0.5;
+
+                // The rounded origin can sit closer to one end of the bounds, so the step covers the
+                // farther one exactly as the encoder computes it.
+                m_arrHalfExtent[j] = std::max(arrMax[j] - m_arrOrigin[j], m_arrOrigin[j] - arrMin[j]);
+
+                if (nEncoding == VECTOR_ENCODING_HALF || m_arrHalfExtent[j] <= 0.0)
+                    m_arrStep[j] = 1.0;
+                else
+                    m_arrStep[j] = m_arrHalfExtent[j] / (nEncoding == VECTOR_ENCODING_INT16 ? INT16_MAX_STEPS : INT32_MAX_STEPS);
+            }
+
+            m_vec16.clear();
+            m_vec32.clear();
+            if (nEncoding == VECTOR_ENCODING_INT32)
+                m_vec32.resize(nCount * 3);
+            else
+                m_vec16.resize(nCount * 3);
+
+            double arrRelative[BLOCK_SIZE * 3];
+
+            for (size_t nFirst = 0; nFirst < nCount; nFirst += BLOCK_SIZE)
+            {
+                const size_t nBlock = std::min(BLOCK_SIZE, nCount - nFirst);
+
+                for (size_t i = 0; i < nBlock; i++)
+                {
+                    const CVector3D<T> &point = pPoints[nFirst + i];
+                    arrRelative[i * 3] = static_cast<double>(point.GetX()) - m_arrOrigin[0];
+                    arrRelative[i * 3 + 1] = static_cast<double>(point.GetY()) - m_arrOrigin[1];
+                    arrRelative[i * 3 + 2] = static_cast<double>(point.GetZ()) - m_arrOrigin[2];
+                }
+
+                EncodeBlock(arrRelative, nBlock * 3, nFirst * 3);
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Decode one point.
+         * */
+        CVector3D<T> Get(size_t nIndex) const
+        {
+            double arrRelative[3];
+            DecodeBlock(nIndex * 3, 3, arrRelative);
+
+            return CVector3D<T>(static_cast<T>(m_arrOrigin[0] + arrRelative[0]),
+                                static_cast<T>(m_arrOrigin[1] + arrRelative[1]),
+                                static_cast<T>(m_arrOrigin[2] + arrRelative[2]));
+        }
+
+        /**
+         * @brief Decode a range of points.
+         * @param nFirst The index of the first point.
+         * @param nCount The number of points.
+         * @param pOut Receives nCount points.
+         * */
+        void Decode(size_t nFirst, size_t nCount, CVector3D<T> *pOut) const
+        {
+            Stream([&](const CVector3D<T> *pPoints, size_t nBlockFirst, size_t nBlockCount)
+                   { std::copy(pPoints, pPoints + nBlockCount, pOut + (nBlockFirst - nFirst)); },
+                   nFirst, nCount);
+        }
+
+        /**
+         * @brief Decode a range block by block and hand each block to a callback.
+         * @param fnBlock Called as fnBlock(const CVector3D<T> *pPoints, size_t nFirst, size_t nCount) with at most BLOCK_SIZE points.
+         * @param nFirst The index of the first point.
+         * @param nCount The number of points, everything from nFirst by default.
+         * */
+        template <typename TFunction>
+        void Stream(TFunction &&fnBlock, size_t nFirst = 0, size_t nCount = SIZE_MAX) const
+        {
+            CALI_PROFILE_SCOPE("CCompressedVector3DBuffer::Stream");
+
+            nFirst = std::min(nFirst, m_nCount);
+            nCount = std::min(nCount, m_nCount - nFirst);
+
+            double arrRelative[BLOCK_SIZE * 3];
+            CVector3D<T> arrPoints[BLOCK_SIZE];
+
+            for (size_t nBlockFirst = nFirst; nBlockFirst < nFirst + nCount; nBlockFirst += BLOCK_SIZE)
+            {
+                const size_t nBlock = std::min(BLOCK_SIZE, nFirst + nCount - nBlockFirst);
+                DecodeBlock(nBlockFirst * 3, nBlock * 3, arrRelative);
+
+                for (size_t i = 0; i < nBlock; i++)
+                {
+                    arrPoints[i] = CVector3D<T>(static_cast<T>(m_arrOrigin[0] + arrRelative[i * 3]),
+                                                static_cast<T>(m_arrOrigin[1] + arrRelative[i * 3 + 1]),
+                                                static_cast<T>(m_arrOrigin[2] + arrRelative[i * 3 + 2]));
+                }
+
+                fnBlock(static_cast<const CVector3D<T> *>(arrPoints), nBlockFirst, nBlock);
+            }
+        }
+
+        /**
+         * @brief The largest per-axis difference between a point and its decoded copy, before rounding to T.
+         *
+         * For the integer formats this is half a step, (max - min) / 65534 or / 4294967294, plus the
+         * float rounding of the 16-bit path, which stays below 2^-20 of half the bounds, or the double
+         * rounding of the 32-bit one. For half floats it is 2^-11 of the distance to the centre
+         * of the bounds, plus 2^-25 where values become subnormal. The 16-bit formats also add the
+         * rounding of adding the origin back, 2^-52 of its magnitude.
+         * */
+        CVector3D<double> GetMaxError() const
+        {
+            double arrError[3];
+
+            for (int j = 0; j < 3; j++)
+            {
+                const double flOriginRounding = std::fabs(m_arrOrigin[j]) * std::ldexp(1.0, -52);
+
+                switch (m_nEncoding)
+                {
+                case VECTOR_ENCODING_HALF:
+                    arrError[j] = m_arrHalfExtent[j] * (std::ldexp(1.0, -11) + std::ldexp(1.0, -23)) + std::ldexp(1.0, -25) + flOriginRounding;
+                    break;
+                case VECTOR_ENCODING_INT16:
+                    arrError[j] = m_arrHalfExtent[j] > 0.0 ? m_arrStep[j] * 0.5 + m_arrHalfExtent[j] * std::ldexp(1.0, -20) + flOriginRounding : 0.0;
+                    break;
+                case VECTOR_ENCODING_INT32:
+                    arrError[j] = m_arrHalfExtent[j] > 0.0 ? m_arrStep[j] * 0.5 + (std::fabs(m_arrOrigin[j]) + m_arrHalfExtent[j]) * std::ldexp(1.0, -50) : 0.0;
+                    break;
+                }
+            }
+
+            return CVector3D<double>(arrError[0], arrError[1], arrError[2]);
+        }
+
+        VectorEncoding_e GetEncoding() const { return m_nEncoding; }
+        size_t GetCount() const { return m_nCount; }
+        bool IsEmpty() const { return m_nCount == 0; }
+
+        /**
+         * @brief The bytes used by the compressed points.
+         * */
+        size_t GetSizeInBytes() const { return m_vec16.size() * sizeof(uint16_t) + m_vec32.size() * sizeof(uint32_t); }
+
+        void Clear()
+        {
+            m_nCount = 0;
+            m_vec16.clear();
+            m_vec32.clear();
+        }
+    };
+
+} // namespace Cali
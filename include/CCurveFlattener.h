@@ -0,0 +1,337 @@
+#pragma once
+
+/**
+ * @file CCurveFlattener.h
+ * @brief Contains the declaration of the CCurveFlattener class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CDrawCommand.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "Constants.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    struct SQuadraticBezier
+    {
+        CVector2D<float> m_Points[3];
+    };
+
+    struct SCubicBezier
+    {
+        CVector2D<float> m_Points[4];
+    };
+
+    /**
+     * @brief A circular arc. Angles are in radians, a negative sweep runs clockwise.
+     * */
+    struct SArc
+    {
+        CVector2D<float> m_Center;
+        float m_flRadius = 0.0f;
+        float m_flStartAngle = 0.0f;
+        float m_flSweepAngle = 0.0f;
+    };
+
+    /**
+     * @brief Polylines stored back to back as interleaved x, y.
+     * Polyline i spans the points m_vecOffsets[i] to m_vecOffsets[i + 1].
+     * */
+    struct SPolylineBatch
+    {
+        std::vector<float> m_vecXY = {};
+        std::vector<size_t> m_vecOffsets = {0};
+
+        size_t GetPolylineCount() const { return m_vecOffsets.size() - 1; }
+        size_t GetPointCount() const { return m_vecOffsets.back(); }
+
+        void Clear()
+        {
+            m_vecXY.clear();
+            m_vecOffsets.assign(1, 0);
+        }
+    };
+
+    /**
+     * @class CCurveFlattener
+     * @brief Flattens Bézier curves and arcs into polylines that stay within a pixel tolerance.
+     *
+     * The segment count of each curve is computed in closed form, not by recursive subdivision. For a
+     * curve split at uniform parameter steps the chord error is bounded by max|B''| / (8 n^2), which
+     * for Béziers depends only on the second differences of the control points (Wang's formula). Arcs
+     * use the chord error r * (1 - cos(a / 2)) as CCircleCache does, with at least one segment per
+     * quarter turn.
+     *
+     * A curve never gets more than MAX_SEGMENTS segments. Curves that would need more, e.g. huge ones at
+     * a fine tolerance, are flattened with MAX_SEGMENTS and can then deviate by more than the tolerance.
+     *
+     * Béziers are evaluated in power basis two points per SSE2 register, and the segment counts of
+     * cubics are computed four curves at a time.
+     */
+    class CCurveFlattener
+    {
+    public:
+        /**
+         * @brief Upper bound on the segments of one curve; it takes precedence over the tolerance.
+         * */
+        static constexpr size_t MAX_SEGMENTS = 1024;
+
+    private:
+        /**
+         * @brief Maximum distance in pixels between a curve and its polyline.
+         * */
+        float m_flTolerance = 0.25f;
+
+        static size_t ClampSegments(float flSegments)
+        {
+            if (!(flSegments > 1.0f))
+                return 1;
+
+            return flSegments >= static_cast<float>(MAX_SEGMENTS) ? MAX_SEGMENTS : static_cast<size_t>(std::ceil(flSegments));
+        }
+
+        static float Length(float flX, float flY) { return std::sqrt(flX * flX + flY * flY); }
+
+        /**
+         * @brief Reserve room for nSegments + 1 points of a new polyline.
+         * @return The first float of the new polyline.
+         * */
+        static float *AddPolyline(SPolylineBatch &batch, size_t nSegments)
+        {
+            const size_t nStart = batch.m_vecOffsets.back();
+            batch.m_vecOffsets.push_back(nStart + nSegments + 1);
+            batch.m_vecXY.resize((nStart + nSegments + 1) * 2);
+            return &batch.m_vecXY[nStart * 2];
+        }
+
+        /**
+         * @brief Evaluate a * t^3 + b * t^2 + c * t + d at nSegments + 1 uniform steps.
+         * */
+        static void EvaluatePolynomial(const float *pA, const float *pB, const float *pC, const float *pD, size_t nSegments, float *pOut)
+        {
+            const float flStep = 1.0f / static_cast<float>(nSegments);
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            const __m128 vecA = _mm_setr_ps(pA[0], pA[1], pA[0], pA[1]);
+            const __m128 vecB = _mm_setr_ps(pB[0], pB[1], pB[0], pB[1]);
+            const __m128 vecC = _mm_setr_ps(pC[0], pC[1], pC[0], pC[1]);
+            const __m128 vecD = _mm_setr_ps(pD[0], pD[1], pD[0], pD[1]);
+
+            for (; i + 2 <= nSegments + 1; i += 2)
+            {
+                const float flT0 = static_cast<float>(i) * flStep;
+                const float flT1 = static_cast<float>(i + 1) * flStep;
+                const __m128 vecT = _mm_setr_ps(flT0, flT0, flT1, flT1);
+
+                __m128 vecResult = _mm_add_ps(_mm_mul_ps(vecA, vecT), vecB);
+                vecResult = _mm_add_ps(_mm_mul_ps(vecResult, vecT), vecC);
+                vecResult = _mm_add_ps(_mm_mul_ps(vecResult, vecT), vecD);
+                _mm_storeu_ps(pOut + i * 2, vecResult);
+            }
+#endif
+
+            for (; i <= nSegments; i++)
+            {
+                const float flT = static_cast<float>(i) * flStep;
+                pOut[i * 2] = ((pA[0] * flT + pB[0]) * flT + pC[0]) * flT + pD[0];
+                pOut[i * 2 + 1] = ((pA[1] * flT + pB[1]) * flT + pC[1]) * flT + pD[1];
+            }
+
+            // Land exactly on the end point regardless of rounding.
+            pOut[nSegments * 2] = pA[0] + pB[0] + pC[0] + pD[0];
+            pOut[nSegments * 2 + 1] = pA[1] + pB[1] + pC[1] + pD[1];
+        }
+
+        static void GetCubicSecondDifferences(const SCubicBezier &cubic, float &flFirst, float &flSecond)
+        {
+            const CVector2D<float> *p = cubic.m_Points;
+            flFirst = Length(p[0].GetX() - 2.0f * p[1].GetX() + p[2].GetX(), p[0].GetY() - 2.0f * p[1].GetY() + p[2].GetY());
+            flSecond = Length(p[1].GetX() - 2.0f * p[2].GetX() + p[3].GetX(), p[1].GetY() - 2.0f * p[2].GetY() + p[3].GetY());
+        }
+
+    public:
+        /**
+         * @brief Set the maximum distance in pixels between a curve and its polyline.
+         * @param flTolerance The tolerance, clamped to a small positive minimum.
+         * */
+        void SetTolerance(float flTolerance) { m_flTolerance = flTolerance > 1e-4f ? flTolerance : 1e-4f; }
+        float GetTolerance() const { return m_flTolerance; }
+
+        size_t GetSegmentCount(const SQuadraticBezier &quadratic) const
+        {
+            const CVector2D<float> *p = quadratic.m_Points;
+            const float flSecondDifference = Length(p[0].GetX() - 2.0f * p[1].GetX() + p[2].GetX(), p[0].GetY() - 2.0f * p[1].GetY() + p[2].GetY());
+
+            // |B''| = 2 |P0 - 2 P1 + P2|, so the error is |P0 - 2 P1 + P2| / (4 n^2).
+            return ClampSegments(std::sqrt(flSecondDifference / (4.0f * m_flTolerance)));
+        }
+
+        size_t GetSegmentCount(const SCubicBezier &cubic) const
+        {
+            float flFirst, flSecond;
+            GetCubicSecondDifferences(cubic, flFirst, flSecond);
+
+            // |B''| <= 6 max|P(i) - 2 P(i+1) + P(i+2)|, so the error is at most 3 max / (4 n^2).
+            return ClampSegments(std::sqrt(3.0f * std::max(flFirst, flSecond) / (4.0f * m_flTolerance)));
+        }
+
+        size_t GetSegmentCount(const SArc &arc) const
+        {
+            // Tiny arcs still get a segment per quarter turn, so a full circle does not collapse into a chord.
+            const float flSweep = std::fabs(arc.m_flSweepAngle);
+            const size_t nMinSegments = ClampSegments(flSweep / static_cast<float>(CONST_PI / 2.0));
+
+            const float flRadius = std::fabs(arc.m_flRadius);
+            if (flRadius <= m_flTolerance)
+                return nMinSegments;
+
+            const float flMaxAngle = 2.0f * std::acos(1.0f - m_flTolerance / flRadius);
+            return std::max(nMinSegments, ClampSegments(flSweep / flMaxAngle));
+        }
+
+        /**
+         * @brief Append the polylines of quadratic Béziers to a batch.
+         * */
+        void Flatten(const SQuadraticBezier *pQuadratics, size_t nCount, SPolylineBatch &batch) const
+        {
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const CVector2D<float> *p = pQuadratics[i].m_Points;
+                const size_t nSegments = GetSegmentCount(pQuadratics[i]);
+
+                const float flA[2] = {0.0f, 0.0f};
+                const float flB[2] = {p[0].GetX() - 2.0f * p[1].GetX() + p[2].GetX(), p[0].GetY() - 2.0f * p[1].GetY() + p[2].GetY()};
+                const float flC[2] = {2.0f * (p[1].GetX() - p[0].GetX()), 2.0f * (p[1].GetY() - p[0].GetY())};
+                const float flD[2] = {p[0].GetX(), p[0].GetY()};
+
+                EvaluatePolynomial(flA, flB, flC, flD, nSegments, AddPolyline(batch, nSegments));
+            }
+        }
+
+        /**
+         * @brief Append the polylines of cubic Béziers to a batch.
+         * */
+        void Flatten(const SCubicBezier *pCubics, size_t nCount, SPolylineBatch &batch) const
+        {
+            CALI_PROFILE_SCOPE("CCurveFlattener::Flatten");
+
+            std::vector<size_t> vecSegments(nCount);
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            const __m128 vecScale = _mm_set1_ps(3.0f / (4.0f * m_flTolerance));
+
+            for (; i + 4 <= nCount; i += 4)
+            {
+                const CVector2D<float> *p0 = pCubics[i].m_Points;
+                const CVector2D<float> *p1 = pCubics[i + 1].m_Points;
+                const CVector2D<float> *p2 = pCubics[i + 2].m_Points;
+                const CVector2D<float> *p3 = pCubics[i + 3].m_Points;
+
+                // Gather one control point coordinate of four curves into a register.
+                const auto LoadX = [&](int n)
+                { return _mm_setr_ps(p0[n].GetX(), p1[n].GetX(), p2[n].GetX(), p3[n].GetX()); };
+                const auto LoadY = [&](int n)
+                { return _mm_setr_ps(p0[n].GetY(), p1[n].GetY(), p2[n].GetY(), p3[n].GetY()); };
+                const auto SecondDifferenceSqr = [&](int n)
+                {
+                    const __m128 vecTwo = _mm_set1_ps(2.0f);
+                    const __m128 vecX = _mm_add_ps(_mm_sub_ps(LoadX(n), _mm_mul_ps(vecTwo, LoadX(n + 1))), LoadX(n + 2));
+                    const __m128 vecY = _mm_add_ps(_mm_sub_ps(LoadY(n), _mm_mul_ps(vecTwo, LoadY(n + 1))), LoadY(n + 2));
+                    return _mm_add_ps(_mm_mul_ps(vecX, vecX), _mm_mul_ps(vecY, vecY));
+                };
+
+                const __m128 vecMax = _mm_sqrt_ps(_mm_max_ps(SecondDifferenceSqr(0), SecondDifferenceSqr(1)));
+
+                alignas(16) float flSegments[4];
+                _mm_store_ps(flSegments, _mm_sqrt_ps(_mm_mul_ps(vecMax, vecScale)));
+
+                for (size_t j = 0; j < 4; j++)
+                    vecSegments[i + j] = ClampSegments(flSegments[j]);
+            }
+#endif
+
+            for (; i < nCount; i++)
+                vecSegments[i] = GetSegmentCount(pCubics[i]);
+
+            size_t nTotal = batch.m_vecOffsets.back();
+            for (size_t nSegments : vecSegments)
+                nTotal += nSegments + 1;
+
+            batch.m_vecXY.reserve(nTotal * 2);
+            batch.m_vecOffsets.reserve(batch.m_vecOffsets.size() + nCount);
+
+            for (i = 0; i < nCount; i++)
+            {
+                const CVector2D<float> *p = pCubics[i].m_Points;
+
+                const float flA[2] = {p[3].GetX() - p[0].GetX() + 3.0f * (p[1].GetX() - p[2].GetX()), p[3].GetY() - p[0].GetY() + 3.0f * (p[1].GetY() - p[2].GetY())};
+                const float flB[2] = {3.0f * (p[0].GetX() - 2.0f * p[1].GetX() + p[2].GetX()), 3.0f * (p[0].GetY() - 2.0f * p[1].GetY() + p[2].GetY())};
+                const float flC[2] = {3.0f * (p[1].GetX() - p[0].GetX()), 3.0f * (p[1].GetY() - p[0].GetY())};
+                const float flD[2] = {p[0].GetX(), p[0].GetY()};
+
+                EvaluatePolynomial(flA, flB, flC, flD, vecSegments[i], AddPolyline(batch, vecSegments[i]));
+            }
+        }
+
+        /**
+         * @brief Append the polylines of arcs to a batch.
+         * */
+        void Flatten(const SArc *pArcs, size_t nCount, SPolylineBatch &batch) const
+        {
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const SArc &arc = pArcs[i];
+                const size_t nSegments = GetSegmentCount(arc);
+                float *pOut = AddPolyline(batch, nSegments);
+
+                // Rotate the radius vector by a fixed step instead of calling cos and sin per point.
+                const float flStep = arc.m_flSweepAngle / static_cast<float>(nSegments);
+                const float flStepCos = std::cos(flStep);
+                const float flStepSin = std::sin(flStep);
+                float flX = arc.m_flRadius * std::cos(arc.m_flStartAngle);
+                float flY = arc.m_flRadius * std::sin(arc.m_flStartAngle);
+
+                for (size_t j = 0; j < nSegments; j++)
+                {
+                    pOut[j * 2] = arc.m_Center.GetX() + flX;
+                    pOut[j * 2 + 1] = arc.m_Center.GetY() + flY;
+
+                    const float flNextX = flX * flStepCos - flY * flStepSin;
+                    flY = flX * flStepSin + flY * flStepCos;
+                    flX = flNextX;
+                }
+
+                const float flEndAngle = arc.m_flStartAngle + arc.m_flSweepAngle;
+                pOut[nSegments * 2] = arc.m_Center.GetX() + arc.m_flRadius * std::cos(flEndAngle);
+                pOut[nSegments * 2 + 1] = arc.m_Center.GetY() + arc.m_flRadius * std::sin(flEndAngle);
+            }
+        }
+
+        /**
+         * @brief Record every segment of a batch as lines, which the manager submits in one run.
+         * @param commandList The command list.
+         * @param batch The polylines.
+         * @param nColor The color of all lines.
+         * */
+        static void Record(CDrawCommandList &commandList, const SPolylineBatch &batch, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            const float *pXY = batch.m_vecXY.data();
+
+            for (size_t i = 0; i < batch.GetPolylineCount(); i++)
+            {
+                for (size_t j = batch.m_vecOffsets[i] + 1; j < batch.m_vecOffsets[i + 1]; j++)
+                    commandList.DrawLine(CVector2D<float>(pXY[j * 2 - 2], pXY[j * 2 - 1]), CVector2D<float>(pXY[j * 2], pXY[j * 2 + 1]), nColor);
+            }
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @file CDrawBatcher.h
+ * @brief Contains the declaration of the CDrawBatcher class.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "CDrawCommand.h"
+#include "CProfiler.h"
+#include "CRadixSort.h"
+
+namespace Cali
+{
+    /**
+     * @brief Counters of the last CDrawBatcher::Sort() call.
+     * */
+    struct SBatchStats
+    {
+        /**
+         * @brief Commands in the frame.
+         * */
+        size_t m_nCommands = 0;
+
+        /**
+         * @brief Backend draw calls the frame needs in submission order.
+         * */
+        size_t m_nDrawCallsBefore = 0;
+
+        /**
+         * @brief Backend draw calls the frame needs after sorting and merging.
+         * */
+        size_t m_nDrawCallsAfter = 0;
+    };
+
+    /**
+     * @class CDrawBatcher
+     * @brief Reorders a frame by sort key so compatible commands end up next to each other.
+     *
+     * Commands are radix sorted by SDrawCommand::m_nSortKey, see MakeDrawSortKey(). Layer and depth
+     * rank above the primitive type, so the only commands that change places are ones of equal layer
+     * and depth but different type; the sort is stable, so everything else keeps its submission order.
+     * Neighbouring compatible commands are then drawn with a single bulk backend call.
+     */
+    class CDrawBatcher
+    {
+    private:
+        CRadixSort<uint32_t> m_RadixSort;
+        std::vector<uint64_t> m_vecKeys = {};
+        std::vector<uint32_t> m_vecIndices = {};
+        std::vector<SDrawCommand> m_vecOutput = {};
+
+        SBatchStats m_Stats = {};
+
+    public:
+        /**
+         * @brief Check whether two commands can be drawn by the same backend call.
+         * @return True if the commands are compatible.
+         * */
+        static bool IsCompatible(const SDrawCommand &left, const SDrawCommand &right)
+        {
+            return left.m_nType == right.m_nType;
+        }
+
+        /**
+         * @brief Count the backend draw calls needed for a frame.
+         * @param vecCommands The frame.
+         * @return The number of runs of compatible commands.
+         * */
+        static size_t CountDrawCalls(const std::vector<SDrawCommand> &vecCommands)
+        {
+            size_t nDrawCalls = vecCommands.empty() ? 0 : 1;
+
+            for (size_t i = 1; i < vecCommands.size(); i++)
+            {
+                if (!IsCompatible(vecCommands[i - 1], vecCommands[i]))
+                    nDrawCalls++;
+            }
+
+            return nDrawCalls;
+        }
+
+        /**
+         * @brief Get the counters of the last Sort() call.
+         * @return The counters.
+         * */
+        const SBatchStats &GetStats() const { return m_Stats; }
+
+        /**
+         * @brief Stable sort a frame by sort key.
+         * @param vecCommands The frame, reordered in place.
+         * */
+        void Sort(std::vector<SDrawCommand> &vecCommands)
+        {
+            CALI_PROFILE_SCOPE("CDrawBatcher::Sort");
+
+            const size_t nCount = vecCommands.size();
+
+            m_Stats.m_nCommands = nCount;
+            m_Stats.m_nDrawCallsBefore = CountDrawCalls(vecCommands);
+
+            m_vecKeys.resize(nCount);
+            m_vecIndices.resize(nCount);
+            for (size_t i = 0; i < nCount; i++)
+            {
+                m_vecKeys[i] = vecCommands[i].m_nSortKey;
+                m_vecIndices[i] = static_cast<uint32_t>(i);
+            }
+
+            m_RadixSort.Sort(m_vecKeys, m_vecIndices);
+
+            m_vecOutput.resize(nCount);
+            for (size_t i = 0; i < nCount; i++)
+                m_vecOutput[i] = vecCommands[m_vecIndices[i]];
+
+            std::swap(vecCommands, m_vecOutput);
+
+            m_Stats.m_nDrawCallsAfter = CountDrawCalls(vecCommands);
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,533 @@
+#pragma once
+
+/**
+ * @file CDrawBenchmark.h
+ * @brief Contains the declaration of the CDrawBenchmark class and its synthetic workloads.
+ *
+ * The workloads record into a CDrawCommandList and are timed through CDrawManager::EndFrame(), so
+ * with CDrawManager_Null as the backend the results measure only the dispatch, batching and culling
+ * layers. Nothing here needs a GPU.
+ *
+ * RunDispatch() instead times immediate single primitive calls, to compare the statically dispatched
+ * CDrawManager<TBackend> with the virtual calls of CDynamicDrawManager.
+ *
+ * benchmark/main.cpp runs the standard workloads against the null and software backends; README.md
+ * has the build line.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+#include "CColor.h"
+#include "CDrawCommand.h"
+#include "CDrawManager.h"
+#include "CDynamicDrawManager.h"
+#include "CVector2D.h"
+#include "DrawManagers/CDrawManager_Null.h"
+
+namespace Cali
+{
+    /**
+     * @brief Result of a CDrawBenchmark run.
+     * */
+    struct SBenchmarkResult
+    {
+        const char *m_szName = "";
+
+        size_t m_nFrames = 0;
+        size_t m_nPrimitivesPerFrame = 0;
+
+        /**
+         * @brief Wall time spent recording and flushing, per frame.
+         * */
+        double m_flNsPerFrame = 0.0;
+
+        /**
+         * @brief Wall time per recorded primitive, i.e. per Draw* call on the command list.
+         * */
+        double m_flNsPerCall = 0.0;
+
+        double m_flPrimitivesPerSecond = 0.0;
+
+        /**
+         * @brief Heap allocations per frame, or -1 when no allocation counter was given.
+         * */
+        double m_flAllocationsPerFrame = -1.0;
+
+        /**
+         * @brief Backend calls per frame. Only known for CDrawManager_Null, 0 otherwise.
+         * */
+        double m_flDrawCallsPerFrame = 0.0;
+
+        /**
+         * @brief Checksum of the last frame the backend received. Only known for CDrawManager_Null.
+         * */
+        uint64_t m_nChecksum = 0;
+    };
+
+    /**
+     * @class CBenchmarkRandom
+     * @brief xorshift32 generator, so workloads are identical across platforms and standard libraries.
+     */
+    class CBenchmarkRandom
+    {
+    private:
+        uint32_t m_nState;
+
+    public:
+        explicit CBenchmarkRandom(uint32_t nSeed = 0x9E3779B9u) : m_nState(nSeed ? nSeed : 1) {}
+
+        uint32_t Next()
+        {
+            m_nState ^= m_nState << 13;
+            m_nState ^= m_nState >> 17;
+            m_nState ^= m_nState << 5;
+            return m_nState;
+        }
+
+        /**
+         * @brief Get a float in [flMin, flMax).
+         * */
+        float NextFloat(float flMin, float flMax)
+        {
+            return flMin + (flMax - flMin) * static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+
+    /**
+     * @class CParticleFieldWorkload
+     * @brief Many small moving circles recorded with one bulk call, as in a particle system.
+     */
+    class CParticleFieldWorkload
+    {
+    private:
+        std::vector<CVector2D<float>> m_vecPositions = {};
+        std::vector<CVector2D<float>> m_vecVelocities = {};
+        std::vector<float> m_vecRadii = {};
+        std::vector<CColorKey> m_vecColors = {};
+        float m_flWidth;
+        float m_flHeight;
+
+    public:
+        CParticleFieldWorkload(size_t nCount = 100000, float flWidth = 1920.0f, float flHeight = 1080.0f)
+            : m_flWidth(flWidth), m_flHeight(flHeight)
+        {
+            static const HEX_NUMBER s_nPalette[] = {static_cast<HEX_NUMBER>(0xFFFF8000), static_cast<HEX_NUMBER>(0xFFFFC040),
+                                                    static_cast<HEX_NUMBER>(0xC0FF4000), static_cast<HEX_NUMBER>(0x80FFFFFF)};
+
+            CBenchmarkRandom random;
+            m_vecPositions.reserve(nCount);
+            m_vecVelocities.reserve(nCount);
+            m_vecRadii.reserve(nCount);
+            m_vecColors.reserve(nCount);
+
+            // Scatter slightly past the viewport so culling has work to do.
+            for (size_t i = 0; i < nCount; i++)
+            {
+                m_vecPositions.emplace_back(random.NextFloat(-0.1f * flWidth, 1.1f * flWidth), random.NextFloat(-0.1f * flHeight, 1.1f * flHeight));
+                m_vecVelocities.emplace_back(random.NextFloat(-2.0f, 2.0f), random.NextFloat(-2.0f, 2.0f));
+                m_vecRadii.push_back(random.NextFloat(1.0f, 6.0f));
+                m_vecColors.emplace_back(s_nPalette[random.Next() % 4]);
+            }
+        }
+
+        const char *GetName() const { return "ParticleField"; }
+        size_t GetPrimitiveCount() const { return m_vecPositions.size(); }
+
+        /**
+         * @brief Advance the simulation. Not timed.
+         * */
+        void Update()
+        {
+            for (size_t i = 0; i < m_vecPositions.size(); i++)
+            {
+                CVector2D<float> &vecPosition = m_vecPositions[i];
+                float flX = vecPosition.GetX() + m_vecVelocities[i].GetX();
+                float flY = vecPosition.GetY() + m_vecVelocities[i].GetY();
+
+                if (flX < -0.1f * m_flWidth)
+                    flX += 1.2f * m_flWidth;
+                else if (flX > 1.1f * m_flWidth)
+                    flX -= 1.2f * m_flWidth;
+
+                if (flY < -0.1f * m_flHeight)
+                    flY += 1.2f * m_flHeight;
+                else if (flY > 1.1f * m_flHeight)
+                    flY -= 1.2f * m_flHeight;
+
+                vecPosition = CVector2D<float>(flX, flY);
+            }
+        }
+
+        void Record(CDrawCommandList &commandList) const
+        {
+            commandList.DrawCircles(m_vecPositions.data(), m_vecRadii.data(), m_vecColors.data(), m_vecPositions.size());
+        }
+    };
+
+    /**
+     * @class CWidgetWorkload
+     * @brief A grid of UI widgets, each a background, a border, a separator and an arrow on interleaved layers.
+     */
+    class CWidgetWorkload
+    {
+    private:
+        struct SWidget
+        {
+            CVector2D<float> m_vecMin;
+            CVector2D<float> m_vecMax;
+            uint32_t m_nBackground;
+            uint32_t m_nBorder;
+        };
+
+        std::vector<SWidget> m_vecWidgets = {};
+
+    public:
+        CWidgetWorkload(size_t nColumns = 64, size_t nRows = 64, float flWidth = 1920.0f, float flHeight = 1080.0f)
+        {
+            CBenchmarkRandom random;
+            const float flCellWidth = flWidth / static_cast<float>(nColumns);
+            const float flCellHeight = flHeight / static_cast<float>(nRows);
+
+            m_vecWidgets.reserve(nColumns * nRows);
+
+            for (size_t y = 0; y < nRows; y++)
+            {
+                for (size_t x = 0; x < nColumns; x++)
+                {
+                    SWidget &widget = m_vecWidgets.emplace_back();
+                    widget.m_vecMin = CVector2D<float>(static_cast<float>(x) * flCellWidth + 2.0f, static_cast<float>(y) * flCellHeight + 2.0f);
+                    widget.m_vecMax = CVector2D<float>(static_cast<float>(x + 1) * flCellWidth - 2.0f, static_cast<float>(y + 1) * flCellHeight - 2.0f);
+                    widget.m_nBackground = 0xFF202020u | (random.Next() & 0x000F0F0Fu);
+                    widget.m_nBorder = 0xFF808080u | (random.Next() & 0x003F3F3Fu);
+                }
+            }
+        }
+
+        const char *GetName() const { return "Widgets"; }
+        size_t GetPrimitiveCount() const { return m_vecWidgets.size() * 7; }
+
+        void Update() {}
+
+        void Record(CDrawCommandList &commandList) const
+        {
+            for (const SWidget &widget : m_vecWidgets)
+            {
+                const float flMinX = widget.m_vecMin.GetX();
+                const float flMinY = widget.m_vecMin.GetY();
+                const float flMaxX = widget.m_vecMax.GetX();
+                const float flMaxY = widget.m_vecMax.GetY();
+                const float flMidY = 0.5f * (flMinY + flMaxY);
+
+                commandList.SetLayer(0);
+                commandList.DrawRect(widget.m_vecMin, widget.m_vecMax, widget.m_nBackground);
+
+                commandList.SetLayer(1);
+                commandList.DrawLine(CVector2D<float>(flMinX, flMinY), CVector2D<float>(flMaxX, flMinY), widget.m_nBorder);
+                commandList.DrawLine(CVector2D<float>(flMaxX, flMinY), CVector2D<float>(flMaxX, flMaxY), widget.m_nBorder);
+                commandList.DrawLine(CVector2D<float>(flMaxX, flMaxY), CVector2D<float>(flMinX, flMaxY), widget.m_nBorder);
+                commandList.DrawLine(CVector2D<float>(flMinX, flMaxY), CVector2D<float>(flMinX, flMinY), widget.m_nBorder);
+                commandList.DrawLine(CVector2D<float>(flMinX, flMidY), CVector2D<float>(flMaxX - 8.0f, flMidY), widget.m_nBorder);
+
+                commandList.SetLayer(2);
+                commandList.DrawTriangle(CVector2D<float>(flMaxX - 7.0f, flMidY - 3.0f), CVector2D<float>(flMaxX - 1.0f, flMidY - 3.0f),
+                                         CVector2D<float>(flMaxX - 4.0f, flMidY + 3.0f), 0xFFFFFFFFu);
+            }
+
+            commandList.SetLayer(0);
+        }
+    };
+
+    /**
+     * @class CLineGraphWorkload
+     * @brief A line graph of many connected segments recorded with one bulk call.
+     */
+    class CLineGraphWorkload
+    {
+    private:
+        std::vector<CVector2D<float>> m_vecPoints = {};
+
+    public:
+        CLineGraphWorkload(size_t nSegments = 1000000, float flWidth = 1920.0f, float flHeight = 1080.0f)
+        {
+            CBenchmarkRandom random;
+            float flValue = 0.5f * flHeight;
+
+            m_vecPoints.reserve(nSegments + 1);
+
+            for (size_t i = 0; i <= nSegments; i++)
+            {
+                flValue += random.NextFloat(-4.0f, 4.0f);
+                flValue = flValue < 0.0f ? 0.0f : (flValue > flHeight ? flHeight : flValue);
+                m_vecPoints.emplace_back(flWidth * static_cast<float>(i) / static_cast<float>(nSegments), flValue);
+            }
+        }
+
+        const char *GetName() const { return "LineGraph"; }
+        size_t GetPrimitiveCount() const { return m_vecPoints.size() - 1; }
+
+        void Update() {}
+
+        void Record(CDrawCommandList &commandList) const
+        {
+            commandList.DrawLines(m_vecPoints.data(), m_vecPoints.data() + 1, nullptr, m_vecPoints.size() - 1);
+        }
+    };
+
+    /**
+     * @class CDrawBenchmark
+     * @brief Drives workloads through a CDrawManager and measures the throughput.
+     *
+     * A workload is any type with GetName(), GetPrimitiveCount(), Update() and Record(CDrawCommandList &).
+     * Only Record() and CDrawManager::EndFrame() are timed. In pipelined mode each frame waits for the
+     * render thread, so the time covers the whole frame rather than just the hand-off.
+     *
+     * The header cannot count heap allocations itself; pass a function returning a running count, e.g.
+     * one incremented by a replaced global operator new in the benchmark executable.
+     */
+    class CDrawBenchmark
+    {
+    public:
+        typedef size_t (*AllocationCounter_t)();
+
+    private:
+        size_t m_nFrames = 100;
+        size_t m_nWarmupFrames = 5;
+        AllocationCounter_t m_pfnAllocationCounter = nullptr;
+
+    public:
+        /**
+         * @brief Construct a benchmark.
+         * @param nFrames The number of timed frames per workload.
+         * @param nWarmupFrames The number of untimed frames before them, which let the command lists and arenas settle.
+         * */
+        explicit CDrawBenchmark(size_t nFrames = 100, size_t nWarmupFrames = 5) : m_nFrames(nFrames), m_nWarmupFrames(nWarmupFrames) {}
+
+        /**
+         * @brief Set the function used to report allocations per frame.
+         * @param pfnAllocationCounter A function returning the number of heap allocations so far, or nullptr.
+         * */
+        void SetAllocationCounter(AllocationCounter_t pfnAllocationCounter) { m_pfnAllocationCounter = pfnAllocationCounter; }
+
+        /**
+         * @brief Run one workload.
+         * @param manager An initialized manager.
+         * @param workload The workload.
+         * @return The result.
+         * */
+        template <typename TBackend, typename TWorkload>
+        SBenchmarkResult Run(CDrawManager<TBackend> &manager, TWorkload &workload) const
+        {
+            SBenchmarkResult result;
+            result.m_szName = workload.GetName();
+            result.m_nFrames = m_nFrames;
+            result.m_nPrimitivesPerFrame = workload.GetPrimitiveCount();
+
+            uint64_t nTotalNs = 0;
+            size_t nAllocations = 0;
+            uint64_t nDrawCalls = 0;
+
+            for (size_t nFrame = 0; nFrame < m_nWarmupFrames + m_nFrames; nFrame++)
+            {
+                const bool bTimed = nFrame >= m_nWarmupFrames;
+                workload.Update();
+
+                if constexpr (std::is_same_v<TBackend, CDrawManager_Null>)
+                {
+                    manager.WaitForRenderThread();
+                    manager.GetBackend().Reset();
+                }
+
+                const size_t nAllocationsBefore = m_pfnAllocationCounter ? m_pfnAllocationCounter() : 0;
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                CDrawCommandList *pCommandList = manager.BeginCommandList(0);
+                if (pCommandList)
+                    workload.Record(*pCommandList);
+
+                manager.EndFrame();
+                manager.WaitForRenderThread();
+
+                const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                const size_t nAllocationsAfter = m_pfnAllocationCounter ? m_pfnAllocationCounter() : 0;
+
+                if (!bTimed)
+                    continue;
+
+                nTotalNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                nAllocations += nAllocationsAfter - nAllocationsBefore;
+
+                if constexpr (std::is_same_v<TBackend, CDrawManager_Null>)
+                {
+                    nDrawCalls += manager.GetBackend().GetDrawCallCount();
+                    result.m_nChecksum = manager.GetBackend().GetChecksum();
+                }
+            }
+
+            if (m_nFrames == 0)
+                return result;
+
+            const double flFrames = static_cast<double>(m_nFrames);
+            const double flPrimitives = static_cast<double>(result.m_nPrimitivesPerFrame) * flFrames;
+
+            result.m_flNsPerFrame = static_cast<double>(nTotalNs) / flFrames;
+            result.m_flNsPerCall = flPrimitives > 0.0 ? static_cast<double>(nTotalNs) / flPrimitives : 0.0;
+            result.m_flPrimitivesPerSecond = nTotalNs ? flPrimitives * 1e9 / static_cast<double>(nTotalNs) : 0.0;
+            result.m_flDrawCallsPerFrame = static_cast<double>(nDrawCalls) / flFrames;
+
+            if (m_pfnAllocationCounter)
+                result.m_flAllocationsPerFrame = static_cast<double>(nAllocations) / flFrames;
+
+            return result;
+        }
+
+        /**
+         * @brief Time nPrimitives immediate DrawLine/DrawRect/DrawCircle/DrawTriangle calls per frame.
+         *
+         * The calls bypass the command lists and go straight to the backend, so with CDrawManager_Null the
+         * result is the per-primitive cost of the dispatch itself.
+         *
+         * @param manager An initialized CDrawManager<TBackend> or CDynamicDrawManager.
+         * @param szName The name of the result.
+         * @param nPrimitives The number of calls per frame, cycling through the four primitive types.
+         * @return The result.
+         * */
+        template <typename TManager>
+        SBenchmarkResult RunImmediate(TManager &manager, const char *szName, size_t nPrimitives = 100000) const
+        {
+            SBenchmarkResult result;
+            result.m_szName = szName;
+            result.m_nFrames = m_nFrames;
+            result.m_nPrimitivesPerFrame = nPrimitives;
+
+            CBenchmarkRandom random;
+            std::vector<CVector2D<float>> vecPoints;
+            vecPoints.reserve(nPrimitives * 3);
+
+            for (size_t i = 0; i < nPrimitives * 3; i++)
+                vecPoints.emplace_back(random.NextFloat(0.0f, 1920.0f), random.NextFloat(0.0f, 1080.0f));
+
+            uint64_t nTotalNs = 0;
+            size_t nAllocations = 0;
+
+            for (size_t nFrame = 0; nFrame < m_nWarmupFrames + m_nFrames; nFrame++)
+            {
+                if constexpr (std::is_same_v<TManager, CDrawManager<CDrawManager_Null>>)
+                    manager.GetBackend().Reset();
+
+                const size_t nAllocationsBefore = m_pfnAllocationCounter ? m_pfnAllocationCounter() : 0;
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                for (size_t i = 0; i < nPrimitives; i++)
+                {
+                    const CVector2D<float> *pPoints = &vecPoints[i * 3];
+
+                    switch (i & 3)
+                    {
+                    case DRAW_COMMAND_LINE:
+                        manager.DrawLine(pPoints[0], pPoints[1]);
+                        break;
+                    case DRAW_COMMAND_RECT:
+                        manager.DrawRect(pPoints[0], pPoints[1]);
+                        break;
+                    case DRAW_COMMAND_CIRCLE:
+                        manager.DrawCircle(pPoints[0], 4.0);
+                        break;
+                    default:
+                        manager.DrawTriangle(pPoints[0], pPoints[1], pPoints[2]);
+                        break;
+                    }
+                }
+
+                const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                const size_t nAllocationsAfter = m_pfnAllocationCounter ? m_pfnAllocationCounter() : 0;
+
+                if (nFrame < m_nWarmupFrames)
+                    continue;
+
+                nTotalNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                nAllocations += nAllocationsAfter - nAllocationsBefore;
+
+                if constexpr (std::is_same_v<TManager, CDrawManager<CDrawManager_Null>>)
+                    result.m_nChecksum = manager.GetBackend().GetChecksum();
+            }
+
+            if (m_nFrames == 0)
+                return result;
+
+            const double flFrames = static_cast<double>(m_nFrames);
+            const double flPrimitives = static_cast<double>(nPrimitives) * flFrames;
+
+            result.m_flNsPerFrame = static_cast<double>(nTotalNs) / flFrames;
+            result.m_flNsPerCall = flPrimitives > 0.0 ? static_cast<double>(nTotalNs) / flPrimitives : 0.0;
+            result.m_flPrimitivesPerSecond = nTotalNs ? flPrimitives * 1e9 / static_cast<double>(nTotalNs) : 0.0;
+            result.m_flDrawCallsPerFrame = static_cast<double>(nPrimitives);
+
+            if (m_pfnAllocationCounter)
+                result.m_flAllocationsPerFrame = static_cast<double>(nAllocations) / flFrames;
+
+            return result;
+        }
+
+        /**
+         * @brief Compare the per-primitive cost of static and dynamic dispatch over the same backend type.
+         * @param staticManager An initialized CDrawManager<TBackend>.
+         * @param dynamicManager An initialized CDynamicDrawManager, e.g. from CDynamicDrawManager::Create<TBackend>().
+         * @param nPrimitives The number of calls per frame.
+         * @return The static result, then the dynamic one.
+         * */
+        template <typename TBackend>
+        std::vector<SBenchmarkResult> RunDispatch(CDrawManager<TBackend> &staticManager, CDynamicDrawManager &dynamicManager,
+                                                  size_t nPrimitives = 100000) const
+        {
+            std::vector<SBenchmarkResult> vecResults;
+            vecResults.push_back(RunImmediate(staticManager, "StaticDispatch", nPrimitives));
+            vecResults.push_back(RunImmediate(dynamicManager, "DynamicDispatch", nPrimitives));
+            return vecResults;
+        }
+
+        /**
+         * @brief Run the particle field, widget and 1M segment line graph workloads.
+         * @param manager An initialized manager.
+         * @return One result per workload.
+         * */
+        template <typename TBackend>
+        std::vector<SBenchmarkResult> RunSuite(CDrawManager<TBackend> &manager) const
+        {
+            std::vector<SBenchmarkResult> vecResults;
+
+            CParticleFieldWorkload particleField;
+            vecResults.push_back(Run(manager, particleField));
+
+            CWidgetWorkload widgets;
+            vecResults.push_back(Run(manager, widgets));
+
+            CLineGraphWorkload lineGraph;
+            vecResults.push_back(Run(manager, lineGraph));
+
+            return vecResults;
+        }
+
+        /**
+         * @brief Print results as a table.
+         * @param vecResults The results.
+         * @param pFile The output, stdout by default.
+         * */
+        static void Print(const std::vector<SBenchmarkResult> &vecResults, FILE *pFile = stdout)
+        {
+            std::fprintf(pFile, "%-16s %10s %12s %10s %14s %12s %12s %18s\n", "workload", "frames", "prims/frame", "ns/call",
+                         "prims/s", "calls/frame", "allocs/frame", "checksum");
+
+            for (const SBenchmarkResult &result : vecResults)
+            {
+                std::fprintf(pFile, "%-16s %10zu %12zu %10.2f %14.0f %12.1f %12.1f %18llx\n", result.m_szName, result.m_nFrames,
+                             result.m_nPrimitivesPerFrame, result.m_flNsPerCall, result.m_flPrimitivesPerSecond,
+                             result.m_flDrawCallsPerFrame, result.m_flAllocationsPerFrame, static_cast<unsigned long long>(result.m_nChecksum));
+            }
+        }
+    };
+
+} // namespace Cali
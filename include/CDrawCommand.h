@@ -0,0 +1,659 @@
+#pragma once
+
+/**
+ * @file CDrawCommand.h
+ * @brief Contains the declaration of the SDrawCommand and SDrawFrame structs and the CDrawCommandList class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CAffine2D.h"
+#include "CColor.h"
+#include "CFrameArena.h"
+#include "Constants.h"
+#include "CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @brief The primitive a SDrawCommand draws.
+     * */
+    enum DrawCommandType_e : uint8_t
+    {
+        DRAW_COMMAND_LINE = 0,
+        DRAW_COMMAND_RECT,
+        DRAW_COMMAND_CIRCLE,
+        DRAW_COMMAND_TRIANGLE,
+        DRAW_COMMAND_INDEXED_TRIANGLES
+    };
+
+    /**
+     * @brief Build the key commands are sorted by when batching is enabled.
+     *
+     * From the most to the least significant bits: layer (12 bits), depth (16 bits) and primitive
+     * type (4 bits); the low 32 bits are zero. Commands on a lower layer, then a lower depth, are
+     * always drawn first. Sorting only regroups commands of equal layer and depth by type, so give
+     * primitives that overlap and must keep their order different depths or layers.
+     *
+     * The color is not part of the key: CDrawBatcher::IsCompatible() merges on type alone.
+     *
+     * @param nLayer The layer, only the low 12 bits are used.
+     * @param nDepth The depth within the layer.
+     * @param nType The primitive type.
+     * @return The sort key.
+     * */
+    /**
+     * @brief Bit positions of the sort key fields, see MakeDrawSortKey().
+     * */
+    inline constexpr unsigned DRAW_SORT_KEY_LAYER_SHIFT = 52;
+    inline constexpr unsigned DRAW_SORT_KEY_DEPTH_SHIFT = 36;
+    inline constexpr unsigned DRAW_SORT_KEY_TYPE_SHIFT = 32;
+
+    /**
+     * @brief The primitive type bits of a sort key.
+     * */
+    inline constexpr uint64_t DRAW_SORT_KEY_TYPE_MASK = static_cast<uint64_t>(0xF) << DRAW_SORT_KEY_TYPE_SHIFT;
+
+    inline uint64_t MakeDrawSortKey(uint16_t nLayer, uint16_t nDepth, DrawCommandType_e nType)
+    {
+        return static_cast<uint64_t>(nLayer & 0xFFF) << DRAW_SORT_KEY_LAYER_SHIFT | static_cast<uint64_t>(nDepth) << DRAW_SORT_KEY_DEPTH_SHIFT |
+               static_cast<uint64_t>(nType & 0xF) << DRAW_SORT_KEY_TYPE_SHIFT;
+    }
+
+    /**
+     * @brief Replace the primitive type of a sort key, keeping its layer and depth.
+     * */
+    inline uint64_t SetDrawSortKeyType(uint64_t nSortKey, DrawCommandType_e nType)
+    {
+        return (nSortKey & ~DRAW_SORT_KEY_TYPE_MASK) | static_cast<uint64_t>(nType & 0xF) << DRAW_SORT_KEY_TYPE_SHIFT;
+    }
+
+    /**
+     * @brief A single recorded draw call.
+     *
+     * Lines and rects use the first two points, triangles all three and circles
+     * the first point together with the radius. The color is packed as 0xAARRGGBB.
+     *
+     * An indexed triangle batch keeps its bounding box in the first two points and draws the triangles
+     * of SDrawGeometry::m_vecBatches[m_nBatch] of the list or frame holding it.
+     * */
+    struct SDrawCommand
+    {
+        DrawCommandType_e m_nType = DRAW_COMMAND_LINE;
+        CVector2D<float> m_Points[3];
+        float m_flRadius = 0.0f;
+        uint32_t m_nColor = CONST_COLOR_DEFAULT;
+        uint32_t m_nBatch = 0;
+        uint64_t m_nSortKey = 0;
+    };
+
+    /**
+     * @brief The vertex and index ranges of one DRAW_COMMAND_INDEXED_TRIANGLES command.
+     * */
+    struct SDrawBatch
+    {
+        uint32_t m_nFirstVertex = 0;
+        uint32_t m_nVertexCount = 0;
+        uint32_t m_nFirstIndex = 0;
+        uint32_t m_nTriangleCount = 0;
+    };
+
+    /**
+     * @brief Vertices and indices of the indexed triangle batches of a command list or frame.
+     * Indices point into m_vecVertices directly, so the triangles of several batches can be drawn in one call.
+     * */
+    struct SDrawGeometry
+    {
+        std::vector<CVector2D<float>> m_vecVertices = {};
+        std::vector<uint32_t> m_vecIndices = {};
+        std::vector<SDrawBatch> m_vecBatches = {};
+
+        /**
+         * @brief Remove all batches while keeping the allocated storage.
+         * */
+        void Clear()
+        {
+            m_vecVertices.clear();
+            m_vecIndices.clear();
+            m_vecBatches.clear();
+        }
+    };
+
+    /**
+     * @brief A merged frame: its commands and the geometry their indexed triangle batches refer to.
+     * */
+    struct SDrawFrame
+    {
+        std::vector<SDrawCommand> m_vecCommands = {};
+        SDrawGeometry m_Geometry = {};
+
+        void Clear()
+        {
+            m_vecCommands.clear();
+            m_Geometry.Clear();
+        }
+    };
+
+    /**
+     * @brief Compute the bounding box of nCount vertices.
+     * */
+    inline void ComputeDrawBounds(const CVector2D<float> *pVertices, size_t nCount, CVector2D<float> &vecMin, CVector2D<float> &vecMax)
+    {
+        float flMinX = pVertices[0].GetX(), flMinY = pVertices[0].GetY();
+        float flMaxX = flMinX, flMaxY = flMinY;
+
+        for (size_t i = 1; i < nCount; i++)
+        {
+            flMinX = std::min(flMinX, pVertices[i].GetX());
+            flMinY = std::min(flMinY, pVertices[i].GetY());
+            flMaxX = std::max(flMaxX, pVertices[i].GetX());
+            flMaxY = std::max(flMaxY, pVertices[i].GetY());
+        }
+
+        vecMin = CVector2D<float>(flMinX, flMinY);
+        vecMax = CVector2D<float>(flMaxX, flMaxY);
+    }
+
+    /**
+     * @brief Copy the batch of an indexed triangle command into another geometry and transform its vertices.
+     * @param command The command, pointed at the copy and given its transformed bounds.
+     * @param source The geometry the command refers to.
+     * @param target The geometry to append to, not source.
+     * */
+    inline void AppendDrawBatch(SDrawCommand &command, const SDrawGeometry &source, const CAffine2D<float> &transform, SDrawGeometry &target)
+    {
+        const SDrawBatch &batch = source.m_vecBatches[command.m_nBatch];
+
+        SDrawBatch copy = batch;
+        copy.m_nFirstVertex = static_cast<uint32_t>(target.m_vecVertices.size());
+        copy.m_nFirstIndex = static_cast<uint32_t>(target.m_vecIndices.size());
+
+        const CVector2D<float> *pVertices = source.m_vecVertices.data() + batch.m_nFirstVertex;
+        target.m_vecVertices.resize(target.m_vecVertices.size() + batch.m_nVertexCount);
+        CVector2D<float> *pTransformed = target.m_vecVertices.data() + copy.m_nFirstVertex;
+
+        if (transform.IsIdentity())
+            std::copy(pVertices, pVertices + batch.m_nVertexCount, pTransformed);
+        else
+            transform.Apply(pVertices, pTransformed, batch.m_nVertexCount);
+
+        // Indices are rebased by unsigned wrap-around, which also covers batches moving to lower offsets.
+        const uint32_t nRebase = copy.m_nFirstVertex - batch.m_nFirstVertex;
+        const uint32_t *pIndices = source.m_vecIndices.data() + batch.m_nFirstIndex;
+
+        for (size_t i = 0; i < static_cast<size_t>(batch.m_nTriangleCount) * 3; i++)
+            target.m_vecIndices.push_back(pIndices[i] + nRebase);
+
+        command.m_nBatch = static_cast<uint32_t>(target.m_vecBatches.size());
+        target.m_vecBatches.push_back(copy);
+        ComputeDrawBounds(pTransformed, copy.m_nVertexCount, command.m_Points[0], command.m_Points[1]);
+    }
+
+    /**
+     * @brief Copy a frame's commands, expanding every indexed triangle batch into triangle commands.
+     * Used where a frame leaves the manager without its geometry, e.g. for a CDrawStreamWriter.
+     * @param frame The frame.
+     * @param vecCommands Receives the expanded commands.
+     * */
+    inline void ExpandIndexedTriangles(const SDrawFrame &frame, std::vector<SDrawCommand> &vecCommands)
+    {
+        vecCommands.clear();
+
+        for (const SDrawCommand &command : frame.m_vecCommands)
+        {
+            if (command.m_nType != DRAW_COMMAND_INDEXED_TRIANGLES)
+            {
+                vecCommands.push_back(command);
+                continue;
+            }
+
+            const SDrawBatch &batch = frame.m_Geometry.m_vecBatches[command.m_nBatch];
+            const uint32_t *pIndices = frame.m_Geometry.m_vecIndices.data() + batch.m_nFirstIndex;
+
+            for (size_t i = 0; i < batch.m_nTriangleCount; i++)
+            {
+                SDrawCommand &triangle = vecCommands.emplace_back(command);
+                triangle.m_nType = DRAW_COMMAND_TRIANGLE;
+                triangle.m_nBatch = 0;
+                triangle.m_nSortKey = SetDrawSortKeyType(command.m_nSortKey, DRAW_COMMAND_TRIANGLE);
+
+                for (size_t j = 0; j < 3; j++)
+                    triangle.m_Points[j] = frame.m_Geometry.m_vecVertices[pIndices[i * 3 + j]];
+            }
+        }
+    }
+
+    /**
+     * @brief Append transformed copies of recorded commands to a frame.
+     *
+     * The points of all commands are gathered into vecPoints and transformed by a single batched
+     * CAffine2D::Apply() call before the commands are written back. Indexed triangle batches are copied
+     * into the frame's geometry and their vertices transformed there, see AppendDrawBatch().
+     *
+     * Under a rotation or shear a rect is no longer axis-aligned, so it is appended as the two triangles
+     * covering it, keeping its layer, color and depth. Circles scale their radius by the square root of
+     * the area scale, which is exact for rotations and uniform scales; under a non-uniform scale or a
+     * shear they stay circles of the same area instead of becoming ellipses.
+     *
+     * @param geometry The geometry the indexed triangle batches among pCommands refer to.
+     * @param vecPoints Scratch storage for the gathered points, kept by the caller between calls.
+     * */
+    inline void AppendTransformedDrawCommands(const SDrawCommand *pCommands, size_t nCount, const SDrawGeometry &geometry,
+                                              const CAffine2D<float> &transform, SDrawFrame &frame, std::vector<CVector2D<float>> &vecPoints)
+    {
+        std::vector<SDrawCommand> &vecFrame = frame.m_vecCommands;
+
+        if (transform.IsIdentity())
+        {
+            const size_t nFirst = vecFrame.size();
+            vecFrame.insert(vecFrame.end(), pCommands, pCommands + nCount);
+
+            if (!geometry.m_vecBatches.empty())
+            {
+                for (size_t i = nFirst; i < vecFrame.size(); i++)
+                {
+                    if (vecFrame[i].m_nType == DRAW_COMMAND_INDEXED_TRIANGLES)
+                        AppendDrawBatch(vecFrame[i], geometry, transform, frame.m_Geometry);
+                }
+            }
+
+            return;
+        }
+
+        const float flRadiusScale = std::sqrt(std::fabs(transform.GetDeterminant()));
+        const bool bAxisAligned = transform.IsAxisAligned();
+
+        vecPoints.clear();
+
+        for (size_t i = 0; i < nCount; i++)
+        {
+            const SDrawCommand &command = pCommands[i];
+
+            switch (command.m_nType)
+            {
+            case DRAW_COMMAND_LINE:
+                vecPoints.insert(vecPoints.end(), command.m_Points, command.m_Points + 2);
+                break;
+            case DRAW_COMMAND_RECT:
+            {
+                const CVector2D<float> &vecMin = command.m_Points[0];
+                const CVector2D<float> &vecMax = command.m_Points[1];
+                vecPoints.push_back(vecMin);
+                vecPoints.push_back(vecMax);
+
+                if (!bAxisAligned)
+                {
+                    vecPoints.emplace_back(vecMax.GetX(), vecMin.GetY());
+                    vecPoints.emplace_back(vecMin.GetX(), vecMax.GetY());
+                }
+                break;
+            }
+            case DRAW_COMMAND_CIRCLE:
+                vecPoints.push_back(command.m_Points[0]);
+                break;
+            case DRAW_COMMAND_TRIANGLE:
+                vecPoints.insert(vecPoints.end(), command.m_Points, command.m_Points + 3);
+                break;
+            case DRAW_COMMAND_INDEXED_TRIANGLES:
+                break;
+            }
+        }
+
+        transform.Apply(vecPoints.data(), vecPoints.data(), vecPoints.size());
+
+        const CVector2D<float> *pPoint = vecPoints.data();
+
+        for (size_t i = 0; i < nCount; i++)
+        {
+            SDrawCommand &command = vecFrame.emplace_back(pCommands[i]);
+
+            switch (command.m_nType)
+            {
+            case DRAW_COMMAND_LINE:
+                command.m_Points[0] = pPoint[0];
+                command.m_Points[1] = pPoint[1];
+                pPoint += 2;
+                break;
+            case DRAW_COMMAND_RECT:
+            {
+                const CVector2D<float> vecA = pPoint[0];
+                const CVector2D<float> vecB = pPoint[1];
+
+                if (bAxisAligned)
+                {
+                    // A flip can swap the corners.
+                    command.m_Points[0] = CVector2D<float>(std::min(vecA.GetX(), vecB.GetX()), std::min(vecA.GetY(), vecB.GetY()));
+                    command.m_Points[1] = CVector2D<float>(std::max(vecA.GetX(), vecB.GetX()), std::max(vecA.GetY(), vecB.GetY()));
+                    pPoint += 2;
+                    break;
+                }
+
+                const CVector2D<float> vecTopLeft = vecA;
+                const CVector2D<float> vecBottomRight = vecB;
+                const CVector2D<float> vecTopRight = pPoint[2];
+                const CVector2D<float> vecBottomLeft = pPoint[3];
+                pPoint += 4;
+
+                command.m_nType = DRAW_COMMAND_TRIANGLE;
+                command.m_nSortKey = SetDrawSortKeyType(command.m_nSortKey, DRAW_COMMAND_TRIANGLE);
+                command.m_Points[0] = vecTopLeft;
+                command.m_Points[1] = vecTopRight;
+                command.m_Points[2] = vecBottomLeft;
+
+                SDrawCommand &second = vecFrame.emplace_back(command);
+                second.m_Points[0] = vecBottomLeft;
+                second.m_Points[1] = vecTopRight;
+                second.m_Points[2] = vecBottomRight;
+                break;
+            }
+            case DRAW_COMMAND_CIRCLE:
+                command.m_Points[0] = *pPoint++;
+                command.m_flRadius *= flRadiusScale;
+                break;
+            case DRAW_COMMAND_TRIANGLE:
+                command.m_Points[0] = pPoint[0];
+                command.m_Points[1] = pPoint[1];
+                command.m_Points[2] = pPoint[2];
+                pPoint += 3;
+                break;
+            case DRAW_COMMAND_INDEXED_TRIANGLES:
+                AppendDrawBatch(command, geometry, transform, frame.m_Geometry);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief The transform of the commands of a CDrawCommandList from m_nFirstCommand up to the next run.
+     * */
+    struct SDrawTransformRun
+    {
+        uint32_t m_nFirstCommand = 0;
+        CAffine2D<float> m_Transform;
+    };
+
+    /**
+     * @class CDrawCommandList
+     * @brief A list of draw commands recorded by a single thread.
+     *
+     * A list is owned by exactly one thread for the duration of a frame, so recording
+     * into it needs no synchronisation. The list keeps its storage between frames.
+     *
+     * Each list also owns a CFrameArena for transient geometry the recording thread builds during
+     * the frame. The arena is reset together with the list.
+     *
+     * PushTransform() and PopTransform() maintain a transform stack. Commands are recorded untransformed
+     * and the list only notes where the current transform changes, so recording costs nothing extra;
+     * CDrawManager applies the transforms in one pass while merging the frame, see
+     * AppendTransformedDrawCommands().
+     * */
+    class CDrawCommandList
+    {
+    private:
+        /**
+         * @brief Key that decides where this list is merged into the frame.
+         * */
+        uint32_t m_nOrder = 0;
+
+        std::vector<SDrawCommand> m_vecCommands = {};
+        SDrawGeometry m_Geometry = {};
+
+        uint16_t m_nLayer = 0;
+        uint16_t m_nDepth = 0;
+
+        std::vector<CAffine2D<float>> m_vecTransformStack = {};
+        std::vector<SDrawTransformRun> m_vecTransformRuns = {};
+
+        CFrameArena m_Arena;
+        CFrameArenaResource m_ArenaResource{m_Arena};
+
+        SDrawCommand &AddCommand(DrawCommandType_e nType, uint32_t nColor)
+        {
+            SDrawCommand &command = m_vecCommands.emplace_back();
+            command.m_nType = nType;
+            command.m_nColor = nColor;
+            command.m_nSortKey = MakeDrawSortKey(m_nLayer, m_nDepth, nType);
+            return command;
+        }
+
+        /**
+         * @brief Note that the commands recorded from now on use the current transform.
+         * */
+        void BeginTransformRun()
+        {
+            const uint32_t nFirstCommand = static_cast<uint32_t>(m_vecCommands.size());
+            const CAffine2D<float> transform = GetTransform();
+
+            if (!m_vecTransformRuns.empty() && m_vecTransformRuns.back().m_nFirstCommand == nFirstCommand)
+                m_vecTransformRuns.back().m_Transform = transform;
+            else if (m_vecTransformRuns.empty() ? !transform.IsIdentity() : m_vecTransformRuns.back().m_Transform != transform)
+                m_vecTransformRuns.push_back({nFirstCommand, transform});
+        }
+
+    public:
+        /**
+         * @brief Get the merge key of this list.
+         * @return The merge key.
+         * */
+        uint32_t GetOrder() const { return m_nOrder; }
+
+        /**
+         * @brief Set the merge key of this list.
+         * Lists are merged in ascending order at frame end.
+         * @param nOrder The merge key.
+         * */
+        void SetOrder(uint32_t nOrder) { m_nOrder = nOrder; }
+
+        /**
+         * @brief Get the recorded commands in submission order.
+         * @return The recorded commands.
+         * */
+        const std::vector<SDrawCommand> &GetCommands() const { return m_vecCommands; }
+
+        /**
+         * @brief Get the vertices and indices of the recorded indexed triangle batches.
+         * @return The geometry, in the untransformed coordinates of the commands.
+         * */
+        const SDrawGeometry &GetGeometry() const { return m_Geometry; }
+
+        /**
+         * @brief Remove all commands while keeping the allocated storage, and reset layer, depth, transforms and arena.
+         * */
+        void Clear()
+        {
+            m_vecCommands.clear();
+            m_Geometry.Clear();
+            m_nLayer = 0;
+            m_nDepth = 0;
+            m_vecTransformStack.clear();
+            m_vecTransformRuns.clear();
+            m_Arena.Reset();
+        }
+
+        /**
+         * @brief Get the arena of the recording thread, valid until the list is cleared.
+         * @return The arena.
+         * */
+        CFrameArena &GetArena() { return m_Arena; }
+        const CFrameArena &GetArena() const { return m_Arena; }
+
+        /**
+         * @brief Get a std::pmr::memory_resource allocating from GetArena().
+         * @return The memory resource.
+         * */
+        std::pmr::memory_resource *GetArenaResource() { return &m_ArenaResource; }
+
+        /**
+         * @brief Set the layer of the commands recorded from now on, see MakeDrawSortKey().
+         * @param nLayer The layer.
+         * */
+        void SetLayer(uint16_t nLayer) { m_nLayer = nLayer; }
+
+        /**
+         * @brief Set the depth of the commands recorded from now on, see MakeDrawSortKey().
+         * @param nDepth The depth within the layer.
+         * */
+        void SetDepth(uint16_t nDepth) { m_nDepth = nDepth; }
+
+        /**
+         * @brief Get the transform of the commands recorded from now on.
+         * @return The top of the transform stack, or the identity if it is empty.
+         * */
+        CAffine2D<float> GetTransform() const { return m_vecTransformStack.empty() ? CAffine2D<float>() : m_vecTransformStack.back(); }
+
+        /**
+         * @brief Push a transform that applies to the commands recorded from now on, before the current one.
+         * Under a rotation or shear rects are drawn as two triangles. Circles stay circles: under a
+         * non-uniform scale or a shear their radius is scaled by sqrt(|det|).
+         * @param transform The transform, in the coordinates of the current transform.
+         * */
+        void PushTransform(const CAffine2D<float> &transform)
+        {
+            m_vecTransformStack.push_back(GetTransform() * transform);
+            BeginTransformRun();
+        }
+
+        /**
+         * @brief Restore the transform active before the last PushTransform(). Does nothing if the stack is empty.
+         * */
+        void PopTransform()
+        {
+            if (m_vecTransformStack.empty())
+                return;
+
+            m_vecTransformStack.pop_back();
+            BeginTransformRun();
+        }
+
+        /**
+         * @brief Get where the transform changes; commands before the first run are untransformed.
+         * @return The runs, ascending by first command.
+         * */
+        const std::vector<SDrawTransformRun> &GetTransformRuns() const { return m_vecTransformRuns; }
+
+        template <typename T = float>
+        void DrawLine(CVector2D<T> v1, CVector2D<T> v2, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            SDrawCommand &command = AddCommand(DRAW_COMMAND_LINE, nColor);
+            command.m_Points[0] = ToFloat(v1);
+            command.m_Points[1] = ToFloat(v2);
+        }
+
+        template <typename T = float>
+        void DrawRect(CVector2D<T> v1, CVector2D<T> v2, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            SDrawCommand &command = AddCommand(DRAW_COMMAND_RECT, nColor);
+            command.m_Points[0] = ToFloat(v1);
+            command.m_Points[1] = ToFloat(v2);
+        }
+
+        template <typename T = float>
+        void DrawCircle(CVector2D<T> v1, double radius, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            SDrawCommand &command = AddCommand(DRAW_COMMAND_CIRCLE, nColor);
+            command.m_Points[0] = ToFloat(v1);
+            command.m_flRadius = static_cast<float>(radius);
+        }
+
+        template <typename T = float>
+        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            SDrawCommand &command = AddCommand(DRAW_COMMAND_TRIANGLE, nColor);
+            command.m_Points[0] = ToFloat(v1);
+            command.m_Points[1] = ToFloat(v2);
+            command.m_Points[2] = ToFloat(v3);
+        }
+
+        /**
+         * @brief Record nCount lines from pStart[i] to pEnd[i].
+         * @param pColors One color per line, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const CColorKey *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                DrawLine(pStart[i], pEnd[i], GetColor(pColors, i));
+        }
+
+        /**
+         * @brief Record nCount rects spanning pMin[i] to pMax[i].
+         * @param pColors One color per rect, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const CColorKey *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                DrawRect(pMin[i], pMax[i], GetColor(pColors, i));
+        }
+
+        /**
+         * @brief Record nCount circles around pCenters[i] with pRadii[i].
+         * @param pColors One color per circle, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const CColorKey *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                DrawCircle(pCenters[i], pRadii[i], GetColor(pColors, i));
+        }
+
+        /**
+         * @brief Record nCount triangles, three consecutive vertices each.
+         * @param pColors One color per triangle, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const CColorKey *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                DrawTriangle(pVertices[i * 3], pVertices[i * 3 + 1], pVertices[i * 3 + 2], GetColor(pColors, i));
+        }
+
+        /**
+         * @brief Record a connected polyline as nCount - 1 lines in one color.
+         * */
+        template <typename T = float>
+        void DrawPolyline(const CVector2D<T> *pPoints, size_t nCount, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            for (size_t i = 1; i < nCount; i++)
+                DrawLine(pPoints[i - 1], pPoints[i], nColor);
+        }
+
+        /**
+         * @brief Record an indexed triangle batch, e.g. a STessellation, in one color as a single command.
+         * The referenced vertices and the indices are copied into the list, see GetGeometry().
+         * @param pIndices Three indices into pVertices per triangle.
+         * @param nCount The number of triangles.
+         * */
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, size_t nCount, uint32_t nColor = CONST_COLOR_DEFAULT)
+        {
+            if (nCount == 0)
+                return;
+
+            // Only the referenced range of pVertices is copied, its size is not passed in.
+            const auto [pMinIndex, pMaxIndex] = std::minmax_element(pIndices, pIndices + nCount * 3);
+
+            SDrawBatch batch;
+            batch.m_nFirstVertex = static_cast<uint32_t>(m_Geometry.m_vecVertices.size());
+            batch.m_nVertexCount = *pMaxIndex - *pMinIndex + 1;
+            batch.m_nFirstIndex = static_cast<uint32_t>(m_Geometry.m_vecIndices.size());
+            batch.m_nTriangleCount = static_cast<uint32_t>(nCount);
+
+            for (uint32_t i = 0; i < batch.m_nVertexCount; i++)
+                m_Geometry.m_vecVertices.push_back(ToFloat(pVertices[*pMinIndex + i]));
+
+            const uint32_t nRebase = batch.m_nFirstVertex - *pMinIndex;
+            for (size_t i = 0; i < nCount * 3; i++)
+                m_Geometry.m_vecIndices.push_back(pIndices[i] + nRebase);
+
+            SDrawCommand &command = AddCommand(DRAW_COMMAND_INDEXED_TRIANGLES, nColor);
+            command.m_nBatch = static_cast<uint32_t>(m_Geometry.m_vecBatches.size());
+            m_Geometry.m_vecBatches.push_back(batch);
+            ComputeDrawBounds(m_Geometry.m_vecVertices.data() + batch.m_nFirstVertex, batch.m_nVertexCount, command.m_Points[0], command.m_Points[1]);
+        }
+    };
+
+} // namespace Cali
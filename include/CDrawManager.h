@@ -1,40 +1,737 @@
 #pragma once
 
+/**
+ * @file CDrawManager.h
+ * @brief Contains the declaration of the CDrawManager class.
+ */
+
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <mutex>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "CAffine2D.h"
+#include "CColor.h"
+#include "CDrawBatcher.h"
+#include "CDrawCommand.h"
+#include "CDrawStream.h"
+#include "CFrameArena.h"
+#include "CFrameRing.h"
+#include "CProfiler.h"
+#include "CViewportCuller.h"
 #include "CVector2D.h"
 
 namespace Cali
 {
+    /**
+     * @class CDrawManager
+     * @brief Statically dispatched draw manager.
+     *
+     * The backend is a template parameter, so every draw call resolves at compile time
+     * and inlines straight into the backend without a per-call branch or indirection.
+     * Use CDynamicDrawManager when the backend has to be chosen at runtime.
+     *
+     * Worker threads record into their own CDrawCommandList obtained from BeginCommandList(),
+     * which takes no lock. EndFrame() merges the lists by their order key and submits them,
+     * so the final draw order does not depend on thread scheduling.
+     *
+     * With SetPipelineDepth() the manager runs the backend on a dedicated render thread: EndFrame()
+     * hands the merged frame to a ring of up to MAX_FRAME_BUFFERS buffers and returns, so the next
+     * frame is recorded while the previous one renders. In that mode the backend belongs to the
+     * render thread, so the immediate Draw* calls are recorded instead and drawn ahead of the command
+     * lists by the next EndFrame().
+     *
+     * The bulk Draw* calls take contiguous arrays and hand them to the backend in one call, and
+     * recorded frames are replayed the same way, one bulk call per run of equal primitives. Indexed
+     * triangle batches stay indexed up to the backend's DrawIndexedTriangles(); the merged frame owns a
+     * copy of their vertices and indices, see SDrawFrame.
+     *
+     * Once SetViewport() is called, recorded frames pass through a CViewportCuller before they
+     * reach the backend, see GetCullStats() for what it removed. With SetBatchSorting() frames are
+     * also sorted by each command's sort key so compatible commands share a draw call, see GetBatchStats().
+     *
+     * Transient geometry can be allocated from GetFrameArena() on the thread calling EndFrame() and
+     * from CDrawCommandList::GetArena() on recording threads; both are reset by EndFrame().
+     *
+     * SetTransform() sets a view transform, e.g. pan and zoom, for everything recorded into command lists.
+     * EndFrame() composes it with each list's own transform stack and transforms the merged frame in
+     * one pass, so recording never multiplies points per call.
+     *
+     * SetCaptureStream() records every merged frame into a draw stream, and Replay() pushes a captured
+     * stream back through the manager, so real workloads can be profiled offline against any backend.
+     *
+     * @tparam TBackend The backend type, derived from CDrawBackend, e.g. CDrawManager_D3D9.
+     */
+    template <typename TBackend>
     class CDrawManager
     {
     public:
-        enum ManagerType_e
-        {
-            D3D9 = 0,
-            D3D11
-        };
+        /**
+         * @brief Maximum number of command lists that can be recorded per frame.
+         * */
+        static constexpr size_t MAX_COMMAND_LISTS = 64;
+
+        /**
+         * @brief Maximum number of frames the render thread can lag behind.
+         * */
+        static constexpr size_t MAX_FRAME_BUFFERS = 3;
 
     private:
-        ManagerType_e m_nManagerType;
-        std::mutex m_Mutex;
+        TBackend m_Backend;
         std::atomic<bool> m_bInitialized = false;
 
+        std::array<CDrawCommandList, MAX_COMMAND_LISTS> m_CommandLists;
+        std::atomic<size_t> m_nCommandListCount = 0;
+        std::array<const CDrawCommandList *, MAX_COMMAND_LISTS> m_SortedCommandLists = {};
+
+        size_t m_nPipelineDepth = 0;
+        CFrameRing<SDrawFrame, MAX_FRAME_BUFFERS> m_FrameRing;
+        std::thread m_RenderThread;
+
+        /**
+         * @brief Merged frame of the synchronous mode.
+         * */
+        SDrawFrame m_Frame = {};
+
+        CViewportCuller m_ViewportCuller;
+        bool m_bCulling = false;
+
+        CDrawBatcher m_DrawBatcher;
+        bool m_bBatchSorting = false;
+        SBatchStats m_BatchStats = {};
+
+        CAffine2D<float> m_Transform;
+
+        /**
+         * @brief Points gathered by MergeCommandLists() for the batched transform of a run.
+         *
+         * Kept apart from the batch scratch arrays, which the render thread uses while the next frame merges.
+         * */
+        std::vector<CVector2D<float>> m_vecTransformPoints = {};
+
+        CDrawStreamWriter *m_pCaptureStream = nullptr;
+
+        /**
+         * @brief The captured frame with its indexed triangle batches expanded, as the stream format has no indices.
+         * */
+        std::vector<SDrawCommand> m_vecCaptureCommands = {};
+
+        /**
+         * @brief Immediate Draw* calls made while pipelined, which must not touch the render thread's backend.
+         * */
+        CDrawCommandList m_ImmediateCommands;
+
+        CFrameArena m_FrameArena;
+        CFrameArenaResource m_FrameArenaResource{m_FrameArena};
+
+        /**
+         * @brief Scratch arrays used to hand runs of commands to the bulk backend calls.
+         * */
+        std::vector<CVector2D<float>> m_vecBatchPoints = {};
+        std::vector<CVector2D<float>> m_vecBatchPointsEnd = {};
+        std::vector<float> m_vecBatchRadii = {};
+        std::vector<uint32_t> m_vecBatchColors = {};
+        std::vector<uint32_t> m_vecBatchIndices = {};
+
+        void ExecuteRun(const SDrawCommand *pCommands, size_t nCount, const SDrawGeometry &geometry)
+        {
+            m_vecBatchPoints.clear();
+            m_vecBatchPointsEnd.clear();
+            m_vecBatchRadii.clear();
+            m_vecBatchColors.clear();
+
+            for (size_t i = 0; i < nCount; i++)
+                m_vecBatchColors.push_back(pCommands[i].m_nColor);
+
+            switch (pCommands[0].m_nType)
+            {
+            case DRAW_COMMAND_LINE:
+            case DRAW_COMMAND_RECT:
+                for (size_t i = 0; i < nCount; i++)
+                {
+                    m_vecBatchPoints.push_back(pCommands[i].m_Points[0]);
+                    m_vecBatchPointsEnd.push_back(pCommands[i].m_Points[1]);
+                }
+
+                if (pCommands[0].m_nType == DRAW_COMMAND_LINE)
+                    m_Backend.DrawLines(m_vecBatchPoints.data(), m_vecBatchPointsEnd.data(), m_vecBatchColors.data(), nCount);
+                else
+                    m_Backend.DrawRects(m_vecBatchPoints.data(), m_vecBatchPointsEnd.data(), m_vecBatchColors.data(), nCount);
+                break;
+            case DRAW_COMMAND_CIRCLE:
+                for (size_t i = 0; i < nCount; i++)
+                {
+                    m_vecBatchPoints.push_back(pCommands[i].m_Points[0]);
+                    m_vecBatchRadii.push_back(pCommands[i].m_flRadius);
+                }
+
+                m_Backend.DrawCircles(m_vecBatchPoints.data(), m_vecBatchRadii.data(), m_vecBatchColors.data(), nCount);
+                break;
+            case DRAW_COMMAND_TRIANGLE:
+                for (size_t i = 0; i < nCount; i++)
+                {
+                    m_vecBatchPoints.push_back(pCommands[i].m_Points[0]);
+                    m_vecBatchPoints.push_back(pCommands[i].m_Points[1]);
+                    m_vecBatchPoints.push_back(pCommands[i].m_Points[2]);
+                }
+
+                m_Backend.DrawTriangles(m_vecBatchPoints.data(), m_vecBatchColors.data(), nCount);
+                break;
+            case DRAW_COMMAND_INDEXED_TRIANGLES:
+            {
+                // The triangles of every batch in the run share the frame's vertices, so one call draws them all.
+                m_vecBatchColors.clear();
+                m_vecBatchIndices.clear();
+
+                for (size_t i = 0; i < nCount; i++)
+                {
+                    const SDrawBatch &batch = geometry.m_vecBatches[pCommands[i].m_nBatch];
+                    const uint32_t *pIndices = geometry.m_vecIndices.data() + batch.m_nFirstIndex;
+                    m_vecBatchIndices.insert(m_vecBatchIndices.end(), pIndices, pIndices + static_cast<size_t>(batch.m_nTriangleCount) * 3);
+                    m_vecBatchColors.insert(m_vecBatchColors.end(), batch.m_nTriangleCount, pCommands[i].m_nColor);
+                }
+
+                m_Backend.DrawIndexedTriangles(geometry.m_vecVertices.data(), m_vecBatchIndices.data(), m_vecBatchColors.data(), m_vecBatchColors.size());
+                break;
+            }
+            }
+        }
+
+        void ExecuteCommands(const SDrawFrame &frame)
+        {
+            CALI_PROFILE_SCOPE("CDrawManager::ExecuteCommands");
+
+            const std::vector<SDrawCommand> &vecCommands = frame.m_vecCommands;
+            size_t nFirst = 0;
+            for (size_t i = 1; i <= vecCommands.size(); i++)
+            {
+                if (i == vecCommands.size() || !CDrawBatcher::IsCompatible(vecCommands[nFirst], vecCommands[i]))
+                {
+                    ExecuteRun(&vecCommands[nFirst], i - nFirst, frame.m_Geometry);
+                    nFirst = i;
+                }
+            }
+        }
+
+        std::vector<uint32_t> &PackColors(const CColorKey *pColors, size_t nCount)
+        {
+            m_vecBatchColors.clear();
+
+            for (size_t i = 0; i < nCount; i++)
+                m_vecBatchColors.push_back(GetColor(pColors, i));
+
+            return m_vecBatchColors;
+        }
+
+        void MergeCommandLists(size_t nCount, SDrawFrame &frame)
+        {
+            CALI_PROFILE_SCOPE("CDrawManager::MergeCommandLists");
+
+            // Immediate calls come first, as they would have reached the backend before EndFrame(), and untransformed.
+            frame.Clear();
+            AppendTransformedDrawCommands(m_ImmediateCommands.GetCommands().data(), m_ImmediateCommands.GetCommands().size(), m_ImmediateCommands.GetGeometry(),
+                                          CAffine2D<float>(), frame, m_vecTransformPoints);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const std::vector<SDrawCommand> &vecCommands = m_SortedCommandLists[i]->GetCommands();
+                const SDrawGeometry &geometry = m_SortedCommandLists[i]->GetGeometry();
+
+                // Every run of the list is transformed by the view transform after its own.
+                const std::vector<SDrawTransformRun> &vecRuns = m_SortedCommandLists[i]->GetTransformRuns();
+                size_t nBegin = 0;
+                CAffine2D<float> transform = m_Transform;
+
+                for (size_t nRun = 0; nRun <= vecRuns.size(); nRun++)
+                {
+                    const size_t nEnd = nRun < vecRuns.size() ? vecRuns[nRun].m_nFirstCommand : vecCommands.size();
+                    AppendTransformedDrawCommands(vecCommands.data() + nBegin, nEnd - nBegin, geometry, transform, frame, m_vecTransformPoints);
+
+                    if (nRun < vecRuns.size())
+                    {
+                        nBegin = nEnd;
+                        transform = m_Transform * vecRuns[nRun].m_Transform;
+                    }
+                }
+            }
+        }
+
+        void ProcessFrame(SDrawFrame &frame)
+        {
+            std::vector<SDrawCommand> &vecFrame = frame.m_vecCommands;
+            CALI_PROFILE_COUNT(PROFILE_COUNTER_PRIMITIVES, vecFrame.size());
+
+            if (m_pCaptureStream)
+            {
+                if (frame.m_Geometry.m_vecBatches.empty())
+                {
+                    m_pCaptureStream->WriteFrame(vecFrame);
+                }
+                else
+                {
+                    ExpandIndexedTriangles(frame, m_vecCaptureCommands);
+                    m_pCaptureStream->WriteFrame(m_vecCaptureCommands);
+                }
+            }
+
+            if (m_bCulling)
+            {
+                m_ViewportCuller.Cull(vecFrame);
+                CALI_PROFILE_COUNT(PROFILE_COUNTER_CULLED, m_ViewportCuller.GetStats().m_nCulled);
+            }
+
+            if (m_bBatchSorting)
+            {
+                m_DrawBatcher.Sort(vecFrame);
+                m_BatchStats = m_DrawBatcher.GetStats();
+            }
+            else
+            {
+                m_BatchStats.m_nCommands = vecFrame.size();
+                m_BatchStats.m_nDrawCallsBefore = CDrawBatcher::CountDrawCalls(vecFrame);
+                m_BatchStats.m_nDrawCallsAfter = m_BatchStats.m_nDrawCallsBefore;
+            }
+
+            CALI_PROFILE_COUNT(PROFILE_COUNTER_BATCHES, m_BatchStats.m_nDrawCallsAfter);
+        }
+
+        /**
+         * @brief Fill a frame buffer, run it through capture, culling and sorting, then render it
+         * or hand it to the render thread.
+         * If fnFill returns false the buffer is dropped unpublished and the backend sees nothing.
+         * */
+        template <typename TFill>
+        void DispatchFrame(TFill fnFill)
+        {
+            const bool bPipelined = IsPipelined();
+            SDrawFrame *pFrame = bPipelined ? m_FrameRing.AcquireWrite() : &m_Frame;
+            if (!pFrame)
+                return;
+
+            if (!fnFill(*pFrame))
+                return;
+
+            ProcessFrame(*pFrame);
+
+            if (bPipelined)
+                m_FrameRing.Publish();
+            else
+                ExecuteCommands(*pFrame);
+        }
+
+        void RenderThread()
+        {
+            while (SDrawFrame *pFrame = m_FrameRing.AcquireRead())
+            {
+                ExecuteCommands(*pFrame);
+                m_FrameRing.Release();
+            }
+        }
+
+        void StopRenderThread()
+        {
+            if (!m_RenderThread.joinable())
+                return;
+
+            m_FrameRing.Stop();
+            m_RenderThread.join();
+        }
+
+        size_t SortCommandLists()
+        {
+            const size_t nCount = std::min(m_nCommandListCount.load(std::memory_order_acquire), MAX_COMMAND_LISTS);
+
+            for (size_t i = 0; i < nCount; i++)
+                m_SortedCommandLists[i] = &m_CommandLists[i];
+
+            std::stable_sort(m_SortedCommandLists.begin(), m_SortedCommandLists.begin() + nCount,
+                             [](const CDrawCommandList *pLeft, const CDrawCommandList *pRight)
+                             { return pLeft->GetOrder() < pRight->GetOrder(); });
+
+            return nCount;
+        }
+
     public:
-        void Initialize();
-        void Shutdown();
+        ~CDrawManager() { StopRenderThread(); }
+
+        /**
+         * @brief Initialize the backend and, in pipelined mode, start the render thread.
+         * If the render thread cannot be started the manager falls back to synchronous mode.
+         * Calling it again first renders the queued frames and stops the previous render thread.
+         * */
+        void Initialize()
+        {
+            // Assigning over a running thread would terminate.
+            StopRenderThread();
+
+            m_Backend.Initialize();
+
+            if (m_nPipelineDepth > 0)
+            {
+                m_FrameRing.SetFrameCount(m_nPipelineDepth);
+                m_FrameRing.Reset();
+
+                try
+                {
+                    m_RenderThread = std::thread(&CDrawManager::RenderThread, this);
+                }
+                catch (const std::system_error &)
+                {
+                }
+            }
 
+            m_bInitialized = true;
+        }
+
+        /**
+         * @brief Render every queued frame, stop the render thread and shut the backend down.
+         * */
+        void Shutdown()
+        {
+            StopRenderThread();
+            m_Backend.Shutdown();
+            m_bInitialized = false;
+        }
+
+        /**
+         * @brief Set how many frames may be queued for the render thread.
+         *
+         * 0 keeps the synchronous mode where EndFrame() submits on the calling thread.
+         * Otherwise EndFrame() blocks once this many frames are waiting, which bounds the latency.
+         * Takes effect on the next Initialize().
+         *
+         * @param nFrameBuffers The number of frame buffers, at most MAX_FRAME_BUFFERS.
+         * */
+        void SetPipelineDepth(size_t nFrameBuffers)
+        {
+            m_nPipelineDepth = std::min(nFrameBuffers, MAX_FRAME_BUFFERS);
+        }
+
+        /**
+         * @brief Get the configured number of frame buffers.
+         * @return The number of frame buffers, 0 in synchronous mode.
+         * */
+        size_t GetPipelineDepth() const { return m_nPipelineDepth; }
+
+        /**
+         * @brief Check whether frames are rendered on the render thread.
+         * @return True if the render thread is running.
+         * */
+        bool IsPipelined() const { return m_RenderThread.joinable(); }
+
+        /**
+         * @brief Block until the render thread has rendered every submitted frame.
+         * */
+        void WaitForRenderThread()
+        {
+            if (IsPipelined())
+                m_FrameRing.WaitForIdle();
+        }
+
+        /**
+         * @brief Get the backend this manager dispatches to.
+         * @return The backend.
+         * */
+        TBackend &GetBackend() { return m_Backend; }
+
+        /**
+         * @brief Cull and clip recorded frames against a viewport rectangle.
+         * @param vecMin The top left corner.
+         * @param vecMax The bottom right corner.
+         * */
+        void SetViewport(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax)
+        {
+            m_ViewportCuller.SetViewport(vecMin, vecMax);
+            m_bCulling = true;
+        }
+
+        /**
+         * @brief Stop culling recorded frames.
+         * */
+        void DisableCulling() { m_bCulling = false; }
+
+        /**
+         * @brief Get what culling removed from the last frame.
+         * @return The counters of the last EndFrame().
+         * */
+        const SCullStats &GetCullStats() const { return m_ViewportCuller.GetStats(); }
+
+        /**
+         * @brief Sort recorded frames by sort key to minimise backend draw calls.
+         * Layers, then depths, are drawn in ascending order; within one layer and depth commands are
+         * grouped by type and keep their submission order otherwise. Primitives that overlap and must
+         * keep their order therefore need different depths or layers, see MakeDrawSortKey().
+         * @param bEnabled Whether to sort.
+         * */
+        void SetBatchSorting(bool bEnabled) { m_bBatchSorting = bEnabled; }
+
+        /**
+         * @brief Get the draw call counts of the last frame.
+         * @return The counters of the last EndFrame().
+         * */
+        const SBatchStats &GetBatchStats() const { return m_BatchStats; }
+
+        /**
+         * @brief Get the arena for transient geometry of the thread calling EndFrame().
+         * Everything allocated from it is released by the next EndFrame().
+         * @return The arena.
+         * */
+        CFrameArena &GetFrameArena() { return m_FrameArena; }
+
+        /**
+         * @brief Get a std::pmr::memory_resource allocating from GetFrameArena().
+         * @return The memory resource.
+         * */
+        std::pmr::memory_resource *GetFrameArenaResource() { return &m_FrameArenaResource; }
+
+        /**
+         * @brief Get the combined counters of the frame arena and the arenas of all command lists.
+         * Call it before EndFrame() to see the current frame's usage; the high-water marks persist.
+         * @return The combined counters.
+         * */
+        SArenaStats GetArenaStats() const
+        {
+            SArenaStats stats = m_FrameArena.GetStats();
+
+            for (const CDrawCommandList &commandList : m_CommandLists)
+            {
+                const SArenaStats &listStats = commandList.GetArena().GetStats();
+                stats.m_nBytesUsed += listStats.m_nBytesUsed;
+                stats.m_nHighWaterMark += listStats.m_nHighWaterMark;
+                stats.m_nBytesReserved += listStats.m_nBytesReserved;
+                stats.m_nBlockCount += listStats.m_nBlockCount;
+            }
+
+            return stats;
+        }
+
+        /**
+         * @brief Set the view transform applied to command lists at EndFrame(), after their own transforms.
+         * Frames passed to SubmitFrame() or Replay() and the immediate Draw* calls are not transformed.
+         * Under a rotation or shear rects are drawn as two triangles. Circles stay circles: under a
+         * non-uniform scale or a shear their radius is scaled by sqrt(|det|).
+         * @param transform The transform.
+         * */
+        void SetTransform(const CAffine2D<float> &transform) { m_Transform = transform; }
+
+        /**
+         * @brief Get the view transform.
+         * @return The view transform, the identity unless SetTransform() was called.
+         * */
+        const CAffine2D<float> &GetTransform() const { return m_Transform; }
+
+        /**
+         * @brief Record every frame passed to the backend, before culling and sorting.
+         * @param pCaptureStream An open stream, or nullptr to stop capturing. Must outlive the capture.
+         * */
+        void SetCaptureStream(CDrawStreamWriter *pCaptureStream) { m_pCaptureStream = pCaptureStream; }
+
+        /**
+         * @brief Submit a complete frame, e.g. one read from a draw stream.
+         * The frame goes through the same culling, sorting and pipelining as one built by EndFrame().
+         * Indexed triangle batches are skipped, as the frame carries no geometry for them; expand them
+         * first with ExpandIndexedTriangles().
+         * @param vecCommands The commands of the frame.
+         * */
+        void SubmitFrame(const std::vector<SDrawCommand> &vecCommands)
+        {
+            DispatchFrame([&vecCommands](SDrawFrame &frame)
+                          {
+                              frame.Clear();
+                              std::copy_if(vecCommands.begin(), vecCommands.end(), std::back_inserter(frame.m_vecCommands),
+                                           [](const SDrawCommand &command) { return command.m_nType != DRAW_COMMAND_INDEXED_TRIANGLES; });
+                              return true; });
+        }
+
+        /**
+         * @brief Submit every remaining frame of a draw stream as fast as possible.
+         * Frames are decoded straight into the frame buffers. Replay stops at the first truncated frame.
+         * @param reader The stream.
+         * @return The number of frames submitted.
+         * */
+        size_t Replay(CDrawStreamReader &reader)
+        {
+            size_t nFrames = 0;
+            bool bValid = true;
+
+            while (bValid && !reader.IsAtEnd())
+            {
+                // A truncated frame is dropped before it reaches culling, capture or the backend.
+                DispatchFrame([&reader, &bValid](SDrawFrame &frame)
+                              {
+                                  frame.m_Geometry.Clear();
+                                  bValid = reader.ReadFrame(frame.m_vecCommands);
+                                  return bValid; });
+
+                nFrames += bValid ? 1 : 0;
+            }
+
+            return nFrames;
+        }
+
+        /**
+         * @brief Claim a command list for the calling thread.
+         *
+         * Lock-free and safe to call from any thread. The returned list belongs to the caller
+         * until EndFrame(). Give each list a distinct order key to get a reproducible draw order.
+         *
+         * @param nOrder The key the list is merged by at frame end.
+         * @return The command list, or nullptr if MAX_COMMAND_LISTS lists are already in use this frame.
+         * */
+        CDrawCommandList *BeginCommandList(uint32_t nOrder)
+        {
+            const size_t nIndex = m_nCommandListCount.fetch_add(1, std::memory_order_relaxed);
+            if (nIndex >= MAX_COMMAND_LISTS)
+                return nullptr;
+
+            CDrawCommandList *pCommandList = &m_CommandLists[nIndex];
+            pCommandList->SetOrder(nOrder);
+            return pCommandList;
+        }
+
+        /**
+         * @brief Merge all command lists of the frame and submit them to the backend.
+         *
+         * Lists are submitted in ascending order key, each in its own submission order.
+         * Must be called once all recording threads have finished the frame. Also closes the profiler
+         * frame when CALI_ENABLE_PROFILING is defined.
+         * In pipelined mode the frame is queued for the render thread instead, blocking while
+         * the queue is full.
+         * */
+        void EndFrame()
+        {
+            CALI_PROFILE_SCOPE("CDrawManager::EndFrame");
+
+            const size_t nCount = SortCommandLists();
+
+            DispatchFrame([this, nCount](SDrawFrame &frame)
+                          {
+                              MergeCommandLists(nCount, frame);
+                              return true; });
+
+            for (size_t i = 0; i < nCount; i++)
+                m_CommandLists[i].Clear();
+
+            m_ImmediateCommands.Clear();
+            m_FrameArena.Reset();
+
+            CALI_PROFILE_FRAME();
+
+            m_nCommandListCount.store(0, std::memory_order_release);
+        }
+
+        /**
+         * @brief Draw a line straight away, or, when pipelined, record it for the next EndFrame().
+         * The immediate Draw* calls are not thread-safe, call them from the thread calling EndFrame().
+         * */
         template <typename T = float>
-        void DrawLine(CVector2D<T> v1, CVector2D<T> v2);
+        void DrawLine(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawLine(v1, v2);
+            else
+                m_Backend.DrawLine(v1, v2);
+        }
 
         template <typename T = float>
-        void DrawRect(CVector2D<T> v1, CVector2D<T> v2);
+        void DrawRect(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawRect(v1, v2);
+            else
+                m_Backend.DrawRect(v1, v2);
+        }
 
         template <typename T = float>
-        void DrawCircle(CVector2D<T> v1, double radius);
+        void DrawCircle(CVector2D<T> v1, double radius)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawCircle(v1, radius);
+            else
+                m_Backend.DrawCircle(v1, radius);
+        }
 
         template <typename T = float>
-        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3);
+        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawTriangle(v1, v2, v3);
+            else
+                m_Backend.DrawTriangle(v1, v2, v3);
+        }
+
+        /**
+         * @brief Draw nCount lines from pStart[i] to pEnd[i] in a single backend call.
+         * @param pColors One color per line, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const CColorKey *pColors, size_t nCount)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawLines(pStart, pEnd, pColors, nCount);
+            else
+                m_Backend.DrawLines(pStart, pEnd, PackColors(pColors, nCount).data(), nCount);
+        }
+
+        /**
+         * @brief Draw nCount rects spanning pMin[i] to pMax[i] in a single backend call.
+         * @param pColors One color per rect, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const CColorKey *pColors, size_t nCount)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawRects(pMin, pMax, pColors, nCount);
+            else
+                m_Backend.DrawRects(pMin, pMax, PackColors(pColors, nCount).data(), nCount);
+        }
+
+        /**
+         * @brief Draw nCount circles around pCenters[i] with pRadii[i] in a single backend call.
+         * @param pColors One color per circle, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const CColorKey *pColors, size_t nCount)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawCircles(pCenters, pRadii, pColors, nCount);
+            else
+                m_Backend.DrawCircles(pCenters, pRadii, PackColors(pColors, nCount).data(), nCount);
+        }
+
+        /**
+         * @brief Draw nCount triangles, three consecutive vertices each, in a single backend call.
+         * @param pColors One color per triangle, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const CColorKey *pColors, size_t nCount)
+        {
+            if (IsPipelined())
+                m_ImmediateCommands.DrawTriangles(pVertices, pColors, nCount);
+            else
+                m_Backend.DrawTriangles(pVertices, PackColors(pColors, nCount).data(), nCount);
+        }
+
+        /**
+         * @brief Draw an indexed triangle batch, e.g. a STessellation, in one color and a single backend call.
+         * @param pIndices Three indices into pVertices per triangle.
+         * @param nCount The number of triangles.
+         * @param pColor The color, or nullptr for CONST_COLOR_DEFAULT.
+         * */
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, size_t nCount, const CColorKey *pColor)
+        {
+            if (IsPipelined())
+            {
+                m_ImmediateCommands.DrawIndexedTriangles(pVertices, pIndices, nCount, GetColor(pColor, 0));
+                return;
+            }
+
+            m_vecBatchColors.assign(nCount, GetColor(pColor, 0));
+            m_Backend.DrawIndexedTriangles(pVertices, pIndices, m_vecBatchColors.data(), nCount);
+        }
     };
 
 } // namespace Cali
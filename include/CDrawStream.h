@@ -0,0 +1,533 @@
+#pragma once
+
+/**
+ * @file CDrawStream.h
+ * @brief Contains the declaration of the CDrawStreamWriter and CDrawStreamReader classes.
+ *
+ * A draw stream is a compact capture of the frames a CDrawManager received. Layout, little endian:
+ *
+ * - Header: the magic "CALI" followed by a uint32 format version.
+ * - Per frame: a varint command count followed by the commands.
+ * - Per command: a flags byte holding the primitive type in bits 0-3, bit 4 if a uint32 color follows
+ *   and bit 5 if a varint sort key follows; both are otherwise repeated from the previous command.
+ *   Then one x, y pair per point (and the radius of circles), each stored as the zigzag varint of the
+ *   difference between its float bit pattern and the one of the previous value in the same slot.
+ *
+ * Nearby coordinates share sign and exponent, so the deltas are small and the encoding is lossless.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CDrawCommand.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Cali
+{
+    /**
+     * @brief Shared constants and helpers of the draw stream format.
+     * */
+    class CDrawStreamFormat
+    {
+    public:
+        static constexpr uint32_t VERSION = 1;
+        static constexpr unsigned char MAGIC[4] = {'C', 'A', 'L', 'I'};
+        static constexpr size_t HEADER_SIZE = 8;
+
+        static constexpr unsigned char FLAG_TYPE_MASK = 0x0F;
+        static constexpr unsigned char FLAG_COLOR = 0x10;
+        static constexpr unsigned char FLAG_SORT_KEY = 0x20;
+
+        /**
+         * @brief Number of points a command of the given type stores.
+         * */
+        static size_t GetPointCount(DrawCommandType_e nType)
+        {
+            return nType == DRAW_COMMAND_CIRCLE ? 1 : (nType == DRAW_COMMAND_TRIANGLE ? 3 : 2);
+        }
+
+        static uint32_t FloatBits(float flValue)
+        {
+            uint32_t nBits;
+            std::memcpy(&nBits, &flValue, sizeof(nBits));
+            return nBits;
+        }
+
+        static float BitsFloat(uint32_t nBits)
+        {
+            float flValue;
+            std::memcpy(&flValue, &nBits, sizeof(flValue));
+            return flValue;
+        }
+
+        static uint32_t ZigZag(int32_t nValue) { return (static_cast<uint32_t>(nValue) << 1) ^ static_cast<uint32_t>(nValue >> 31); }
+        static int32_t UnZigZag(uint32_t nValue) { return static_cast<int32_t>(nValue >> 1) ^ -static_cast<int32_t>(nValue & 1); }
+    };
+
+    /**
+     * @brief Delta coding state shared by the writer and the reader.
+     * */
+    struct SDrawStreamState
+    {
+        uint32_t m_nX = 0;
+        uint32_t m_nY = 0;
+        uint32_t m_nRadius = 0;
+        uint32_t m_nColor = CONST_COLOR_DEFAULT;
+        uint64_t m_nSortKey = 0;
+    };
+
+    /**
+     * @class CDrawStreamWriter
+     * @brief Records frames of draw commands into a draw stream file.
+     */
+    class CDrawStreamWriter
+    {
+    private:
+        FILE *m_pFile = nullptr;
+        SDrawStreamState m_State = {};
+        std::vector<unsigned char> m_vecBuffer = {};
+
+        void WriteVarint(uint64_t nValue)
+        {
+            while (nValue >= 0x80)
+            {
+                m_vecBuffer.push_back(static_cast<unsigned char>(nValue | 0x80));
+                nValue >>= 7;
+            }
+
+            m_vecBuffer.push_back(static_cast<unsigned char>(nValue));
+        }
+
+        void WriteDelta(uint32_t &nPrevious, float flValue)
+        {
+            const uint32_t nBits = CDrawStreamFormat::FloatBits(flValue);
+            WriteVarint(CDrawStreamFormat::ZigZag(static_cast<int32_t>(nBits - nPrevious)));
+            nPrevious = nBits;
+        }
+
+    public:
+        CDrawStreamWriter() = default;
+        ~CDrawStreamWriter() { Close(); }
+
+        CDrawStreamWriter(const CDrawStreamWriter &) = delete;
+        CDrawStreamWriter &operator=(const CDrawStreamWriter &) = delete;
+
+        CDrawStreamWriter(CDrawStreamWriter &&other) noexcept
+            : m_pFile(std::exchange(other.m_pFile, nullptr)), m_State(other.m_State), m_vecBuffer(std::move(other.m_vecBuffer))
+        {
+        }
+
+        CDrawStreamWriter &operator=(CDrawStreamWriter &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                m_pFile = std::exchange(other.m_pFile, nullptr);
+                m_State = other.m_State;
+                m_vecBuffer = std::move(other.m_vecBuffer);
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Create or truncate a stream file and write its header.
+         * @param szPath The file path.
+         * @return False if the file could not be opened.
+         * */
+        bool Open(const std::string &szPath)
+        {
+            Close();
+
+            m_pFile = std::fopen(szPath.c_str(), "wb");
+            if (!m_pFile)
+                return false;
+
+            const unsigned char header[CDrawStreamFormat::HEADER_SIZE] = {
+                CDrawStreamFormat::MAGIC[0], CDrawStreamFormat::MAGIC[1], CDrawStreamFormat::MAGIC[2], CDrawStreamFormat::MAGIC[3],
+                static_cast<unsigned char>(CDrawStreamFormat::VERSION), static_cast<unsigned char>(CDrawStreamFormat::VERSION >> 8),
+                static_cast<unsigned char>(CDrawStreamFormat::VERSION >> 16), static_cast<unsigned char>(CDrawStreamFormat::VERSION >> 24)};
+
+            m_State = {};
+            return std::fwrite(header, 1, sizeof(header), m_pFile) == sizeof(header);
+        }
+
+        /**
+         * @brief Flush and close the file.
+         * */
+        void Close()
+        {
+            if (!m_pFile)
+                return;
+
+            std::fclose(m_pFile);
+            m_pFile = nullptr;
+        }
+
+        bool IsOpen() const { return m_pFile != nullptr; }
+
+        /**
+         * @brief Append a frame.
+         * The format has no indexed triangle batches; expand them first with ExpandIndexedTriangles().
+         * @param vecCommands The commands of the frame in submission order.
+         * @return False if the write failed.
+         * */
+        bool WriteFrame(const std::vector<SDrawCommand> &vecCommands)
+        {
+            if (!m_pFile)
+                return false;
+
+            m_vecBuffer.clear();
+            WriteVarint(vecCommands.size());
+
+            for (const SDrawCommand &command : vecCommands)
+            {
+                unsigned char nFlags = command.m_nType & CDrawStreamFormat::FLAG_TYPE_MASK;
+                if (command.m_nColor != m_State.m_nColor)
+                    nFlags |= CDrawStreamFormat::FLAG_COLOR;
+                if (command.m_nSortKey != m_State.m_nSortKey)
+                    nFlags |= CDrawStreamFormat::FLAG_SORT_KEY;
+
+                m_vecBuffer.push_back(nFlags);
+
+                if (nFlags & CDrawStreamFormat::FLAG_COLOR)
+                {
+                    for (int i = 0; i < 4; i++)
+                        m_vecBuffer.push_back(static_cast<unsigned char>(command.m_nColor >> (i * 8)));
+
+                    m_State.m_nColor = command.m_nColor;
+                }
+
+                if (nFlags & CDrawStreamFormat::FLAG_SORT_KEY)
+                {
+                    WriteVarint(command.m_nSortKey);
+                    m_State.m_nSortKey = command.m_nSortKey;
+                }
+
+                for (size_t i = 0; i < CDrawStreamFormat::GetPointCount(command.m_nType); i++)
+                {
+                    WriteDelta(m_State.m_nX, command.m_Points[i].GetX());
+                    WriteDelta(m_State.m_nY, command.m_Points[i].GetY());
+                }
+
+                if (command.m_nType == DRAW_COMMAND_CIRCLE)
+                    WriteDelta(m_State.m_nRadius, command.m_flRadius);
+            }
+
+            return std::fwrite(m_vecBuffer.data(), 1, m_vecBuffer.size(), m_pFile) == m_vecBuffer.size();
+        }
+    };
+
+    /**
+     * @class CDrawStreamReader
+     * @brief Reads frames back from a draw stream.
+     *
+     * Files are memory mapped and decoded in place, so multi-gigabyte captures are never copied into
+     * memory as a whole. A stream can also be read from a buffer owned by the caller.
+     */
+    class CDrawStreamReader
+    {
+    private:
+        const unsigned char *m_pData = nullptr;
+        size_t m_nSize = 0;
+        size_t m_nOffset = 0;
+        SDrawStreamState m_State = {};
+
+#ifdef _WIN32
+        HANDLE m_hFile = INVALID_HANDLE_VALUE;
+        HANDLE m_hMapping = nullptr;
+#else
+        int m_nFile = -1;
+#endif
+        bool m_bMapped = false;
+
+        bool ReadVarint(uint64_t &nValue)
+        {
+            nValue = 0;
+
+            for (int nShift = 0; nShift < 64; nShift += 7)
+            {
+                if (m_nOffset >= m_nSize)
+                    return false;
+
+                const unsigned char nByte = m_pData[m_nOffset++];
+                nValue |= static_cast<uint64_t>(nByte & 0x7F) << nShift;
+
+                if (!(nByte & 0x80))
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool ReadDelta(uint32_t &nPrevious, float &flValue)
+        {
+            uint64_t nValue;
+            if (!ReadVarint(nValue))
+                return false;
+
+            nPrevious += static_cast<uint32_t>(CDrawStreamFormat::UnZigZag(static_cast<uint32_t>(nValue)));
+            flValue = CDrawStreamFormat::BitsFloat(nPrevious);
+            return true;
+        }
+
+        /**
+         * @brief Take over the mapping and read position of other, leaving it closed.
+         * */
+        void MoveFrom(CDrawStreamReader &other)
+        {
+            m_pData = std::exchange(other.m_pData, nullptr);
+            m_nSize = std::exchange(other.m_nSize, 0);
+            m_nOffset = std::exchange(other.m_nOffset, 0);
+            m_State = other.m_State;
+#ifdef _WIN32
+            m_hFile = std::exchange(other.m_hFile, INVALID_HANDLE_VALUE);
+            m_hMapping = std::exchange(other.m_hMapping, nullptr);
+#else
+            m_nFile = std::exchange(other.m_nFile, -1);
+#endif
+            m_bMapped = std::exchange(other.m_bMapped, false);
+        }
+
+    public:
+        CDrawStreamReader() = default;
+        ~CDrawStreamReader() { Close(); }
+
+        CDrawStreamReader(const CDrawStreamReader &) = delete;
+        CDrawStreamReader &operator=(const CDrawStreamReader &) = delete;
+
+        CDrawStreamReader(CDrawStreamReader &&other) noexcept { MoveFrom(other); }
+
+        CDrawStreamReader &operator=(CDrawStreamReader &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                MoveFrom(other);
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Memory map a stream file.
+         * @param szPath The file path.
+         * @return False if the file could not be mapped or is not a supported draw stream.
+         * */
+        bool Open(const std::string &szPath)
+        {
+            Close();
+
+#ifdef _WIN32
+            m_hFile = CreateFileA(szPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER nFileSize;
+            if (!GetFileSizeEx(m_hFile, &nFileSize) || nFileSize.QuadPart == 0)
+            {
+                Close();
+                return false;
+            }
+
+            m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const void *pView = m_hMapping ? MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!pView)
+            {
+                Close();
+                return false;
+            }
+
+            m_nSize = static_cast<size_t>(nFileSize.QuadPart);
+#else
+            m_nFile = open(szPath.c_str(), O_RDONLY);
+            if (m_nFile < 0)
+                return false;
+
+            struct stat fileStat;
+            if (fstat(m_nFile, &fileStat) != 0 || fileStat.st_size == 0)
+            {
+                Close();
+                return false;
+            }
+
+            void *pView = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_nFile, 0);
+            if (pView == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+
+            madvise(pView, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+            m_nSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+            m_pData = static_cast<const unsigned char *>(pView);
+            m_bMapped = true;
+
+            if (!Rewind())
+            {
+                Close();
+                return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Read a stream from memory owned by the caller.
+         * @param pData The stream, which must outlive the reader.
+         * @param nSize The size of the stream in bytes.
+         * @return False if the data is not a supported draw stream.
+         * */
+        bool Open(const unsigned char *pData, size_t nSize)
+        {
+            Close();
+
+            m_pData = pData;
+            m_nSize = nSize;
+
+            if (!Rewind())
+            {
+                Close();
+                return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Unmap the file.
+         * */
+        void Close()
+        {
+#ifdef _WIN32
+            if (m_bMapped)
+                UnmapViewOfFile(m_pData);
+            if (m_hMapping)
+                CloseHandle(m_hMapping);
+            if (m_hFile != INVALID_HANDLE_VALUE)
+                CloseHandle(m_hFile);
+
+            m_hMapping = nullptr;
+            m_hFile = INVALID_HANDLE_VALUE;
+#else
+            if (m_bMapped)
+                munmap(const_cast<unsigned char *>(m_pData), m_nSize);
+            if (m_nFile >= 0)
+                close(m_nFile);
+
+            m_nFile = -1;
+#endif
+
+            m_bMapped = false;
+            m_pData = nullptr;
+            m_nSize = 0;
+            m_nOffset = 0;
+        }
+
+        /**
+         * @brief Go back to the first frame.
+         * @return False if the stream header is missing or of an unsupported version.
+         * */
+        bool Rewind()
+        {
+            if (m_nSize < CDrawStreamFormat::HEADER_SIZE || std::memcmp(m_pData, CDrawStreamFormat::MAGIC, sizeof(CDrawStreamFormat::MAGIC)) != 0)
+                return false;
+
+            const uint32_t nVersion = static_cast<uint32_t>(m_pData[4]) | static_cast<uint32_t>(m_pData[5]) << 8 | static_cast<uint32_t>(m_pData[6]) << 16 | static_cast<uint32_t>(m_pData[7]) << 24;
+            if (nVersion != CDrawStreamFormat::VERSION)
+                return false;
+
+            m_nOffset = CDrawStreamFormat::HEADER_SIZE;
+            m_State = {};
+            return true;
+        }
+
+        /**
+         * @brief Get the size of the stream.
+         * @return The size in bytes.
+         * */
+        size_t GetSize() const { return m_nSize; }
+
+        /**
+         * @brief Check whether every frame has been read.
+         * @return True at the end of the stream.
+         * */
+        bool IsAtEnd() const { return m_nOffset >= m_nSize; }
+
+        /**
+         * @brief Decode the next frame.
+         * @param vecCommands Receives the commands of the frame.
+         * @return False at the end of the stream or if the stream is truncated.
+         * */
+        bool ReadFrame(std::vector<SDrawCommand> &vecCommands)
+        {
+            vecCommands.clear();
+
+            uint64_t nCount;
+            if (!ReadVarint(nCount) || nCount > m_nSize - m_nOffset)
+                return false;
+
+            vecCommands.resize(static_cast<size_t>(nCount));
+
+            for (SDrawCommand &command : vecCommands)
+            {
+                if (m_nOffset >= m_nSize)
+                    return false;
+
+                const unsigned char nFlags = m_pData[m_nOffset++];
+                if ((nFlags & CDrawStreamFormat::FLAG_TYPE_MASK) > DRAW_COMMAND_TRIANGLE)
+                    return false;
+
+                command.m_nType = static_cast<DrawCommandType_e>(nFlags & CDrawStreamFormat::FLAG_TYPE_MASK);
+
+                if (nFlags & CDrawStreamFormat::FLAG_COLOR)
+                {
+                    if (m_nOffset + 4 > m_nSize)
+                        return false;
+
+                    m_State.m_nColor = static_cast<uint32_t>(m_pData[m_nOffset]) | static_cast<uint32_t>(m_pData[m_nOffset + 1]) << 8 |
+                                       static_cast<uint32_t>(m_pData[m_nOffset + 2]) << 16 | static_cast<uint32_t>(m_pData[m_nOffset + 3]) << 24;
+                    m_nOffset += 4;
+                }
+
+                if ((nFlags & CDrawStreamFormat::FLAG_SORT_KEY) && !ReadVarint(m_State.m_nSortKey))
+                    return false;
+
+                command.m_nColor = m_State.m_nColor;
+                command.m_nSortKey = m_State.m_nSortKey;
+
+                for (size_t i = 0; i < CDrawStreamFormat::GetPointCount(command.m_nType); i++)
+                {
+                    float flX, flY;
+                    if (!ReadDelta(m_State.m_nX, flX) || !ReadDelta(m_State.m_nY, flY))
+                        return false;
+
+                    command.m_Points[i] = CVector2D<float>(flX, flY);
+                }
+
+                if (command.m_nType == DRAW_COMMAND_CIRCLE && !ReadDelta(m_State.m_nRadius, command.m_flRadius))
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+} // namespace Cali
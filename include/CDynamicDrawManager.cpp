@@ -0,0 +1,35 @@
+#include "CDynamicDrawManager.h"
+
+#include <stdexcept>
+
+#include "DrawManagers/CDrawManager_Null.h"
+#include "DrawManagers/CDrawManager_Software.h"
+
+#ifdef _WIN32
+#include "DrawManagers/CDrawManager_D3D9.h"
+#endif
+
+Cali::CDynamicDrawManager::CDynamicDrawManager(ManagerType_e nManagerType)
+{
+    if (nManagerType == ManagerType_e::Null)
+    {
+        m_pManager = std::make_unique<CDrawManagerAdapter<CDrawManager_Null>>();
+        return;
+    }
+
+    if (nManagerType == ManagerType_e::Software)
+    {
+        m_pManager = std::make_unique<CDrawManagerAdapter<CDrawManager_Software>>();
+        return;
+    }
+
+#ifdef _WIN32
+    if (nManagerType == ManagerType_e::D3D9)
+    {
+        m_pManager = std::make_unique<CDrawManagerAdapter<CDrawManager_D3D9>>();
+        return;
+    }
+#endif
+
+    throw std::invalid_argument("CDynamicDrawManager: unsupported manager type");
+}
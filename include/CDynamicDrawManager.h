@@ -0,0 +1,228 @@
+#pragma once
+
+/**
+ * @file CDynamicDrawManager.h
+ * @brief Contains the declaration of the CDynamicDrawManager class.
+ */
+
+#include <memory>
+#include <vector>
+#include "CDrawManager.h"
+
+namespace Cali
+{
+    /**
+     * @class IDrawManager
+     * @brief Type-erased interface over CDrawManager, used by CDynamicDrawManager.
+     * */
+    class IDrawManager
+    {
+    public:
+        virtual ~IDrawManager() = default;
+
+        virtual void Initialize() = 0;
+        virtual void Shutdown() = 0;
+
+        virtual CDrawCommandList *BeginCommandList(uint32_t nOrder) = 0;
+        virtual void EndFrame() = 0;
+
+        virtual void SetPipelineDepth(size_t nFrameBuffers) = 0;
+        virtual void WaitForRenderThread() = 0;
+
+        virtual void SetViewport(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax) = 0;
+        virtual void DisableCulling() = 0;
+        virtual const SCullStats &GetCullStats() const = 0;
+
+        virtual void SetBatchSorting(bool bEnabled) = 0;
+        virtual const SBatchStats &GetBatchStats() const = 0;
+
+        virtual void SetTransform(const CAffine2D<float> &transform) = 0;
+        virtual const CAffine2D<float> &GetTransform() const = 0;
+
+        virtual void SetCaptureStream(CDrawStreamWriter *pCaptureStream) = 0;
+        virtual void SubmitFrame(const std::vector<SDrawCommand> &vecCommands) = 0;
+        virtual size_t Replay(CDrawStreamReader &reader) = 0;
+
+        virtual void DrawLine(CVector2D<float> v1, CVector2D<float> v2) = 0;
+        virtual void DrawRect(CVector2D<float> v1, CVector2D<float> v2) = 0;
+        virtual void DrawCircle(CVector2D<float> v1, double radius) = 0;
+        virtual void DrawTriangle(CVector2D<float> v1, CVector2D<float> v2, CVector2D<float> v3) = 0;
+
+        virtual void DrawLines(const CVector2D<float> *pStart, const CVector2D<float> *pEnd, const CColorKey *pColors, size_t nCount) = 0;
+        virtual void DrawRects(const CVector2D<float> *pMin, const CVector2D<float> *pMax, const CColorKey *pColors, size_t nCount) = 0;
+        virtual void DrawCircles(const CVector2D<float> *pCenters, const float *pRadii, const CColorKey *pColors, size_t nCount) = 0;
+        virtual void DrawTriangles(const CVector2D<float> *pVertices, const CColorKey *pColors, size_t nCount) = 0;
+        virtual void DrawIndexedTriangles(const CVector2D<float> *pVertices, const uint32_t *pIndices, size_t nCount, const CColorKey *pColor) = 0;
+    };
+
+    /**
+     * @class CDrawManagerAdapter
+     * @brief Implements IDrawManager on top of a statically dispatched CDrawManager.
+     * @tparam TBackend The backend type.
+     * */
+    template <typename TBackend>
+    class CDrawManagerAdapter final : public IDrawManager
+    {
+    private:
+        CDrawManager<TBackend> m_Manager;
+
+    public:
+        CDrawManager<TBackend> &GetManager() { return m_Manager; }
+
+        void Initialize() override { m_Manager.Initialize(); }
+        void Shutdown() override { m_Manager.Shutdown(); }
+
+        CDrawCommandList *BeginCommandList(uint32_t nOrder) override { return m_Manager.BeginCommandList(nOrder); }
+        void EndFrame() override { m_Manager.EndFrame(); }
+
+        void SetPipelineDepth(size_t nFrameBuffers) override { m_Manager.SetPipelineDepth(nFrameBuffers); }
+        void WaitForRenderThread() override { m_Manager.WaitForRenderThread(); }
+
+        void SetViewport(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax) override { m_Manager.SetViewport(vecMin, vecMax); }
+        void DisableCulling() override { m_Manager.DisableCulling(); }
+        const SCullStats &GetCullStats() const override { return m_Manager.GetCullStats(); }
+
+        void SetBatchSorting(bool bEnabled) override { m_Manager.SetBatchSorting(bEnabled); }
+        const SBatchStats &GetBatchStats() const override { return m_Manager.GetBatchStats(); }
+
+        void SetTransform(const CAffine2D<float> &transform) override { m_Manager.SetTransform(transform); }
+        const CAffine2D<float> &GetTransform() const override { return m_Manager.GetTransform(); }
+
+        void SetCaptureStream(CDrawStreamWriter *pCaptureStream) override { m_Manager.SetCaptureStream(pCaptureStream); }
+        void SubmitFrame(const std::vector<SDrawCommand> &vecCommands) override { m_Manager.SubmitFrame(vecCommands); }
+        size_t Replay(CDrawStreamReader &reader) override { return m_Manager.Replay(reader); }
+
+        void DrawLine(CVector2D<float> v1, CVector2D<float> v2) override { m_Manager.DrawLine(v1, v2); }
+        void DrawRect(CVector2D<float> v1, CVector2D<float> v2) override { m_Manager.DrawRect(v1, v2); }
+        void DrawCircle(CVector2D<float> v1, double radius) override { m_Manager.DrawCircle(v1, radius); }
+        void DrawTriangle(CVector2D<float> v1, CVector2D<float> v2, CVector2D<float> v3) override { m_Manager.DrawTriangle(v1, v2, v3); }
+
+        void DrawLines(const CVector2D<float> *pStart, const CVector2D<float> *pEnd, const CColorKey *pColors, size_t nCount) override { m_Manager.DrawLines(pStart, pEnd, pColors, nCount); }
+        void DrawRects(const CVector2D<float> *pMin, const CVector2D<float> *pMax, const CColorKey *pColors, size_t nCount) override { m_Manager.DrawRects(pMin, pMax, pColors, nCount); }
+        void DrawCircles(const CVector2D<float> *pCenters, const float *pRadii, const CColorKey *pColors, size_t nCount) override { m_Manager.DrawCircles(pCenters, pRadii, pColors, nCount); }
+        void DrawTriangles(const CVector2D<float> *pVertices, const CColorKey *pColors, size_t nCount) override { m_Manager.DrawTriangles(pVertices, pColors, nCount); }
+        void DrawIndexedTriangles(const CVector2D<float> *pVertices, const uint32_t *pIndices, size_t nCount, const CColorKey *pColor) override { m_Manager.DrawIndexedTriangles(pVertices, pIndices, nCount, pColor); }
+    };
+
+    /**
+     * @class CDynamicDrawManager
+     * @brief Draw manager whose backend is selected at runtime.
+     *
+     * Every call goes through a virtual dispatch, so prefer CDrawManager<TBackend> on hot paths.
+     * This wrapper is meant for tools that only know the backend once they are running.
+     * */
+    class CDynamicDrawManager
+    {
+    public:
+        /**
+         * @brief The built-in backends. D3D9 is only available on Windows.
+         * */
+        enum ManagerType_e
+        {
+            D3D9 = 0,
+            Null,
+            Software
+        };
+
+    private:
+        std::unique_ptr<IDrawManager> m_pManager;
+
+    public:
+        /**
+         * @brief Construct a draw manager for one of the built-in backends.
+         * @param nManagerType The backend to use.
+         * @throws std::invalid_argument If the backend is not available on this platform.
+         * */
+        explicit CDynamicDrawManager(ManagerType_e nManagerType);
+
+        /**
+         * @brief Construct a draw manager around any IDrawManager implementation.
+         * @param pManager The manager to wrap.
+         * */
+        explicit CDynamicDrawManager(std::unique_ptr<IDrawManager> pManager) : m_pManager(std::move(pManager)) {}
+
+        /**
+         * @brief Construct a draw manager for an arbitrary backend type.
+         * @tparam TBackend The backend type.
+         * @return The draw manager.
+         * */
+        template <typename TBackend>
+        static CDynamicDrawManager Create()
+        {
+            return CDynamicDrawManager(std::make_unique<CDrawManagerAdapter<TBackend>>());
+        }
+
+        void Initialize() { m_pManager->Initialize(); }
+        void Shutdown() { m_pManager->Shutdown(); }
+
+        CDrawCommandList *BeginCommandList(uint32_t nOrder) { return m_pManager->BeginCommandList(nOrder); }
+        void EndFrame() { m_pManager->EndFrame(); }
+
+        void SetPipelineDepth(size_t nFrameBuffers) { m_pManager->SetPipelineDepth(nFrameBuffers); }
+        void WaitForRenderThread() { m_pManager->WaitForRenderThread(); }
+
+        void SetViewport(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax) { m_pManager->SetViewport(vecMin, vecMax); }
+        void DisableCulling() { m_pManager->DisableCulling(); }
+        const SCullStats &GetCullStats() const { return m_pManager->GetCullStats(); }
+
+        void SetBatchSorting(bool bEnabled) { m_pManager->SetBatchSorting(bEnabled); }
+        const SBatchStats &GetBatchStats() const { return m_pManager->GetBatchStats(); }
+
+        void SetTransform(const CAffine2D<float> &transform) { m_pManager->SetTransform(transform); }
+        const CAffine2D<float> &GetTransform() const { return m_pManager->GetTransform(); }
+
+        void SetCaptureStream(CDrawStreamWriter *pCaptureStream) { m_pManager->SetCaptureStream(pCaptureStream); }
+        void SubmitFrame(const std::vector<SDrawCommand> &vecCommands) { m_pManager->SubmitFrame(vecCommands); }
+        size_t Replay(CDrawStreamReader &reader) { return m_pManager->Replay(reader); }
+
+        template <typename T = float>
+        void DrawLine(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_pManager->DrawLine(ToFloat(v1), ToFloat(v2));
+        }
+
+        template <typename T = float>
+        void DrawRect(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_pManager->DrawRect(ToFloat(v1), ToFloat(v2));
+        }
+
+        template <typename T = float>
+        void DrawCircle(CVector2D<T> v1, double radius)
+        {
+            m_pManager->DrawCircle(ToFloat(v1), radius);
+        }
+
+        template <typename T = float>
+        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3)
+        {
+            m_pManager->DrawTriangle(ToFloat(v1), ToFloat(v2), ToFloat(v3));
+        }
+
+        void DrawLines(const CVector2D<float> *pStart, const CVector2D<float> *pEnd, const CColorKey *pColors, size_t nCount)
+        {
+            m_pManager->DrawLines(pStart, pEnd, pColors, nCount);
+        }
+
+        void DrawRects(const CVector2D<float> *pMin, const CVector2D<float> *pMax, const CColorKey *pColors, size_t nCount)
+        {
+            m_pManager->DrawRects(pMin, pMax, pColors, nCount);
+        }
+
+        void DrawCircles(const CVector2D<float> *pCenters, const float *pRadii, const CColorKey *pColors, size_t nCount)
+        {
+            m_pManager->DrawCircles(pCenters, pRadii, pColors, nCount);
+        }
+
+        void DrawTriangles(const CVector2D<float> *pVertices, const CColorKey *pColors, size_t nCount)
+        {
+            m_pManager->DrawTriangles(pVertices, pColors, nCount);
+        }
+
+        void DrawIndexedTriangles(const CVector2D<float> *pVertices, const uint32_t *pIndices, size_t nCount, const CColorKey *pColor)
+        {
+            m_pManager->DrawIndexedTriangles(pVertices, pIndices, nCount, pColor);
+        }
+    };
+
+} // namespace Cali
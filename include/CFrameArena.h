@@ -0,0 +1,183 @@
+#pragma once
+
+/**
+ * @file CFrameArena.h
+ * @brief Contains the declaration of the CFrameArena and CFrameArenaResource classes.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace Cali
+{
+    /**
+     * @brief Counters of a CFrameArena.
+     * */
+    struct SArenaStats
+    {
+        /**
+         * @brief Bytes handed out since the last Reset(), including alignment padding.
+         * */
+        size_t m_nBytesUsed = 0;
+
+        /**
+         * @brief Largest m_nBytesUsed seen in any frame. Size the arena to this to never grow it.
+         * */
+        size_t m_nHighWaterMark = 0;
+
+        /**
+         * @brief Bytes currently reserved from the heap.
+         * */
+        size_t m_nBytesReserved = 0;
+
+        /**
+         * @brief Heap blocks currently reserved.
+         * */
+        size_t m_nBlockCount = 0;
+    };
+
+    /**
+     * @class CFrameArena
+     * @brief Bump allocator for transient per-frame data.
+     *
+     * Allocation bumps an offset into the current block and deallocation is a no-op; everything is
+     * released at once by Reset() at the end of a frame. When a frame needs more than one block,
+     * Reset() replaces the blocks by a single block of their combined size, so after a few frames
+     * the arena settles at one allocation that fits the whole frame.
+     *
+     * An arena is not thread-safe. Give each recording thread its own arena, e.g. the one of its
+     * CDrawCommandList.
+     */
+    class CFrameArena
+    {
+    public:
+        static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    private:
+        struct SBlock
+        {
+            std::unique_ptr<unsigned char[]> m_pData;
+            size_t m_nSize = 0;
+        };
+
+        std::vector<SBlock> m_vecBlocks = {};
+        size_t m_nBlockSize = DEFAULT_BLOCK_SIZE;
+        size_t m_nCurrentBlock = 0;
+        size_t m_nOffset = 0;
+
+        SArenaStats m_Stats = {};
+
+        void AddBlock(size_t nMinimumSize)
+        {
+            SBlock &block = m_vecBlocks.emplace_back();
+            block.m_nSize = nMinimumSize > m_nBlockSize ? nMinimumSize : m_nBlockSize;
+            block.m_pData.reset(new unsigned char[block.m_nSize]);
+
+            m_Stats.m_nBytesReserved += block.m_nSize;
+            m_Stats.m_nBlockCount = m_vecBlocks.size();
+        }
+
+    public:
+        /**
+         * @brief Construct an arena.
+         * @param nBlockSize The size of the first block and the minimum size of further blocks.
+         * */
+        explicit CFrameArena(size_t nBlockSize = DEFAULT_BLOCK_SIZE) : m_nBlockSize(nBlockSize) {}
+
+        CFrameArena(const CFrameArena &) = delete;
+        CFrameArena &operator=(const CFrameArena &) = delete;
+
+        /**
+         * @brief Allocate memory that stays valid until the next Reset().
+         * @param nSize The size in bytes.
+         * @param nAlignment The alignment, a power of two.
+         * @return The memory.
+         * */
+        void *Allocate(size_t nSize, size_t nAlignment = alignof(std::max_align_t))
+        {
+            while (m_nCurrentBlock < m_vecBlocks.size())
+            {
+                SBlock &block = m_vecBlocks[m_nCurrentBlock];
+                const uintptr_t nBase = reinterpret_cast<uintptr_t>(block.m_pData.get());
+                const uintptr_t nAligned = (nBase + m_nOffset + nAlignment - 1) & ~static_cast<uintptr_t>(nAlignment - 1);
+                const size_t nEnd = static_cast<size_t>(nAligned - nBase) + nSize;
+
+                if (nEnd <= block.m_nSize)
+                {
+                    m_Stats.m_nBytesUsed += nEnd - m_nOffset;
+                    m_Stats.m_nHighWaterMark = m_Stats.m_nBytesUsed > m_Stats.m_nHighWaterMark ? m_Stats.m_nBytesUsed : m_Stats.m_nHighWaterMark;
+                    m_nOffset = nEnd;
+                    return reinterpret_cast<void *>(nAligned);
+                }
+
+                m_nCurrentBlock++;
+                m_nOffset = 0;
+            }
+
+            AddBlock(nSize + nAlignment);
+            return Allocate(nSize, nAlignment);
+        }
+
+        /**
+         * @brief Allocate uninitialised storage for an array.
+         * @tparam T The element type.
+         * @param nCount The number of elements.
+         * @return The storage.
+         * */
+        template <typename T>
+        T *AllocateArray(size_t nCount)
+        {
+            return static_cast<T *>(Allocate(sizeof(T) * nCount, alignof(T)));
+        }
+
+        /**
+         * @brief Release everything allocated since the last Reset().
+         * Destructors of objects placed in the arena are not run.
+         * */
+        void Reset()
+        {
+            if (m_vecBlocks.size() > 1)
+            {
+                const size_t nTotalSize = m_Stats.m_nBytesReserved;
+                m_vecBlocks.clear();
+                m_Stats.m_nBytesReserved = 0;
+                AddBlock(nTotalSize);
+            }
+
+            m_nCurrentBlock = 0;
+            m_nOffset = 0;
+            m_Stats.m_nBytesUsed = 0;
+        }
+
+        /**
+         * @brief Get the counters of this arena.
+         * @return The counters.
+         * */
+        const SArenaStats &GetStats() const { return m_Stats; }
+    };
+
+    /**
+     * @class CFrameArenaResource
+     * @brief std::pmr::memory_resource adapter so standard containers can allocate from a CFrameArena.
+     *
+     * Containers using it must not outlive the next CFrameArena::Reset().
+     */
+    class CFrameArenaResource : public std::pmr::memory_resource
+    {
+    private:
+        CFrameArena *m_pArena;
+
+    protected:
+        void *do_allocate(size_t nBytes, size_t nAlignment) override { return m_pArena->Allocate(nBytes, nAlignment); }
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    public:
+        explicit CFrameArenaResource(CFrameArena &arena) : m_pArena(&arena) {}
+    };
+
+} // namespace Cali
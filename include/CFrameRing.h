@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * @file CFrameRing.h
+ * @brief Contains the declaration of the CFrameRing class.
+ */
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace Cali
+{
+    /**
+     * @class CFrameRing
+     * @brief Bounded single-producer single-consumer ring of reusable frame buffers.
+     *
+     * The producer blocks in AcquireWrite() while every buffer is still queued or being consumed,
+     * which applies back-pressure and bounds the latency to the number of buffers in use.
+     * Buffers are reused, so their storage is kept between frames.
+     *
+     * @tparam TFrame The frame buffer type.
+     * @tparam MAX_FRAMES The maximum number of buffers.
+     */
+    template <typename TFrame, size_t MAX_FRAMES = 3>
+    class CFrameRing
+    {
+    private:
+        std::array<TFrame, MAX_FRAMES> m_Frames;
+        size_t m_nFrameCount = MAX_FRAMES;
+        size_t m_nWriteIndex = 0;
+        size_t m_nReadIndex = 0;
+        size_t m_nQueued = 0;
+        bool m_bStopped = false;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_CanWrite;
+        std::condition_variable m_CanRead;
+
+    public:
+        /**
+         * @brief Set how many buffers are used, clamped to [1, MAX_FRAMES].
+         * Must not be called while a producer or consumer is active.
+         * @param nFrameCount The number of buffers.
+         * */
+        void SetFrameCount(size_t nFrameCount)
+        {
+            m_nFrameCount = nFrameCount < 1 ? 1 : (nFrameCount > MAX_FRAMES ? MAX_FRAMES : nFrameCount);
+        }
+
+        /**
+         * @brief Get how many buffers are used.
+         * @return The number of buffers.
+         * */
+        size_t GetFrameCount() const { return m_nFrameCount; }
+
+        /**
+         * @brief Reopen the ring after Stop() and drop any queued frames.
+         * */
+        void Reset()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_nWriteIndex = 0;
+            m_nReadIndex = 0;
+            m_nQueued = 0;
+            m_bStopped = false;
+        }
+
+        /**
+         * @brief Wait for a free buffer to fill.
+         * @return The buffer, or nullptr if the ring was stopped.
+         * */
+        TFrame *AcquireWrite()
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_CanWrite.wait(lock, [this]
+                            { return m_bStopped || m_nQueued < m_nFrameCount; });
+
+            return m_bStopped ? nullptr : &m_Frames[m_nWriteIndex];
+        }
+
+        /**
+         * @brief Hand the buffer returned by AcquireWrite() to the consumer.
+         * */
+        void Publish()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_nWriteIndex = (m_nWriteIndex + 1) % m_nFrameCount;
+                m_nQueued++;
+            }
+
+            m_CanRead.notify_one();
+        }
+
+        /**
+         * @brief Wait for the next published buffer.
+         * Queued buffers are still handed out after Stop() so the consumer can drain them.
+         * @return The buffer, or nullptr once the ring is stopped and empty.
+         * */
+        TFrame *AcquireRead()
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_CanRead.wait(lock, [this]
+                           { return m_bStopped || m_nQueued > 0; });
+
+            return m_nQueued > 0 ? &m_Frames[m_nReadIndex] : nullptr;
+        }
+
+        /**
+         * @brief Return the buffer returned by AcquireRead() to the producer.
+         * */
+        void Release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_nReadIndex = (m_nReadIndex + 1) % m_nFrameCount;
+                m_nQueued--;
+            }
+
+            m_CanWrite.notify_all();
+        }
+
+        /**
+         * @brief Wait until the consumer has released every published buffer.
+         * */
+        void WaitForIdle()
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_CanWrite.wait(lock, [this]
+                            { return m_nQueued == 0; });
+        }
+
+        /**
+         * @brief Wake up the producer and consumer and refuse further writes.
+         * */
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_bStopped = true;
+            }
+
+            m_CanWrite.notify_all();
+            m_CanRead.notify_all();
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,376 @@
+#pragma once
+
+/**
+ * @file CFrustumCuller.h
+ * @brief Contains the declaration of the CFrustumCuller class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector3D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief Six planes bounding the visible volume, normals pointing inwards.
+     *
+     * A point p is inside plane i when m_arrPlanes[i][0..2] . p + m_arrPlanes[i][3] >= 0.
+     * */
+    struct SFrustum
+    {
+        static constexpr size_t PLANE_COUNT = 6;
+
+        float m_arrPlanes[PLANE_COUNT][4] = {};
+
+        /**
+         * @brief Set one plane, normalising it so distances are in world units.
+         * @param nPlane The plane index.
+         * @param vecNormal The normal, pointing into the frustum.
+         * @param flDistance The signed distance term.
+         * */
+        void SetPlane(size_t nPlane, const CVector3D<float> &vecNormal, float flDistance)
+        {
+            const float flLength = std::sqrt(vecNormal.GetX() * vecNormal.GetX() + vecNormal.GetY() * vecNormal.GetY() + vecNormal.GetZ() * vecNormal.GetZ());
+            const float flScale = flLength > 0.0f ? 1.0f / flLength : 0.0f;
+
+            m_arrPlanes[nPlane][0] = vecNormal.GetX() * flScale;
+            m_arrPlanes[nPlane][1] = vecNormal.GetY() * flScale;
+            m_arrPlanes[nPlane][2] = vecNormal.GetZ() * flScale;
+            m_arrPlanes[nPlane][3] = flDistance * flScale;
+        }
+
+        /**
+         * @brief Extract the planes of a view-projection matrix (Gribb-Hartmann).
+         * @param arrMatrix Row-major, transforming column vectors: clip = M * (x, y, z, 1), with the D3D depth range 0 <= z <= w.
+         * @return The frustum.
+         * */
+        static SFrustum FromViewProjection(const float (&arrMatrix)[16])
+        {
+            const auto Row = [&](int nRow, int nColumn)
+            { return arrMatrix[nRow * 4 + nColumn]; };
+
+            // Left, right, bottom, top, near and far are w + x, w - x, w + y, w - y, z and w - z.
+            const float arrWeights[PLANE_COUNT][2] = {{1.0f, 1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f}, {0.0f, 1.0f}, {1.0f, -1.0f}};
+            const int arrRows[PLANE_COUNT] = {0, 0, 1, 1, 2, 2};
+
+            SFrustum frustum;
+            for (size_t i = 0; i < PLANE_COUNT; i++)
+            {
+                float arrCoefficients[4];
+                for (int nColumn = 0; nColumn < 4; nColumn++)
+                    arrCoefficients[nColumn] = arrWeights[i][0] * Row(3, nColumn) + arrWeights[i][1] * Row(arrRows[i], nColumn);
+
+                frustum.SetPlane(i, CVector3D<float>(arrCoefficients[0], arrCoefficients[1], arrCoefficients[2]), arrCoefficients[3]);
+            }
+
+            return frustum;
+        }
+    };
+
+    /**
+     * @brief Bounding spheres in SoA layout, the input of CFrustumCuller.
+     * */
+    struct SSphereSet
+    {
+        std::vector<float> m_vecCenterX = {};
+        std::vector<float> m_vecCenterY = {};
+        std::vector<float> m_vecCenterZ = {};
+        std::vector<float> m_vecRadius = {};
+
+        size_t GetCount() const { return m_vecRadius.size(); }
+
+        void Add(const CVector3D<float> &vecCenter, float flRadius)
+        {
+            m_vecCenterX.push_back(vecCenter.GetX());
+            m_vecCenterY.push_back(vecCenter.GetY());
+            m_vecCenterZ.push_back(vecCenter.GetZ());
+            m_vecRadius.push_back(flRadius);
+        }
+
+        void Clear()
+        {
+            m_vecCenterX.clear();
+            m_vecCenterY.clear();
+            m_vecCenterZ.clear();
+            m_vecRadius.clear();
+        }
+    };
+
+    /**
+     * @brief Counters of the last CFrustumCuller::Cull() call.
+     * */
+    struct SFrustumCullStats
+    {
+        size_t m_nSubmitted = 0;
+        size_t m_nVisible = 0;
+
+        /**
+         * @brief Spheres tested on their own, i.e. not settled by their cluster.
+         * */
+        size_t m_nTested = 0;
+
+        size_t m_nClustersCulled = 0;
+        size_t m_nClustersAccepted = 0;
+    };
+
+    /**
+     * @class CFrustumCuller
+     * @brief Tests bounding spheres against a frustum and lists the indices of the visible ones.
+     *
+     * Spheres are tested four at a time against all six planes with SSE2 and the visible indices are
+     * compacted in ascending order. Sets of at least MIN_SPHERES_PER_THREAD spheres per thread are
+     * split into chunks that are culled in parallel and concatenated in order.
+     *
+     * BuildClusters() enables a hierarchical pass: every CLUSTER_SIZE consecutive spheres get a bounding
+     * sphere, and clusters that are completely outside or inside settle all their members at once. Each
+     * cluster remembers the plane that rejected it last, which is tested first the next frame. This pays
+     * off when neighbouring spheres are close in space, e.g. after CSpatialOrder, and the clusters must be
+     * rebuilt when the spheres move.
+     */
+    class CFrustumCuller
+    {
+    public:
+        static constexpr size_t CLUSTER_SIZE = 64;
+        static constexpr size_t CHUNK_SIZE = 256 * CLUSTER_SIZE;
+        static constexpr size_t MIN_SPHERES_PER_THREAD = 64 * 1024;
+
+    private:
+        SFrustumCullStats m_Stats = {};
+
+        SSphereSet m_Clusters = {};
+        std::vector<uint8_t> m_vecClusterPlane = {};
+
+        std::vector<std::vector<uint32_t>> m_vecChunkVisible = {};
+        std::vector<SFrustumCullStats> m_vecChunkStats = {};
+
+        /**
+         * @brief Append the visible spheres of [nBegin, nEnd).
+         * */
+        static void CullRange(const SSphereSet &spheres, const SFrustum &frustum, size_t nBegin, size_t nEnd, std::vector<uint32_t> &vecVisible)
+        {
+            size_t i = nBegin;
+
+#ifdef CALI_SIMD_SSE2
+            __m128 arrPlanes[SFrustum::PLANE_COUNT][4];
+            for (size_t nPlane = 0; nPlane < SFrustum::PLANE_COUNT; nPlane++)
+            {
+                for (size_t j = 0; j < 4; j++)
+                    arrPlanes[nPlane][j] = _mm_set1_ps(frustum.m_arrPlanes[nPlane][j]);
+            }
+
+            for (; i + 4 <= nEnd; i += 4)
+            {
+                const __m128 vecX = _mm_loadu_ps(&spheres.m_vecCenterX[i]);
+                const __m128 vecY = _mm_loadu_ps(&spheres.m_vecCenterY[i]);
+                const __m128 vecZ = _mm_loadu_ps(&spheres.m_vecCenterZ[i]);
+                const __m128 vecNegRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.m_vecRadius[i]));
+
+                __m128 vecOutside = _mm_setzero_ps();
+                for (size_t nPlane = 0; nPlane < SFrustum::PLANE_COUNT; nPlane++)
+                {
+                    const __m128 vecDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vecX, arrPlanes[nPlane][0]), _mm_mul_ps(vecY, arrPlanes[nPlane][1])),
+                                                          _mm_add_ps(_mm_mul_ps(vecZ, arrPlanes[nPlane][2]), arrPlanes[nPlane][3]));
+                    vecOutside = _mm_or_ps(vecOutside, _mm_cmplt_ps(vecDistance, vecNegRadius));
+                }
+
+                const int nOutside = _mm_movemask_ps(vecOutside);
+                for (int nLane = 0; nLane < 4; nLane++)
+                {
+                    if (!(nOutside & (1 << nLane)))
+                        vecVisible.push_back(static_cast<uint32_t>(i + nLane));
+                }
+            }
+#endif
+
+            for (; i < nEnd; i++)
+            {
+                if (Classify(frustum, spheres.m_vecCenterX[i], spheres.m_vecCenterY[i], spheres.m_vecCenterZ[i], spheres.m_vecRadius[i], nullptr) >= 0)
+                    vecVisible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        /**
+         * @brief Classify one sphere: -1 outside, 0 intersecting, 1 inside.
+         * @param pPlane If set, the plane tested first, updated to the plane that rejected the sphere.
+         * */
+        static int Classify(const SFrustum &frustum, float flX, float flY, float flZ, float flRadius, uint8_t *pPlane)
+        {
+            int nResult = 1;
+
+            for (size_t j = 0; j < SFrustum::PLANE_COUNT; j++)
+            {
+                const size_t nPlane = pPlane ? (*pPlane + j) % SFrustum::PLANE_COUNT : j;
+                const float *pCoefficients = frustum.m_arrPlanes[nPlane];
+                const float flDistance = flX * pCoefficients[0] + flY * pCoefficients[1] + (flZ * pCoefficients[2] + pCoefficients[3]);
+
+                if (flDistance < -flRadius)
+                {
+                    if (pPlane)
+                        *pPlane = static_cast<uint8_t>(nPlane);
+
+                    return -1;
+                }
+
+                if (flDistance < flRadius)
+                    nResult = 0;
+            }
+
+            return nResult;
+        }
+
+        void CullChunk(const SSphereSet &spheres, const SFrustum &frustum, size_t nBegin, size_t nEnd, std::vector<uint32_t> &vecVisible, SFrustumCullStats &stats)
+        {
+            if (m_Clusters.GetCount() == 0)
+            {
+                CullRange(spheres, frustum, nBegin, nEnd, vecVisible);
+                stats.m_nTested += nEnd - nBegin;
+                return;
+            }
+
+            for (size_t nFirst = nBegin; nFirst < nEnd; nFirst += CLUSTER_SIZE)
+            {
+                const size_t nCluster = nFirst / CLUSTER_SIZE;
+                const size_t nLast = std::min(nEnd, nFirst + CLUSTER_SIZE);
+
+                switch (Classify(frustum, m_Clusters.m_vecCenterX[nCluster], m_Clusters.m_vecCenterY[nCluster], m_Clusters.m_vecCenterZ[nCluster],
+                                 m_Clusters.m_vecRadius[nCluster], &m_vecClusterPlane[nCluster]))
+                {
+                case -1:
+                    stats.m_nClustersCulled++;
+                    break;
+                case 1:
+                    stats.m_nClustersAccepted++;
+                    for (size_t i = nFirst; i < nLast; i++)
+                        vecVisible.push_back(static_cast<uint32_t>(i));
+                    break;
+                default:
+                    CullRange(spheres, frustum, nFirst, nLast, vecVisible);
+                    stats.m_nTested += nLast - nFirst;
+                    break;
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Get the counters of the last Cull() call.
+         * */
+        const SFrustumCullStats &GetStats() const { return m_Stats; }
+
+        /**
+         * @brief Bound every CLUSTER_SIZE consecutive spheres to enable the hierarchical pass.
+         * Call again whenever the spheres move, or ClearClusters() to disable it.
+         * */
+        void BuildClusters(const SSphereSet &spheres)
+        {
+            CALI_PROFILE_SCOPE("CFrustumCuller::BuildClusters");
+
+            const size_t nCount = spheres.GetCount();
+            const size_t nClusters = (nCount + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+            m_Clusters.Clear();
+            m_vecClusterPlane.assign(nClusters, 0);
+
+            for (size_t nCluster = 0; nCluster < nClusters; nCluster++)
+            {
+                const size_t nFirst = nCluster * CLUSTER_SIZE;
+                const size_t nLast = std::min(nCount, nFirst + CLUSTER_SIZE);
+
+                // Centre on the bounds of the member centres, then grow to enclose every member.
+                float arrMin[3] = {spheres.m_vecCenterX[nFirst], spheres.m_vecCenterY[nFirst], spheres.m_vecCenterZ[nFirst]};
+                float arrMax[3] = {arrMin[0], arrMin[1], arrMin[2]};
+
+                for (size_t i = nFirst + 1; i < nLast; i++)
+                {
+                    const float arrCenter[3] = {spheres.m_vecCenterX[i], spheres.m_vecCenterY[i], spheres.m_vecCenterZ[i]};
+                    for (size_t j = 0; j < 3; j++)
+                    {
+                        arrMin[j] = std::min(arrMin[j], arrCenter[j]);
+                        arrMax[j] = std::max(arrMax[j], arrCenter[j]);
+                    }
+                }
+
+                const CVector3D<float> vecCenter((arrMin[0] + arrMax[0]) * 0.5f, (arrMin[1] + arrMax[1]) * 0.5f, (arrMin[2] + arrMax[2]) * 0.5f);
+                float flRadius = 0.0f;
+
+                for (size_t i = nFirst; i < nLast; i++)
+                {
+                    const float flDeltaX = spheres.m_vecCenterX[i] - vecCenter.GetX();
+                    const float flDeltaY = spheres.m_vecCenterY[i] - vecCenter.GetY();
+                    const float flDeltaZ = spheres.m_vecCenterZ[i] - vecCenter.GetZ();
+                    flRadius = std::max(flRadius, std::sqrt(flDeltaX * flDeltaX + flDeltaY * flDeltaY + flDeltaZ * flDeltaZ) + spheres.m_vecRadius[i]);
+                }
+
+                // Absorb float rounding so no member pokes out of its cluster.
+                m_Clusters.Add(vecCenter, flRadius * (1.0f + 1e-6f) + 1e-6f);
+            }
+        }
+
+        void ClearClusters()
+        {
+            m_Clusters.Clear();
+            m_vecClusterPlane.clear();
+        }
+
+        /**
+         * @brief List the spheres that intersect the frustum.
+         * @param spheres The spheres. If clusters are built they must have been built from this set.
+         * @param frustum The frustum.
+         * @param vecVisible Receives the indices of the visible spheres, ascending.
+         * */
+        void Cull(const SSphereSet &spheres, const SFrustum &frustum, std::vector<uint32_t> &vecVisible)
+        {
+            CALI_PROFILE_SCOPE("CFrustumCuller::Cull");
+
+            const size_t nCount = spheres.GetCount();
+            if (m_Clusters.GetCount() != (nCount + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+                ClearClusters();
+
+            m_Stats = SFrustumCullStats();
+            m_Stats.m_nSubmitted = nCount;
+            vecVisible.clear();
+
+            const size_t nChunks = (nCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            if (nCount < 2 * MIN_SPHERES_PER_THREAD || CParallel::GetThreadCount() == 1)
+            {
+                CullChunk(spheres, frustum, 0, nCount, vecVisible, m_Stats);
+                m_Stats.m_nVisible = vecVisible.size();
+                return;
+            }
+
+            m_vecChunkVisible.resize(nChunks);
+            m_vecChunkStats.assign(nChunks, SFrustumCullStats());
+
+            CParallel::For(nChunks, MIN_SPHERES_PER_THREAD / CHUNK_SIZE, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                               {
+                                   m_vecChunkVisible[nChunk].clear();
+                                   CullChunk(spheres, frustum, nChunk * CHUNK_SIZE, std::min(nCount, (nChunk + 1) * CHUNK_SIZE), m_vecChunkVisible[nChunk], m_vecChunkStats[nChunk]);
+                               } });
+
+            size_t nVisible = 0;
+            for (const std::vector<uint32_t> &vecChunk : m_vecChunkVisible)
+                nVisible += vecChunk.size();
+
+            vecVisible.reserve(nVisible);
+            for (size_t nChunk = 0; nChunk < nChunks; nChunk++)
+            {
+                vecVisible.insert(vecVisible.end(), m_vecChunkVisible[nChunk].begin(), m_vecChunkVisible[nChunk].end());
+                m_Stats.m_nTested += m_vecChunkStats[nChunk].m_nTested;
+                m_Stats.m_nClustersCulled += m_vecChunkStats[nChunk].m_nClustersCulled;
+                m_Stats.m_nClustersAccepted += m_vecChunkStats[nChunk].m_nClustersAccepted;
+            }
+
+            m_Stats.m_nVisible = vecVisible.size();
+        }
+    };
+
+} // namespace Cali
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cmath>
 #include <vector>
 #include <type_traits>
+#include "Constants.h"
+#include "CProfiler.h"
 
 namespace Cali
 {
@@ -17,10 +20,12 @@ namespace Cali
 
         void CalculateGaussian()
         {
+            CALI_PROFILE_SCOPE("CGaussian::CalculateGaussian");
+
             for (int i = 0; i < m_Data.size(); i++)
             {
                 m_Calculated[i] = exp(-(m_Data[i] - m_Mean) * (m_Data[i] - m_Mean) / (2 * m_Std * m_Std));
-                m_Calculated[i] /= sqrt(2 * M_PI) * m_Std;
+                m_Calculated[i] /= sqrt(2 * CONST_PI) * m_Std;
             }
         }
 
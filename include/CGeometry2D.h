@@ -0,0 +1,465 @@
+#pragma once
+
+/**
+ * @file CGeometry2D.h
+ * @brief Contains the declaration of the CGeometry2D class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "CVectorReduction.h"
+
+namespace Cali
+{
+    /**
+     * @class CGeometry2D
+     * @brief Robust 2D geometry kernels over CVector2D sets: orientation, convex hull and minimum-area rectangle.
+     *
+     * Orient2D() is Shewchuk's adaptive predicate: a floating-point filter that falls back to exact
+     * expansion arithmetic when the sign is in doubt, so hulls never fold over on nearly collinear
+     * points. It relies on IEEE double rounding, so it must not be compiled with -ffast-math, and
+     * coordinates must be far enough from the double range that products neither overflow nor underflow.
+     *
+     * ComputeConvexHull() runs Andrew's monotone chain. The input is cut into chunks of CHUNK_SIZE
+     * points, independent of the thread count. Every chunk drops the points strictly inside the octagon
+     * of the 8 extreme points of the whole set (Akl-Toussaint), then sorts and hulls its survivors in
+     * parallel. The sorted chunk hulls are merged and hulled once more, so the result does not depend
+     * on the thread count.
+     */
+    class CGeometry2D
+    {
+    public:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    private:
+        /**
+         * @brief Relative error bound of the filtered Orient2D() determinant, (3 + 16 eps) eps.
+         * */
+        static constexpr double ORIENT_ERROR_BOUND = (3.0 + 16.0 * std::numeric_limits<double>::epsilon() * 0.5) * std::numeric_limits<double>::epsilon() * 0.5;
+
+        static constexpr size_t EXTREME_COUNT = 8;
+
+        /**
+         * @brief x + y = flSum + flError exactly.
+         * */
+        static void TwoSum(double a, double b, double &flSum, double &flError)
+        {
+            flSum = a + b;
+            const double flVirtualB = flSum - a;
+            const double flVirtualA = flSum - flVirtualB;
+            flError = (a - flVirtualA) + (b - flVirtualB);
+        }
+
+        /**
+         * @brief a * b = flProduct + flError exactly, with Dekker's split.
+         * */
+        static void TwoProduct(double a, double b, double &flProduct, double &flError)
+        {
+            const auto Split = [](double flValue, double &flHigh, double &flLow)
+            {
+                const double flScaled = 134217729.0 * flValue;
+                flHigh = flScaled - (flScaled - flValue);
+                flLow = flValue - flHigh;
+            };
+
+            double flHighA, flLowA, flHighB, flLowB;
+            Split(a, flHighA, flLowA);
+            Split(b, flHighB, flLowB);
+
+            flProduct = a * b;
+            flError = flLowA * flLowB - (((flProduct - flHighA * flHighB) - flLowA * flHighB) - flHighA * flLowB);
+        }
+
+        /**
+         * @brief Exact sign of the orientation determinant, from the six products it expands to.
+         * @return The largest component of the exact determinant, which carries its sign.
+         * */
+        static double Orient2DExact(double flAX, double flAY, double flBX, double flBY, double flCX, double flCY)
+        {
+            const double arrFactors[6][2] = {{flAX, flBY}, {-flAX, flCY}, {-flCX, flBY}, {-flAY, flBX}, {flAY, flCX}, {flCY, flBX}};
+
+            // Grow a nonoverlapping expansion, smallest component first, dropping zeros.
+            double arrExpansion[12];
+            size_t nLength = 0;
+
+            for (size_t i = 0; i < 6; i++)
+            {
+                double arrTerms[2];
+                TwoProduct(arrFactors[i][0], arrFactors[i][1], arrTerms[1], arrTerms[0]);
+
+                for (double flTerm : arrTerms)
+                {
+                    size_t nNewLength = 0;
+                    double flCarry = flTerm;
+
+                    for (size_t j = 0; j < nLength; j++)
+                    {
+                        double flError;
+                        TwoSum(flCarry, arrExpansion[j], flCarry, flError);
+                        if (flError != 0.0)
+                            arrExpansion[nNewLength++] = flError;
+                    }
+
+                    if (flCarry != 0.0)
+                        arrExpansion[nNewLength++] = flCarry;
+
+                    nLength = nNewLength;
+                }
+            }
+
+            return nLength ? arrExpansion[nLength - 1] : 0.0;
+        }
+
+        template <typename T>
+        static bool IsLess(const CVector2D<T> &a, const CVector2D<T> &b)
+        {
+            return a.GetX() < b.GetX() || (a.GetX() == b.GetX() && a.GetY() < b.GetY());
+        }
+
+        /**
+         * @brief Hull sorted, distinct points with the monotone chain, counter-clockwise.
+         * */
+        template <typename T>
+        static void MonotoneChain(const std::vector<CVector2D<T>> &vecSorted, std::vector<CVector2D<T>> &vecHull)
+        {
+            vecHull.clear();
+
+            const size_t nCount = vecSorted.size();
+            if (nCount < 3)
+            {
+                vecHull = vecSorted;
+                return;
+            }
+
+            vecHull.resize(2 * nCount);
+            size_t nSize = 0;
+
+            // Lower chain left to right, then upper chain right to left; a point is popped unless it turns left.
+            for (size_t i = 0; i < nCount; i++)
+            {
+                while (nSize >= 2 && Orient2D(vecHull[nSize - 2], vecHull[nSize - 1], vecSorted[i]) <= 0.0)
+                    nSize--;
+
+                vecHull[nSize++] = vecSorted[i];
+            }
+
+            for (size_t i = nCount - 1, nLower = nSize + 1; i-- > 0;)
+            {
+                while (nSize >= nLower && Orient2D(vecHull[nSize - 2], vecHull[nSize - 1], vecSorted[i]) <= 0.0)
+                    nSize--;
+
+                vecHull[nSize++] = vecSorted[i];
+            }
+
+            // The last point repeats the first.
+            vecHull.resize(nSize - 1);
+        }
+
+        /**
+         * @brief The points furthest along 8 directions, 45 degrees apart counter-clockwise from +X.
+         * */
+        struct SExtremes
+        {
+            double m_arrProjections[EXTREME_COUNT];
+            size_t m_arrIndices[EXTREME_COUNT] = {};
+
+            SExtremes() { std::fill(std::begin(m_arrProjections), std::end(m_arrProjections), -std::numeric_limits<double>::infinity()); }
+
+            /**
+             * @brief Keep the furthest of both; ties keep this one, so merging in order keeps the first point.
+             * */
+            void Merge(const SExtremes &other)
+            {
+                for (size_t j = 0; j < EXTREME_COUNT; j++)
+                {
+                    if (other.m_arrProjections[j] > m_arrProjections[j])
+                    {
+                        m_arrProjections[j] = other.m_arrProjections[j];
+                        m_arrIndices[j] = other.m_arrIndices[j];
+                    }
+                }
+            }
+        };
+
+        template <typename T>
+        static void FindExtremes(const CVector2D<T> *pPoints, size_t nBegin, size_t nEnd, SExtremes &extremes)
+        {
+            for (size_t i = nBegin; i < nEnd; i++)
+            {
+                const double flX = static_cast<double>(pPoints[i].GetX());
+                const double flY = static_cast<double>(pPoints[i].GetY());
+                const double arrProjections[EXTREME_COUNT] = {flX, flX + flY, flY, flY - flX, -flX, -flX - flY, -flY, flX - flY};
+
+                for (size_t j = 0; j < EXTREME_COUNT; j++)
+                {
+                    if (arrProjections[j] > extremes.m_arrProjections[j])
+                    {
+                        extremes.m_arrProjections[j] = arrProjections[j];
+                        extremes.m_arrIndices[j] = i;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Sort points and drop duplicates, as MonotoneChain() expects.
+         * */
+        template <typename T>
+        static void SortUnique(std::vector<CVector2D<T>> &vecPoints)
+        {
+            std::sort(vecPoints.begin(), vecPoints.end(), IsLess<T>);
+            vecPoints.erase(std::unique(vecPoints.begin(), vecPoints.end()), vecPoints.end());
+        }
+
+    public:
+        /**
+         * @brief Orientation of the triangle a, b, c.
+         * @return Positive when a, b, c turn counter-clockwise, negative when clockwise and 0 when collinear.
+         * The sign is exact; the magnitude approximates twice the signed area.
+         * */
+        static double Orient2D(double flAX, double flAY, double flBX, double flBY, double flCX, double flCY)
+        {
+            const double flDetLeft = (flAX - flCX) * (flBY - flCY);
+            const double flDetRight = (flAY - flCY) * (flBX - flCX);
+            const double flDet = flDetLeft - flDetRight;
+
+            const double flBound = ORIENT_ERROR_BOUND * (std::fabs(flDetLeft) + std::fabs(flDetRight));
+            if (flDet >= flBound || -flDet >= flBound)
+                return flDet;
+
+            return Orient2DExact(flAX, flAY, flBX, flBY, flCX, flCY);
+        }
+
+        template <typename T>
+        static double Orient2D(const CVector2D<T> &a, const CVector2D<T> &b, const CVector2D<T> &c)
+        {
+            return Orient2D(static_cast<double>(a.GetX()), static_cast<double>(a.GetY()), static_cast<double>(b.GetX()), static_cast<double>(b.GetY()),
+                            static_cast<double>(c.GetX()), static_cast<double>(c.GetY()));
+        }
+
+        /**
+         * @brief Compute the convex hull of a point set.
+         * @param pPoints The points.
+         * @param nCount The number of points.
+         * @param vecHull Receives the hull vertices counter-clockwise, starting at the lowest X (then Y), without
+         * collinear points. Fewer than 3 vertices are returned for degenerate sets.
+         * */
+        template <typename T>
+        static void ComputeConvexHull(const CVector2D<T> *pPoints, size_t nCount, std::vector<CVector2D<T>> &vecHull)
+        {
+            CALI_PROFILE_SCOPE("CGeometry2D::ComputeConvexHull");
+
+            vecHull.clear();
+            if (nCount == 0)
+                return;
+
+            const size_t nChunks = (nCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            std::vector<SExtremes> vecChunkExtremes(nChunks);
+
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                                   FindExtremes(pPoints, nChunk * CHUNK_SIZE, std::min(nCount, (nChunk + 1) * CHUNK_SIZE), vecChunkExtremes[nChunk]);
+                           });
+
+            // Merge in chunk order so ties resolve the same on any thread count.
+            SExtremes extremes;
+            for (const SExtremes &chunkExtremes : vecChunkExtremes)
+                extremes.Merge(chunkExtremes);
+
+            std::vector<CVector2D<T>> vecOctagon;
+            for (size_t j = 0; j < EXTREME_COUNT; j++)
+            {
+                if (vecOctagon.empty() || !(vecOctagon.back() == pPoints[extremes.m_arrIndices[j]]))
+                    vecOctagon.push_back(pPoints[extremes.m_arrIndices[j]]);
+            }
+
+            while (vecOctagon.size() > 1 && vecOctagon.back() == vecOctagon.front())
+                vecOctagon.pop_back();
+
+            // A point strictly left of every octagon edge is strictly inside the hull.
+            const auto IsInterior = [&](const CVector2D<T> &vec)
+            {
+                if (vecOctagon.size() < 3)
+                    return false;
+
+                for (size_t j = 0; j < vecOctagon.size(); j++)
+                {
+                    if (Orient2D(vecOctagon[j], vecOctagon[(j + 1) % vecOctagon.size()], vec) <= 0.0)
+                        return false;
+                }
+
+                return true;
+            };
+
+            std::vector<std::vector<CVector2D<T>>> vecChunkHulls(nChunks);
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               std::vector<CVector2D<T>> vecSurvivors;
+
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                               {
+                                   vecSurvivors.clear();
+                                   for (size_t i = nChunk * CHUNK_SIZE; i < std::min(nCount, (nChunk + 1) * CHUNK_SIZE); i++)
+                                   {
+                                       if (!IsInterior(pPoints[i]))
+                                           vecSurvivors.push_back(pPoints[i]);
+                                   }
+
+                                   SortUnique(vecSurvivors);
+                                   MonotoneChain(vecSurvivors, vecChunkHulls[nChunk]);
+
+                                   // Back into sorted order: the lower chain ascends up to the greatest point, the upper chain descends.
+                                   // A chunk whose points all lie inside the octagon has an empty hull, and one point is sorted already.
+                                   std::vector<CVector2D<T>> &vecChunkHull = vecChunkHulls[nChunk];
+                                   if (vecChunkHull.size() < 2)
+                                       continue;
+
+                                   const auto itSplit = std::max_element(vecChunkHull.begin(), vecChunkHull.end(), IsLess<T>) + 1;
+                                   std::reverse(itSplit, vecChunkHull.end());
+                                   std::inplace_merge(vecChunkHull.begin(), itSplit, vecChunkHull.end(), IsLess<T>);
+                               } });
+
+            // Merge the sorted chunk hulls pairwise rather than sorting them again, which matters when most points are on the hull.
+            std::vector<CVector2D<T>> vecMerged;
+            std::vector<size_t> vecRuns = {0};
+            for (const std::vector<CVector2D<T>> &vecChunkHull : vecChunkHulls)
+            {
+                vecMerged.insert(vecMerged.end(), vecChunkHull.begin(), vecChunkHull.end());
+                vecRuns.push_back(vecMerged.size());
+            }
+
+            for (size_t nWidth = 1; nWidth < nChunks; nWidth *= 2)
+            {
+                CParallel::For((nChunks + 2 * nWidth - 1) / (2 * nWidth), 1, [&](size_t nBegin, size_t nEnd)
+                               {
+                                   for (size_t nPair = nBegin; nPair < nEnd; nPair++)
+                                   {
+                                       const size_t nRun = nPair * 2 * nWidth;
+                                       if (nRun + nWidth < nChunks)
+                                           std::inplace_merge(vecMerged.begin() + vecRuns[nRun], vecMerged.begin() + vecRuns[nRun + nWidth],
+                                                              vecMerged.begin() + vecRuns[std::min(nChunks, nRun + 2 * nWidth)], IsLess<T>);
+                                   } });
+            }
+
+            // The octagon corners always survive, so at least one point is left.
+            vecMerged.erase(std::unique(vecMerged.begin(), vecMerged.end()), vecMerged.end());
+            MonotoneChain(vecMerged, vecHull);
+        }
+
+        /**
+         * @brief Compute the smallest-area rectangle enclosing a convex hull, with rotating calipers.
+         *
+         * One side of the smallest rectangle lies on a hull edge, so every edge is tried while three
+         * calipers track the extreme points along it and its normal, in O(n) overall.
+         *
+         * @param pHull The hull vertices counter-clockwise, as ComputeConvexHull() returns them.
+         * @param nCount The number of vertices.
+         * @return The rectangle, longer axis first, with zero extents if nCount is 0.
+         * */
+        template <typename T>
+        static SOrientedBox<2> ComputeMinAreaRectangle(const CVector2D<T> *pHull, size_t nCount)
+        {
+            CALI_PROFILE_SCOPE("CGeometry2D::ComputeMinAreaRectangle");
+
+            SOrientedBox<2> box;
+            box.m_arrAxes[0][0] = 1.0;
+            box.m_arrAxes[1][1] = 1.0;
+
+            if (nCount == 0)
+                return box;
+
+            const auto GetX = [&](size_t i)
+            { return static_cast<double>(pHull[i % nCount].GetX()); };
+            const auto GetY = [&](size_t i)
+            { return static_cast<double>(pHull[i % nCount].GetY()); };
+
+            if (nCount < 3)
+            {
+                const double flDeltaX = GetX(1) - GetX(0);
+                const double flDeltaY = GetY(1) - GetY(0);
+                const double flLength = std::sqrt(flDeltaX * flDeltaX + flDeltaY * flDeltaY);
+
+                box.m_arrCenter[0] = (GetX(0) + GetX(1)) * 0.5;
+                box.m_arrCenter[1] = (GetY(0) + GetY(1)) * 0.5;
+                if (flLength > 0.0)
+                {
+                    box.m_arrAxes[0][0] = flDeltaX / flLength;
+                    box.m_arrAxes[0][1] = flDeltaY / flLength;
+                    box.m_arrAxes[1][0] = -box.m_arrAxes[0][1];
+                    box.m_arrAxes[1][1] = box.m_arrAxes[0][0];
+                    box.m_arrHalfExtents[0] = flLength * 0.5;
+                }
+
+                return box;
+            }
+
+            double flBestArea = std::numeric_limits<double>::infinity();
+            size_t nFront = 0, nTop = 0, nBack = 0;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const double flDeltaX = GetX(i + 1) - GetX(i);
+                const double flDeltaY = GetY(i + 1) - GetY(i);
+                const double flLength = std::sqrt(flDeltaX * flDeltaX + flDeltaY * flDeltaY);
+                if (!(flLength > 0.0))
+                    continue;
+
+                // Edge direction u and inward normal v, measured from the edge start.
+                const double flUX = flDeltaX / flLength, flUY = flDeltaY / flLength;
+                const auto ProjectU = [&](size_t j)
+                { return (GetX(j) - GetX(i)) * flUX + (GetY(j) - GetY(i)) * flUY; };
+                const auto ProjectV = [&](size_t j)
+                { return (GetY(j) - GetY(i)) * flUX - (GetX(j) - GetX(i)) * flUY; };
+
+                // The calipers only ever move forwards; the first edge starts them from its own end.
+                if (flBestArea == std::numeric_limits<double>::infinity())
+                    nFront = nTop = nBack = i + 1;
+
+                for (size_t nStep = 0; nStep < nCount && ProjectU(nFront + 1) > ProjectU(nFront); nStep++)
+                    nFront++;
+
+                nTop = std::max(nTop, nFront);
+                for (size_t nStep = 0; nStep < nCount && ProjectV(nTop + 1) > ProjectV(nTop); nStep++)
+                    nTop++;
+
+                nBack = std::max(nBack, nTop);
+                for (size_t nStep = 0; nStep < nCount && ProjectU(nBack + 1) < ProjectU(nBack); nStep++)
+                    nBack++;
+
+                const double flMaxU = ProjectU(nFront);
+                const double flMinU = ProjectU(nBack);
+                const double flMaxV = ProjectV(nTop);
+                const double flArea = (flMaxU - flMinU) * flMaxV;
+
+                if (flArea < flBestArea)
+                {
+                    flBestArea = flArea;
+
+                    const double flMidU = (flMinU + flMaxU) * 0.5;
+                    const double flMidV = flMaxV * 0.5;
+                    box.m_arrCenter[0] = GetX(i) + flUX * flMidU - flUY * flMidV;
+                    box.m_arrCenter[1] = GetY(i) + flUY * flMidU + flUX * flMidV;
+
+                    const bool bSwap = flMaxV > flMaxU - flMinU;
+                    box.m_arrAxes[bSwap][0] = flUX;
+                    box.m_arrAxes[bSwap][1] = flUY;
+                    box.m_arrAxes[!bSwap][0] = -flUY;
+                    box.m_arrAxes[!bSwap][1] = flUX;
+                    box.m_arrHalfExtents[bSwap] = (flMaxU - flMinU) * 0.5;
+                    box.m_arrHalfExtents[!bSwap] = flMidV;
+                }
+            }
+
+            return box;
+        }
+    };
+
+} // namespace Cali
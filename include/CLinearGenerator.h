@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <type_traits>
+#include "CProfiler.h"
 
 namespace Cali
 {
@@ -18,6 +19,8 @@ namespace Cali
 
         void CalculateLinear()
         {
+            CALI_PROFILE_SCOPE("CLinearGenerator::CalculateLinear");
+
             for (int i = m_Min; i < (m_Max - m_Min); i++)
                 m_Calculated[i] = i * m_Step;
         }
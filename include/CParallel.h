@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * @file CParallel.h
+ * @brief Contains the declaration of the CParallel class.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace Cali
+{
+    /**
+     * @class CParallel
+     * @brief Splits loops over independent items across threads.
+     *
+     * Threads are started per call, so only hand it work that takes well over the cost of starting a
+     * thread per chunk; smaller loops run on the calling thread. If threads cannot be started the
+     * remaining chunks also run on the calling thread.
+     */
+    class CParallel
+    {
+    public:
+        /**
+         * @brief Get the number of threads parallel loops use.
+         * @return At least one.
+         * */
+        static size_t GetThreadCount()
+        {
+            const unsigned int nThreads = std::thread::hardware_concurrency();
+            return nThreads ? nThreads : 1;
+        }
+
+        /**
+         * @brief Call fnRange(nBegin, nEnd) over disjoint ranges covering [0, nCount).
+         * @param nCount The number of items.
+         * @param nMinItemsPerThread The smallest range worth a thread of its own.
+         * @param fnRange The function, called concurrently with different ranges.
+         * */
+        template <typename TFunc>
+        static void For(size_t nCount, size_t nMinItemsPerThread, TFunc fnRange)
+        {
+            const size_t nMaxChunks = nMinItemsPerThread ? nCount / nMinItemsPerThread : nCount;
+            const size_t nChunks = std::max<size_t>(1, std::min(GetThreadCount(), nMaxChunks));
+
+            if (nChunks == 1)
+            {
+                if (nCount)
+                    fnRange(size_t(0), nCount);
+
+                return;
+            }
+
+            const size_t nChunkSize = (nCount + nChunks - 1) / nChunks;
+            std::vector<std::thread> vecThreads;
+            vecThreads.reserve(nChunks - 1);
+
+            // The calling thread takes the first chunk itself.
+            size_t nBegin = nChunkSize;
+            for (; nBegin < nCount; nBegin += nChunkSize)
+            {
+                const size_t nEnd = std::min(nBegin + nChunkSize, nCount);
+
+                try
+                {
+                    vecThreads.emplace_back(fnRange, nBegin, nEnd);
+                }
+                catch (const std::system_error &)
+                {
+                    break;
+                }
+            }
+
+            fnRange(size_t(0), std::min(nChunkSize, nCount));
+
+            for (; nBegin < nCount; nBegin += nChunkSize)
+                fnRange(nBegin, std::min(nBegin + nChunkSize, nCount));
+
+            for (std::thread &thread : vecThreads)
+                thread.join();
+        }
+    };
+
+} // namespace Cali
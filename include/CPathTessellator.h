@@ -0,0 +1,471 @@
+#pragma once
+
+/**
+ * @file CPathTessellator.h
+ * @brief Contains the declaration of the CPathTessellator class.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "CDrawCommand.h"
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @brief A filled shape: the first contour is the outline, every further contour a hole in it.
+     * Contours are closed implicitly and may have either winding.
+     * */
+    struct SPath
+    {
+        std::vector<std::vector<CVector2D<float>>> m_vecContours = {};
+    };
+
+    /**
+     * @brief An indexed triangle batch, three indices per triangle.
+     * */
+    struct STessellation
+    {
+        std::vector<CVector2D<float>> m_vecVertices = {};
+        std::vector<uint32_t> m_vecIndices = {};
+
+        size_t GetTriangleCount() const { return m_vecIndices.size() / 3; }
+    };
+
+    /**
+     * @class CPathTessellator
+     * @brief Triangulates concave polygons with holes by ear clipping.
+     *
+     * Holes are joined to the outline by a bridge to a mutually visible vertex, turning the path into a
+     * single weakly simple polygon that is then clipped ear by ear. Self-intersecting paths still produce
+     * triangles but not necessarily the expected fill.
+     *
+     * Results of Tessellate() are cached by the contents of the path, so static shapes are only
+     * triangulated once. TessellateBatch() triangulates the misses of many paths in parallel.
+     */
+    class CPathTessellator
+    {
+    public:
+        static constexpr size_t DEFAULT_MAX_CACHE_ENTRIES = 1024;
+        static constexpr size_t MIN_PATHS_PER_THREAD = 16;
+
+    private:
+        struct SCacheEntry
+        {
+            SPath m_Path;
+            STessellation m_Tessellation;
+        };
+
+        std::unordered_multimap<uint64_t, SCacheEntry> m_Cache = {};
+        size_t m_nMaxCacheEntries = DEFAULT_MAX_CACHE_ENTRIES;
+        size_t m_nCacheHits = 0;
+        size_t m_nCacheMisses = 0;
+
+        static float Cross(const CVector2D<float> &a, const CVector2D<float> &b, const CVector2D<float> &c)
+        {
+            return (b.GetX() - a.GetX()) * (c.GetY() - a.GetY()) - (b.GetY() - a.GetY()) * (c.GetX() - a.GetX());
+        }
+
+        static bool IsEqual(const CVector2D<float> &a, const CVector2D<float> &b)
+        {
+            return a.GetX() == b.GetX() && a.GetY() == b.GetY();
+        }
+
+        static bool IsInTriangle(const CVector2D<float> &a, const CVector2D<float> &b, const CVector2D<float> &c, const CVector2D<float> &p)
+        {
+            return Cross(a, b, p) >= 0.0f && Cross(b, c, p) >= 0.0f && Cross(c, a, p) >= 0.0f;
+        }
+
+        static uint64_t Hash(const SPath &path)
+        {
+            uint64_t nHash = 14695981039346656037ull;
+            const auto Mix = [&nHash](uint32_t nValue)
+            { nHash = (nHash ^ nValue) * 1099511628211ull; };
+
+            for (const std::vector<CVector2D<float>> &vecContour : path.m_vecContours)
+            {
+                Mix(static_cast<uint32_t>(vecContour.size()));
+                for (const CVector2D<float> &vec : vecContour)
+                {
+                    const float flCoordinates[2] = {vec.GetX(), vec.GetY()};
+                    uint32_t nBits[2];
+                    std::memcpy(nBits, flCoordinates, sizeof(nBits));
+                    Mix(nBits[0]);
+                    Mix(nBits[1]);
+                }
+            }
+
+            return nHash;
+        }
+
+        static bool IsSamePath(const SPath &a, const SPath &b)
+        {
+            if (a.m_vecContours.size() != b.m_vecContours.size())
+                return false;
+
+            for (size_t i = 0; i < a.m_vecContours.size(); i++)
+            {
+                const std::vector<CVector2D<float>> &vecA = a.m_vecContours[i];
+                const std::vector<CVector2D<float>> &vecB = b.m_vecContours[i];
+
+                if (vecA.size() != vecB.size() || !std::equal(vecA.begin(), vecA.end(), vecB.begin(), IsEqual))
+                    return false;
+            }
+
+            return true;
+        }
+
+        SCacheEntry *Find(uint64_t nHash, const SPath &path)
+        {
+            const auto range = m_Cache.equal_range(nHash);
+            for (std::unordered_multimap<uint64_t, SCacheEntry>::iterator it = range.first; it != range.second; ++it)
+            {
+                if (IsSamePath(it->second.m_Path, path))
+                    return &it->second;
+            }
+
+            return nullptr;
+        }
+
+        SCacheEntry &Insert(uint64_t nHash, const SPath &path)
+        {
+            SCacheEntry &entry = m_Cache.emplace(nHash, SCacheEntry())->second;
+            entry.m_Path = path;
+            return entry;
+        }
+
+        /**
+         * @brief Append a contour to the vertices and return its ring of indices, wound counter-clockwise
+         * for the outline and clockwise for holes.
+         * */
+        static std::vector<uint32_t> AddContour(const std::vector<CVector2D<float>> &vecContour, bool bHole, std::vector<CVector2D<float>> &vecVertices)
+        {
+            std::vector<uint32_t> vecRing;
+            float flArea = 0.0f;
+
+            for (size_t i = 0; i < vecContour.size(); i++)
+            {
+                const CVector2D<float> &vec = vecContour[i];
+                if (!vecRing.empty() && IsEqual(vecVertices[vecRing.back()], vec))
+                    continue;
+
+                vecRing.push_back(static_cast<uint32_t>(vecVertices.size()));
+                vecVertices.push_back(vec);
+            }
+
+            while (vecRing.size() > 1 && IsEqual(vecVertices[vecRing.front()], vecVertices[vecRing.back()]))
+                vecRing.pop_back();
+
+            for (size_t i = 0; i < vecRing.size(); i++)
+            {
+                const CVector2D<float> &a = vecVertices[vecRing[i]];
+                const CVector2D<float> &b = vecVertices[vecRing[(i + 1) % vecRing.size()]];
+                flArea += a.GetX() * b.GetY() - b.GetX() * a.GetY();
+            }
+
+            if ((flArea < 0.0f) != bHole)
+                std::reverse(vecRing.begin(), vecRing.end());
+
+            return vecRing;
+        }
+
+        /**
+         * @brief Splice a hole into the outline through a bridge from its rightmost vertex (Eberly's method).
+         * */
+        static void BridgeHole(std::vector<uint32_t> &vecOutline, const std::vector<uint32_t> &vecHole, const std::vector<CVector2D<float>> &vecVertices)
+        {
+            size_t nHoleStart = 0;
+            for (size_t i = 1; i < vecHole.size(); i++)
+            {
+                if (vecVertices[vecHole[i]].GetX() > vecVertices[vecHole[nHoleStart]].GetX())
+                    nHoleStart = i;
+            }
+
+            const CVector2D<float> &vecM = vecVertices[vecHole[nHoleStart]];
+
+            // Find the closest outline edge hit by a ray from M towards +x.
+            size_t nBridge = SIZE_MAX;
+            float flHitX = 3.402823e38f;
+
+            for (size_t i = 0; i < vecOutline.size(); i++)
+            {
+                const CVector2D<float> &a = vecVertices[vecOutline[i]];
+                const CVector2D<float> &b = vecVertices[vecOutline[(i + 1) % vecOutline.size()]];
+
+                if ((a.GetY() > vecM.GetY()) == (b.GetY() > vecM.GetY()) && a.GetY() != vecM.GetY())
+                    continue;
+
+                // An edge lying on the ray is first hit at its nearer endpoint, which is also the visible one.
+                const float flDeltaY = b.GetY() - a.GetY();
+                const bool bOnRay = flDeltaY == 0.0f;
+                const float flX = bOnRay ? std::min(a.GetX(), b.GetX()) : a.GetX() + (vecM.GetY() - a.GetY()) * (b.GetX() - a.GetX()) / flDeltaY;
+
+                if (flX < vecM.GetX() || flX >= flHitX)
+                    continue;
+
+                flHitX = flX;
+                nBridge = (a.GetX() > b.GetX()) != bOnRay ? i : (i + 1) % vecOutline.size();
+            }
+
+            if (nBridge == SIZE_MAX)
+                return;
+
+            // A reflex vertex inside the triangle M, hit, candidate would block the bridge; take the one
+            // closest in angle to the ray instead. A ray hitting the candidate vertex itself sees it directly,
+            // and the degenerate triangle would wrongly contain every vertex further along the ray.
+            const CVector2D<float> vecHit(flHitX, vecM.GetY());
+            const CVector2D<float> vecCandidate = vecVertices[vecOutline[nBridge]];
+
+            if (!IsEqual(vecCandidate, vecHit))
+            {
+                float flBestTangent = 3.402823e38f;
+
+                for (size_t i = 0; i < vecOutline.size(); i++)
+                {
+                    const CVector2D<float> &p = vecVertices[vecOutline[i]];
+                    if (i == nBridge || p.GetX() < vecM.GetX())
+                        continue;
+
+                    const bool bInside = vecCandidate.GetY() < vecM.GetY() ? IsInTriangle(vecM, vecCandidate, vecHit, p) : IsInTriangle(vecM, vecHit, vecCandidate, p);
+                    if (!bInside)
+                        continue;
+
+                    const CVector2D<float> &prev = vecVertices[vecOutline[(i + vecOutline.size() - 1) % vecOutline.size()]];
+                    const CVector2D<float> &next = vecVertices[vecOutline[(i + 1) % vecOutline.size()]];
+                    if (Cross(prev, p, next) > 0.0f)
+                        continue;
+
+                    const float flDeltaX = p.GetX() - vecM.GetX();
+                    const float flTangent = flDeltaX > 0.0f ? std::abs(p.GetY() - vecM.GetY()) / flDeltaX : 3.402823e38f;
+                    if (flTangent < flBestTangent)
+                    {
+                        flBestTangent = flTangent;
+                        nBridge = i;
+                    }
+                }
+            }
+
+            std::vector<uint32_t> vecSpliced;
+            vecSpliced.reserve(vecOutline.size() + vecHole.size() + 2);
+            vecSpliced.insert(vecSpliced.end(), vecOutline.begin(), vecOutline.begin() + nBridge + 1);
+
+            for (size_t i = 0; i <= vecHole.size(); i++)
+                vecSpliced.push_back(vecHole[(nHoleStart + i) % vecHole.size()]);
+
+            vecSpliced.push_back(vecOutline[nBridge]);
+            vecSpliced.insert(vecSpliced.end(), vecOutline.begin() + nBridge + 1, vecOutline.end());
+            vecOutline.swap(vecSpliced);
+        }
+
+        static bool IsEar(const std::vector<uint32_t> &vecRing, const std::vector<size_t> &vecPrev, const std::vector<size_t> &vecNext,
+                          size_t nIndex, const std::vector<CVector2D<float>> &vecVertices)
+        {
+            const CVector2D<float> &a = vecVertices[vecRing[vecPrev[nIndex]]];
+            const CVector2D<float> &b = vecVertices[vecRing[nIndex]];
+            const CVector2D<float> &c = vecVertices[vecRing[vecNext[nIndex]]];
+
+            if (Cross(a, b, c) <= 0.0f)
+                return false;
+
+            for (size_t i = vecNext[vecNext[nIndex]]; i != vecPrev[nIndex]; i = vecNext[i])
+            {
+                const CVector2D<float> &p = vecVertices[vecRing[i]];
+                if (IsEqual(p, a) || IsEqual(p, b) || IsEqual(p, c))
+                    continue;
+
+                if (IsInTriangle(a, b, c, p))
+                    return false;
+            }
+
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Triangulate a path without using the cache.
+         * @param path The path.
+         * @param tessellation Receives the triangles, empty if the outline has fewer than three vertices.
+         * */
+        static void TessellateUncached(const SPath &path, STessellation &tessellation)
+        {
+            tessellation.m_vecVertices.clear();
+            tessellation.m_vecIndices.clear();
+
+            if (path.m_vecContours.empty())
+                return;
+
+            std::vector<CVector2D<float>> &vecVertices = tessellation.m_vecVertices;
+            std::vector<uint32_t> vecRing = AddContour(path.m_vecContours[0], false, vecVertices);
+            if (vecRing.size() < 3)
+                return;
+
+            std::vector<std::vector<uint32_t>> vecHoles;
+            for (size_t i = 1; i < path.m_vecContours.size(); i++)
+            {
+                std::vector<uint32_t> vecHole = AddContour(path.m_vecContours[i], true, vecVertices);
+                if (vecHole.size() >= 3)
+                    vecHoles.push_back(std::move(vecHole));
+            }
+
+            // Bridging from right to left keeps every bridge clear of the holes still to come.
+            const auto GetMaxX = [&vecVertices](const std::vector<uint32_t> &vecHole)
+            {
+                float flMaxX = vecVertices[vecHole[0]].GetX();
+                for (uint32_t nVertex : vecHole)
+                    flMaxX = std::max(flMaxX, vecVertices[nVertex].GetX());
+                return flMaxX;
+            };
+
+            std::sort(vecHoles.begin(), vecHoles.end(), [&GetMaxX](const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+                      { return GetMaxX(a) > GetMaxX(b); });
+
+            for (const std::vector<uint32_t> &vecHole : vecHoles)
+                BridgeHole(vecRing, vecHole, vecVertices);
+
+            const size_t nCount = vecRing.size();
+            std::vector<size_t> vecPrev(nCount), vecNext(nCount);
+            for (size_t i = 0; i < nCount; i++)
+            {
+                vecPrev[i] = (i + nCount - 1) % nCount;
+                vecNext[i] = (i + 1) % nCount;
+            }
+
+            tessellation.m_vecIndices.reserve((nCount - 2) * 3);
+
+            size_t nRemaining = nCount;
+            size_t nCurrent = 0;
+            size_t nSinceLastEar = 0;
+
+            while (nRemaining > 3)
+            {
+                bool bClip = IsEar(vecRing, vecPrev, vecNext, nCurrent, vecVertices);
+                bool bEmit = bClip;
+
+                // No ear in a full pass: the rest is degenerate or self-intersecting. Drop a collinear
+                // vertex if there is one, otherwise clip anyway so the loop terminates.
+                if (!bClip && nSinceLastEar >= nRemaining)
+                {
+                    bClip = true;
+                    bEmit = Cross(vecVertices[vecRing[vecPrev[nCurrent]]], vecVertices[vecRing[nCurrent]], vecVertices[vecRing[vecNext[nCurrent]]]) != 0.0f;
+                }
+
+                if (!bClip)
+                {
+                    nCurrent = vecNext[nCurrent];
+                    nSinceLastEar++;
+                    continue;
+                }
+
+                if (bEmit)
+                {
+                    tessellation.m_vecIndices.push_back(vecRing[vecPrev[nCurrent]]);
+                    tessellation.m_vecIndices.push_back(vecRing[nCurrent]);
+                    tessellation.m_vecIndices.push_back(vecRing[vecNext[nCurrent]]);
+                }
+
+                vecNext[vecPrev[nCurrent]] = vecNext[nCurrent];
+                vecPrev[vecNext[nCurrent]] = vecPrev[nCurrent];
+                nCurrent = vecPrev[nCurrent];
+                nRemaining--;
+                nSinceLastEar = 0;
+            }
+
+            if (Cross(vecVertices[vecRing[vecPrev[nCurrent]]], vecVertices[vecRing[nCurrent]], vecVertices[vecRing[vecNext[nCurrent]]]) != 0.0f)
+            {
+                tessellation.m_vecIndices.push_back(vecRing[vecPrev[nCurrent]]);
+                tessellation.m_vecIndices.push_back(vecRing[nCurrent]);
+                tessellation.m_vecIndices.push_back(vecRing[vecNext[nCurrent]]);
+            }
+        }
+
+        /**
+         * @brief Triangulate a path, reusing the result of an identical earlier path.
+         * @param path The path.
+         * @return The triangles, valid until the cache is cleared or evicts them.
+         * */
+        const STessellation &Tessellate(const SPath &path)
+        {
+            CALI_PROFILE_SCOPE("CPathTessellator::Tessellate");
+
+            const uint64_t nHash = Hash(path);
+            if (SCacheEntry *pEntry = Find(nHash, path))
+            {
+                m_nCacheHits++;
+                return pEntry->m_Tessellation;
+            }
+
+            m_nCacheMisses++;
+
+            if (m_Cache.size() >= m_nMaxCacheEntries)
+                m_Cache.clear();
+
+            SCacheEntry &entry = Insert(nHash, path);
+            TessellateUncached(path, entry.m_Tessellation);
+            return entry.m_Tessellation;
+        }
+
+        /**
+         * @brief Triangulate many paths, the ones missing from the cache in parallel.
+         * Copies of a path within the batch are triangulated once; only the first counts as a cache miss.
+         * @param pPaths The paths.
+         * @param nCount The number of paths.
+         * @param vecTessellations Receives one pointer per path, valid like the result of Tessellate().
+         * */
+        void TessellateBatch(const SPath *pPaths, size_t nCount, std::vector<const STessellation *> &vecTessellations)
+        {
+            CALI_PROFILE_SCOPE("CPathTessellator::TessellateBatch");
+
+            // Evict up front; insertions below never invalidate the pointers already handed out.
+            if (m_Cache.size() + nCount > m_nMaxCacheEntries)
+                m_Cache.clear();
+
+            vecTessellations.assign(nCount, nullptr);
+
+            // A miss gets its cache entry right away, so later copies of the same path in the batch hit
+            // it and every unique path is triangulated once.
+            std::vector<size_t> vecMisses;
+            std::vector<SCacheEntry *> vecMissEntries;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const uint64_t nHash = Hash(pPaths[i]);
+                SCacheEntry *pEntry = Find(nHash, pPaths[i]);
+
+                if (pEntry)
+                    m_nCacheHits++;
+                else
+                {
+                    pEntry = &Insert(nHash, pPaths[i]);
+                    vecMisses.push_back(i);
+                    vecMissEntries.push_back(pEntry);
+                }
+
+                vecTessellations[i] = &pEntry->m_Tessellation;
+            }
+
+            m_nCacheMisses += vecMisses.size();
+
+            CParallel::For(vecMisses.size(), MIN_PATHS_PER_THREAD, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t i = nBegin; i < nEnd; i++)
+                                   TessellateUncached(pPaths[vecMisses[i]], vecMissEntries[i]->m_Tessellation); });
+        }
+
+        /**
+         * @brief Set the number of paths kept in the cache. When it is full the cache is emptied.
+         * */
+        void SetMaxCacheEntries(size_t nMaxCacheEntries) { m_nMaxCacheEntries = nMaxCacheEntries; }
+
+        void ClearCache() { m_Cache.clear(); }
+        size_t GetCacheSize() const { return m_Cache.size(); }
+        size_t GetCacheHits() const { return m_nCacheHits; }
+        size_t GetCacheMisses() const { return m_nCacheMisses; }
+    };
+
+} // namespace Cali
@@ -0,0 +1,607 @@
+#pragma once
+
+/**
+ * @file CPolygonQuery.h
+ * @brief Contains the declaration of the CPolygonQuery class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @class CPolygonQuery
+     * @brief Answers point-in-polygon and polygon overlap queries against a fixed set of polygons.
+     *
+     * Every polygon is a single closed ring, tested with the even-odd rule. When it is added its edges
+     * are bucketed into horizontal slabs of its bounds, stored as SoA arrays padded to four edges, so a
+     * point only casts its ray through the edges of one slab. The crossing test runs four float or two
+     * double edges at a time with SSE2. A grid over the bounds of all polygons finds the candidates of
+     * Locate() and FindOverlaps().
+     *
+     * Points on an edge may be reported inside or outside. Polygons that only touch do overlap.
+     */
+    template <typename T = double>
+    class CPolygonQuery
+    {
+    public:
+        static constexpr uint32_t NO_POLYGON = 0xFFFFFFFF;
+        static constexpr size_t EDGES_PER_SLAB = 4;
+        static constexpr size_t MAX_GRID_SIDE = 256;
+        static constexpr size_t MIN_POINTS_PER_THREAD = 16 * 1024;
+        static constexpr size_t POLYGON_CHUNK_SIZE = 256;
+
+    private:
+        struct SPolygon
+        {
+            T m_flMinX = T(0);
+            T m_flMinY = T(0);
+            T m_flMaxX = T(0);
+            T m_flMaxY = T(0);
+            T m_flSlabScale = T(0);
+
+            uint32_t m_nFirstVertex = 0;
+            uint32_t m_nVertexCount = 0;
+            uint32_t m_nFirstSlab = 0;
+            uint32_t m_nSlabCount = 0;
+        };
+
+        std::vector<CVector2D<T>> m_vecVertices = {};
+        std::vector<SPolygon> m_vecPolygons = {};
+
+        // Slab s of all polygons holds m_vecSlabCount[s] edges from m_vecSlabBegin[s], padded to EDGES_PER_SLAB.
+        std::vector<uint32_t> m_vecSlabBegin = {};
+        std::vector<uint32_t> m_vecSlabCount = {};
+
+        std::vector<T> m_vecEdgeX0 = {};
+        std::vector<T> m_vecEdgeY0 = {};
+        std::vector<T> m_vecEdgeX1 = {};
+        std::vector<T> m_vecEdgeY1 = {};
+        std::vector<T> m_vecEdgeSlope = {};
+
+        T m_flGridMinX = T(0);
+        T m_flGridMinY = T(0);
+        T m_flGridMaxX = T(0);
+        T m_flGridMaxY = T(0);
+        T m_flGridScaleX = T(0);
+        T m_flGridScaleY = T(0);
+        size_t m_nGridSide = 0;
+
+        std::vector<uint32_t> m_vecCellBegin = {};
+        std::vector<uint32_t> m_vecCellPolygons = {};
+        bool m_bGridDirty = true;
+
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> m_vecChunkPairs = {};
+
+        /**
+         * @brief Map a coordinate to one of nCount equal buckets starting at flMin, clamped to the ends.
+         * */
+        static size_t GetBucket(T flValue, T flMin, T flScale, size_t nCount)
+        {
+            const T flBucket = (flValue - flMin) * flScale;
+            if (!(flBucket > T(0)))
+                return 0;
+
+            if (flBucket >= static_cast<T>(nCount))
+                return nCount - 1;
+
+            return static_cast<size_t>(flBucket);
+        }
+
+        static size_t PadEdges(size_t nCount) { return (nCount + EDGES_PER_SLAB - 1) / EDGES_PER_SLAB * EDGES_PER_SLAB; }
+
+        static bool IsDisjoint(const SPolygon &a, const SPolygon &b)
+        {
+            return a.m_flMaxX < b.m_flMinX || b.m_flMaxX < a.m_flMinX || a.m_flMaxY < b.m_flMinY || b.m_flMaxY < a.m_flMinY;
+        }
+
+        /**
+         * @brief Twice the signed area of the triangle a, b, c; positive when it turns counter-clockwise.
+         * */
+        static T Orientation(T flAX, T flAY, T flBX, T flBY, T flCX, T flCY)
+        {
+            return (flBX - flAX) * (flCY - flAY) - (flBY - flAY) * (flCX - flAX);
+        }
+
+        /**
+         * @brief Whether c, known to be collinear with a and b, lies within their bounds.
+         * */
+        static bool IsWithin(T flAX, T flAY, T flBX, T flBY, T flCX, T flCY)
+        {
+            return std::min(flAX, flBX) <= flCX && flCX <= std::max(flAX, flBX) && std::min(flAY, flBY) <= flCY && flCY <= std::max(flAY, flBY);
+        }
+
+        /**
+         * @brief Whether the closed segments p and q intersect, touching included.
+         * */
+        static bool IsSegmentIntersecting(T flP0X, T flP0Y, T flP1X, T flP1Y, T flQ0X, T flQ0Y, T flQ1X, T flQ1Y)
+        {
+            const T flD0 = Orientation(flQ0X, flQ0Y, flQ1X, flQ1Y, flP0X, flP0Y);
+            const T flD1 = Orientation(flQ0X, flQ0Y, flQ1X, flQ1Y, flP1X, flP1Y);
+            const T flD2 = Orientation(flP0X, flP0Y, flP1X, flP1Y, flQ0X, flQ0Y);
+            const T flD3 = Orientation(flP0X, flP0Y, flP1X, flP1Y, flQ1X, flQ1Y);
+
+            if (((flD0 > T(0) && flD1 < T(0)) || (flD0 < T(0) && flD1 > T(0))) && ((flD2 > T(0) && flD3 < T(0)) || (flD2 < T(0) && flD3 > T(0))))
+                return true;
+
+            return (flD0 == T(0) && IsWithin(flQ0X, flQ0Y, flQ1X, flQ1Y, flP0X, flP0Y)) || (flD1 == T(0) && IsWithin(flQ0X, flQ0Y, flQ1X, flQ1Y, flP1X, flP1Y)) ||
+                   (flD2 == T(0) && IsWithin(flP0X, flP0Y, flP1X, flP1Y, flQ0X, flQ0Y)) || (flD3 == T(0) && IsWithin(flP0X, flP0Y, flP1X, flP1Y, flQ1X, flQ1Y));
+        }
+
+        /**
+         * @brief Cast a ray from (flX, flY) towards +X through the edges of one slab.
+         * @return Whether it crosses an odd number of them.
+         * */
+        bool IsOddCrossing(size_t nSlab, T flX, T flY) const
+        {
+            const size_t nBegin = m_vecSlabBegin[nSlab];
+            const T *pX0 = m_vecEdgeX0.data();
+            const T *pY0 = m_vecEdgeY0.data();
+            const T *pY1 = m_vecEdgeY1.data();
+            const T *pSlope = m_vecEdgeSlope.data();
+
+            // Padding edges are all zero, so they never straddle the ray.
+#ifdef CALI_SIMD_SSE2
+            if constexpr (std::is_same<T, float>::value)
+            {
+                const size_t nEnd = nBegin + PadEdges(m_vecSlabCount[nSlab]);
+                const __m128 vecX = _mm_set1_ps(flX);
+                const __m128 vecY = _mm_set1_ps(flY);
+                __m128 vecOdd = _mm_setzero_ps();
+
+                for (size_t i = nBegin; i < nEnd; i += 4)
+                {
+                    const __m128 vecY0 = _mm_loadu_ps(pY0 + i);
+                    const __m128 vecStraddle = _mm_xor_ps(_mm_cmpgt_ps(vecY0, vecY), _mm_cmpgt_ps(_mm_loadu_ps(pY1 + i), vecY));
+                    const __m128 vecCrossX = _mm_add_ps(_mm_loadu_ps(pX0 + i), _mm_mul_ps(_mm_sub_ps(vecY, vecY0), _mm_loadu_ps(pSlope + i)));
+                    vecOdd = _mm_xor_ps(vecOdd, _mm_and_ps(vecStraddle, _mm_cmplt_ps(vecX, vecCrossX)));
+                }
+
+                // 0x6996 holds the parity of every 4-bit lane mask.
+                return (0x6996 >> _mm_movemask_ps(vecOdd)) & 1;
+            }
+            else if constexpr (std::is_same<T, double>::value)
+            {
+                const size_t nEnd = nBegin + PadEdges(m_vecSlabCount[nSlab]);
+                const __m128d vecX = _mm_set1_pd(flX);
+                const __m128d vecY = _mm_set1_pd(flY);
+                __m128d vecOdd = _mm_setzero_pd();
+
+                for (size_t i = nBegin; i < nEnd; i += 2)
+                {
+                    const __m128d vecY0 = _mm_loadu_pd(pY0 + i);
+                    const __m128d vecStraddle = _mm_xor_pd(_mm_cmpgt_pd(vecY0, vecY), _mm_cmpgt_pd(_mm_loadu_pd(pY1 + i), vecY));
+                    const __m128d vecCrossX = _mm_add_pd(_mm_loadu_pd(pX0 + i), _mm_mul_pd(_mm_sub_pd(vecY, vecY0), _mm_loadu_pd(pSlope + i)));
+                    vecOdd = _mm_xor_pd(vecOdd, _mm_and_pd(vecStraddle, _mm_cmplt_pd(vecX, vecCrossX)));
+                }
+
+                return (0x6996 >> _mm_movemask_pd(vecOdd)) & 1;
+            }
+#endif
+
+            bool bOdd = false;
+            for (size_t i = nBegin; i < nBegin + m_vecSlabCount[nSlab]; i++)
+            {
+                if ((pY0[i] > flY) != (pY1[i] > flY) && flX < pX0[i] + (flY - pY0[i]) * pSlope[i])
+                    bOdd = !bOdd;
+            }
+
+            return bOdd;
+        }
+
+        bool IsInside(const SPolygon &polygon, T flX, T flY) const
+        {
+            if (!(flX >= polygon.m_flMinX && flX <= polygon.m_flMaxX && flY >= polygon.m_flMinY && flY <= polygon.m_flMaxY))
+                return false;
+
+            return IsOddCrossing(polygon.m_nFirstSlab + GetBucket(flY, polygon.m_flMinY, polygon.m_flSlabScale, polygon.m_nSlabCount), flX, flY);
+        }
+
+        /**
+         * @brief Whether any edge of a crosses or touches an edge of b, looked up through the slabs of b.
+         * */
+        bool IsBoundaryIntersecting(const SPolygon &a, const SPolygon &b) const
+        {
+            for (uint32_t i = 0; i < a.m_nVertexCount; i++)
+            {
+                const CVector2D<T> &vec0 = m_vecVertices[a.m_nFirstVertex + i];
+                const CVector2D<T> &vec1 = m_vecVertices[a.m_nFirstVertex + (i + 1) % a.m_nVertexCount];
+
+                const T flMinY = std::min(vec0.GetY(), vec1.GetY());
+                const T flMaxY = std::max(vec0.GetY(), vec1.GetY());
+                if (flMaxY < b.m_flMinY || flMinY > b.m_flMaxY || std::max(vec0.GetX(), vec1.GetX()) < b.m_flMinX || std::min(vec0.GetX(), vec1.GetX()) > b.m_flMaxX)
+                    continue;
+
+                const size_t nFirstSlab = b.m_nFirstSlab + GetBucket(flMinY, b.m_flMinY, b.m_flSlabScale, b.m_nSlabCount);
+                const size_t nLastSlab = b.m_nFirstSlab + GetBucket(flMaxY, b.m_flMinY, b.m_flSlabScale, b.m_nSlabCount);
+
+                for (size_t nSlab = nFirstSlab; nSlab <= nLastSlab; nSlab++)
+                {
+                    for (size_t j = m_vecSlabBegin[nSlab]; j < m_vecSlabBegin[nSlab] + m_vecSlabCount[nSlab]; j++)
+                    {
+                        if (IsSegmentIntersecting(vec0.GetX(), vec0.GetY(), vec1.GetX(), vec1.GetY(), m_vecEdgeX0[j], m_vecEdgeY0[j], m_vecEdgeX1[j], m_vecEdgeY1[j]))
+                            return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        size_t GetCell(T flX, T flY) const
+        {
+            return GetBucket(flY, m_flGridMinY, m_flGridScaleY, m_nGridSide) * m_nGridSide + GetBucket(flX, m_flGridMinX, m_flGridScaleX, m_nGridSide);
+        }
+
+        /**
+         * @brief Rebuild the grid of polygon bounds if polygons were added since it was last built.
+         * */
+        void BuildGrid()
+        {
+            if (!m_bGridDirty)
+                return;
+
+            CALI_PROFILE_SCOPE("CPolygonQuery::BuildGrid");
+
+            m_bGridDirty = false;
+            m_flGridMinX = m_flGridMinY = std::numeric_limits<T>::max();
+            m_flGridMaxX = m_flGridMaxY = std::numeric_limits<T>::lowest();
+
+            for (const SPolygon &polygon : m_vecPolygons)
+            {
+                if (polygon.m_nVertexCount == 0)
+                    continue;
+
+                m_flGridMinX = std::min(m_flGridMinX, polygon.m_flMinX);
+                m_flGridMinY = std::min(m_flGridMinY, polygon.m_flMinY);
+                m_flGridMaxX = std::max(m_flGridMaxX, polygon.m_flMaxX);
+                m_flGridMaxY = std::max(m_flGridMaxY, polygon.m_flMaxY);
+            }
+
+            m_nGridSide = std::max<size_t>(1, std::min(MAX_GRID_SIDE, static_cast<size_t>(std::ceil(2.0 * std::sqrt(static_cast<double>(m_vecPolygons.size()))))));
+            m_flGridScaleX = m_flGridMaxX > m_flGridMinX ? static_cast<T>(m_nGridSide) / (m_flGridMaxX - m_flGridMinX) : T(0);
+            m_flGridScaleY = m_flGridMaxY > m_flGridMinY ? static_cast<T>(m_nGridSide) / (m_flGridMaxY - m_flGridMinY) : T(0);
+
+            // Count the polygons of every cell, then list them in ascending order.
+            const auto ForEachCell = [&](const SPolygon &polygon, auto &&fnCell)
+            {
+                const size_t nMinCell = GetCell(polygon.m_flMinX, polygon.m_flMinY);
+                const size_t nMaxCell = GetCell(polygon.m_flMaxX, polygon.m_flMaxY);
+
+                for (size_t nRow = nMinCell / m_nGridSide; nRow <= nMaxCell / m_nGridSide; nRow++)
+                {
+                    for (size_t nColumn = nMinCell % m_nGridSide; nColumn <= nMaxCell % m_nGridSide; nColumn++)
+                        fnCell(nRow * m_nGridSide + nColumn);
+                }
+            };
+
+            m_vecCellBegin.assign(m_nGridSide * m_nGridSide + 1, 0);
+            for (const SPolygon &polygon : m_vecPolygons)
+            {
+                if (polygon.m_nVertexCount != 0)
+                    ForEachCell(polygon, [&](size_t nCell)
+                                { m_vecCellBegin[nCell + 1]++; });
+            }
+
+            for (size_t nCell = 1; nCell < m_vecCellBegin.size(); nCell++)
+                m_vecCellBegin[nCell] += m_vecCellBegin[nCell - 1];
+
+            std::vector<uint32_t> vecFill(m_vecCellBegin.begin(), m_vecCellBegin.end() - 1);
+            m_vecCellPolygons.resize(m_vecCellBegin.back());
+
+            for (size_t nPolygon = 0; nPolygon < m_vecPolygons.size(); nPolygon++)
+            {
+                if (m_vecPolygons[nPolygon].m_nVertexCount != 0)
+                    ForEachCell(m_vecPolygons[nPolygon], [&](size_t nCell)
+                                { m_vecCellPolygons[vecFill[nCell]++] = static_cast<uint32_t>(nPolygon); });
+            }
+        }
+
+        uint32_t LocatePoint(T flX, T flY) const
+        {
+            if (!(flX >= m_flGridMinX && flX <= m_flGridMaxX && flY >= m_flGridMinY && flY <= m_flGridMaxY))
+                return NO_POLYGON;
+
+            const size_t nCell = GetCell(flX, flY);
+            for (size_t i = m_vecCellBegin[nCell]; i < m_vecCellBegin[nCell + 1]; i++)
+            {
+                if (IsInside(m_vecPolygons[m_vecCellPolygons[i]], flX, flY))
+                    return m_vecCellPolygons[i];
+            }
+
+            return NO_POLYGON;
+        }
+
+        /**
+         * @brief List the polygons whose grid cells overlap those of nPolygon and that overlap it.
+         * @param bHigherOnly Only list polygons with a higher index than nPolygon.
+         * */
+        void CollectOverlaps(uint32_t nPolygon, bool bHigherOnly, std::vector<uint32_t> &vecCandidates, std::vector<uint32_t> &vecOverlaps) const
+        {
+            const SPolygon &polygon = m_vecPolygons[nPolygon];
+            vecCandidates.clear();
+
+            if (polygon.m_nVertexCount == 0)
+                return;
+
+            const size_t nMinCell = GetCell(polygon.m_flMinX, polygon.m_flMinY);
+            const size_t nMaxCell = GetCell(polygon.m_flMaxX, polygon.m_flMaxY);
+
+            for (size_t nRow = nMinCell / m_nGridSide; nRow <= nMaxCell / m_nGridSide; nRow++)
+            {
+                for (size_t nColumn = nMinCell % m_nGridSide; nColumn <= nMaxCell % m_nGridSide; nColumn++)
+                {
+                    const size_t nCell = nRow * m_nGridSide + nColumn;
+                    for (size_t i = m_vecCellBegin[nCell]; i < m_vecCellBegin[nCell + 1]; i++)
+                    {
+                        if (bHigherOnly ? m_vecCellPolygons[i] > nPolygon : m_vecCellPolygons[i] != nPolygon)
+                            vecCandidates.push_back(m_vecCellPolygons[i]);
+                    }
+                }
+            }
+
+            std::sort(vecCandidates.begin(), vecCandidates.end());
+            vecCandidates.erase(std::unique(vecCandidates.begin(), vecCandidates.end()), vecCandidates.end());
+
+            for (uint32_t nCandidate : vecCandidates)
+            {
+                if (Overlaps(nPolygon, nCandidate))
+                    vecOverlaps.push_back(nCandidate);
+            }
+        }
+
+    public:
+        /**
+         * @brief Add a polygon and build its slabs.
+         * @param pVertices The vertices of the ring, in either winding; the last connects back to the first.
+         * @param nCount The number of vertices.
+         * @return The index of the polygon.
+         * */
+        uint32_t AddPolygon(const CVector2D<T> *pVertices, size_t nCount)
+        {
+            CALI_PROFILE_SCOPE("CPolygonQuery::AddPolygon");
+
+            SPolygon polygon;
+            polygon.m_nFirstVertex = static_cast<uint32_t>(m_vecVertices.size());
+            polygon.m_nVertexCount = static_cast<uint32_t>(nCount);
+            polygon.m_nFirstSlab = static_cast<uint32_t>(m_vecSlabBegin.size());
+            polygon.m_nSlabCount = 1;
+
+            m_vecVertices.insert(m_vecVertices.end(), pVertices, pVertices + nCount);
+            m_bGridDirty = true;
+
+            if (nCount == 0)
+            {
+                m_vecSlabBegin.push_back(static_cast<uint32_t>(m_vecEdgeX0.size()));
+                m_vecSlabCount.push_back(0);
+                m_vecPolygons.push_back(polygon);
+                return static_cast<uint32_t>(m_vecPolygons.size() - 1);
+            }
+
+            polygon.m_flMinX = polygon.m_flMaxX = pVertices[0].GetX();
+            polygon.m_flMinY = polygon.m_flMaxY = pVertices[0].GetY();
+            for (size_t i = 1; i < nCount; i++)
+            {
+                polygon.m_flMinX = std::min(polygon.m_flMinX, pVertices[i].GetX());
+                polygon.m_flMinY = std::min(polygon.m_flMinY, pVertices[i].GetY());
+                polygon.m_flMaxX = std::max(polygon.m_flMaxX, pVertices[i].GetX());
+                polygon.m_flMaxY = std::max(polygon.m_flMaxY, pVertices[i].GetY());
+            }
+
+            const T flHeight = polygon.m_flMaxY - polygon.m_flMinY;
+            const auto GetSlabRange = [&](size_t i, size_t &nFirst, size_t &nLast)
+            {
+                const T flY0 = pVertices[i].GetY();
+                const T flY1 = pVertices[(i + 1) % nCount].GetY();
+                nFirst = GetBucket(std::min(flY0, flY1), polygon.m_flMinY, polygon.m_flSlabScale, polygon.m_nSlabCount);
+                nLast = GetBucket(std::max(flY0, flY1), polygon.m_flMinY, polygon.m_flSlabScale, polygon.m_nSlabCount);
+            };
+
+            // Aim for EDGES_PER_SLAB edges per slab, but halve the slabs while long edges repeat too often.
+            size_t nSlabs = std::max<size_t>(1, nCount / EDGES_PER_SLAB);
+            for (;; nSlabs /= 2)
+            {
+                polygon.m_nSlabCount = static_cast<uint32_t>(nSlabs);
+                polygon.m_flSlabScale = flHeight > T(0) ? static_cast<T>(nSlabs) / flHeight : T(0);
+
+                size_t nEntries = 0;
+                for (size_t i = 0; i < nCount; i++)
+                {
+                    size_t nFirst, nLast;
+                    GetSlabRange(i, nFirst, nLast);
+                    nEntries += nLast - nFirst + 1;
+                }
+
+                if (nSlabs == 1 || nEntries <= 8 * nCount)
+                    break;
+            }
+
+            std::vector<uint32_t> vecFill(nSlabs, 0);
+            for (size_t i = 0; i < nCount; i++)
+            {
+                size_t nFirst, nLast;
+                GetSlabRange(i, nFirst, nLast);
+                for (size_t nSlab = nFirst; nSlab <= nLast; nSlab++)
+                    vecFill[nSlab]++;
+            }
+
+            size_t nEdges = m_vecEdgeX0.size();
+            for (size_t nSlab = 0; nSlab < nSlabs; nSlab++)
+            {
+                m_vecSlabBegin.push_back(static_cast<uint32_t>(nEdges));
+                m_vecSlabCount.push_back(vecFill[nSlab]);
+                nEdges += PadEdges(vecFill[nSlab]);
+                vecFill[nSlab] = 0;
+            }
+
+            m_vecEdgeX0.resize(nEdges, T(0));
+            m_vecEdgeY0.resize(nEdges, T(0));
+            m_vecEdgeX1.resize(nEdges, T(0));
+            m_vecEdgeY1.resize(nEdges, T(0));
+            m_vecEdgeSlope.resize(nEdges, T(0));
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const CVector2D<T> &vec0 = pVertices[i];
+                const CVector2D<T> &vec1 = pVertices[(i + 1) % nCount];
+                const T flSlope = vec1.GetY() != vec0.GetY() ? (vec1.GetX() - vec0.GetX()) / (vec1.GetY() - vec0.GetY()) : T(0);
+
+                size_t nFirst, nLast;
+                GetSlabRange(i, nFirst, nLast);
+                for (size_t nSlab = nFirst; nSlab <= nLast; nSlab++)
+                {
+                    const size_t nEdge = m_vecSlabBegin[polygon.m_nFirstSlab + nSlab] + vecFill[nSlab]++;
+                    m_vecEdgeX0[nEdge] = vec0.GetX();
+                    m_vecEdgeY0[nEdge] = vec0.GetY();
+                    m_vecEdgeX1[nEdge] = vec1.GetX();
+                    m_vecEdgeY1[nEdge] = vec1.GetY();
+                    m_vecEdgeSlope[nEdge] = flSlope;
+                }
+            }
+
+            m_vecPolygons.push_back(polygon);
+            return static_cast<uint32_t>(m_vecPolygons.size() - 1);
+        }
+
+        void Clear()
+        {
+            m_vecVertices.clear();
+            m_vecPolygons.clear();
+            m_vecSlabBegin.clear();
+            m_vecSlabCount.clear();
+            m_vecEdgeX0.clear();
+            m_vecEdgeY0.clear();
+            m_vecEdgeX1.clear();
+            m_vecEdgeY1.clear();
+            m_vecEdgeSlope.clear();
+            m_vecCellBegin.clear();
+            m_vecCellPolygons.clear();
+            m_bGridDirty = true;
+        }
+
+        size_t GetPolygonCount() const { return m_vecPolygons.size(); }
+
+        /**
+         * @brief Test one point against one polygon.
+         * */
+        bool Contains(uint32_t nPolygon, const CVector2D<T> &vecPoint) const { return IsInside(m_vecPolygons[nPolygon], vecPoint.GetX(), vecPoint.GetY()); }
+
+        /**
+         * @brief Test a batch of points against one polygon, in parallel for large batches.
+         * @param pInside Receives 1 for every point inside, 0 otherwise.
+         * */
+        void Contains(uint32_t nPolygon, const CVector2D<T> *pPoints, size_t nCount, uint8_t *pInside) const
+        {
+            CALI_PROFILE_SCOPE("CPolygonQuery::Contains");
+
+            const SPolygon &polygon = m_vecPolygons[nPolygon];
+            CParallel::For(nCount, MIN_POINTS_PER_THREAD, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t i = nBegin; i < nEnd; i++)
+                                   pInside[i] = IsInside(polygon, pPoints[i].GetX(), pPoints[i].GetY()) ? 1 : 0;
+                           });
+        }
+
+        /**
+         * @brief Find the polygon containing each point of a batch, in parallel for large batches.
+         * @param pPolygons Receives the lowest index of the polygons containing every point, or NO_POLYGON.
+         * */
+        void Locate(const CVector2D<T> *pPoints, size_t nCount, uint32_t *pPolygons)
+        {
+            CALI_PROFILE_SCOPE("CPolygonQuery::Locate");
+
+            BuildGrid();
+            CParallel::For(nCount, MIN_POINTS_PER_THREAD, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t i = nBegin; i < nEnd; i++)
+                                   pPolygons[i] = LocatePoint(pPoints[i].GetX(), pPoints[i].GetY());
+                           });
+        }
+
+        /**
+         * @brief Whether two polygons share any point: their boundaries meet, or one lies inside the other.
+         * */
+        bool Overlaps(uint32_t nA, uint32_t nB) const
+        {
+            const SPolygon &a = m_vecPolygons[nA];
+            const SPolygon &b = m_vecPolygons[nB];
+
+            if (a.m_nVertexCount == 0 || b.m_nVertexCount == 0 || IsDisjoint(a, b))
+                return false;
+
+            // Walk the smaller ring through the slabs of the larger one.
+            if (a.m_nVertexCount <= b.m_nVertexCount ? IsBoundaryIntersecting(a, b) : IsBoundaryIntersecting(b, a))
+                return true;
+
+            const CVector2D<T> &vecA = m_vecVertices[a.m_nFirstVertex];
+            const CVector2D<T> &vecB = m_vecVertices[b.m_nFirstVertex];
+            return IsInside(b, vecA.GetX(), vecA.GetY()) || IsInside(a, vecB.GetX(), vecB.GetY());
+        }
+
+        /**
+         * @brief List the polygons that overlap one polygon.
+         * @param vecOverlaps Receives their indices, ascending.
+         * */
+        void FindOverlaps(uint32_t nPolygon, std::vector<uint32_t> &vecOverlaps)
+        {
+            CALI_PROFILE_SCOPE("CPolygonQuery::FindOverlaps");
+
+            BuildGrid();
+            vecOverlaps.clear();
+
+            std::vector<uint32_t> vecCandidates;
+            CollectOverlaps(nPolygon, false, vecCandidates, vecOverlaps);
+        }
+
+        /**
+         * @brief List every pair of overlapping polygons, testing chunks of POLYGON_CHUNK_SIZE polygons in parallel.
+         * @param vecPairs Receives the pairs (a, b) with a < b, ascending.
+         * */
+        void FindOverlappingPairs(std::vector<std::pair<uint32_t, uint32_t>> &vecPairs)
+        {
+            CALI_PROFILE_SCOPE("CPolygonQuery::FindOverlappingPairs");
+
+            BuildGrid();
+            vecPairs.clear();
+
+            const size_t nPolygons = m_vecPolygons.size();
+            const size_t nChunks = (nPolygons + POLYGON_CHUNK_SIZE - 1) / POLYGON_CHUNK_SIZE;
+            m_vecChunkPairs.resize(nChunks);
+
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               std::vector<uint32_t> vecCandidates;
+                               std::vector<uint32_t> vecOverlaps;
+
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                               {
+                                   m_vecChunkPairs[nChunk].clear();
+
+                                   for (size_t nPolygon = nChunk * POLYGON_CHUNK_SIZE; nPolygon < std::min(nPolygons, (nChunk + 1) * POLYGON_CHUNK_SIZE); nPolygon++)
+                                   {
+                                       vecOverlaps.clear();
+                                       CollectOverlaps(static_cast<uint32_t>(nPolygon), true, vecCandidates, vecOverlaps);
+
+                                       for (uint32_t nOther : vecOverlaps)
+                                           m_vecChunkPairs[nChunk].emplace_back(static_cast<uint32_t>(nPolygon), nOther);
+                                   }
+                               } });
+
+            for (const std::vector<std::pair<uint32_t, uint32_t>> &vecChunk : m_vecChunkPairs)
+                vecPairs.insert(vecPairs.end(), vecChunk.begin(), vecChunk.end());
+        }
+    };
+
+} // namespace Cali
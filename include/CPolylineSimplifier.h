@@ -0,0 +1,316 @@
+#pragma once
+
+/**
+ * @file CPolylineSimplifier.h
+ * @brief Contains the declaration of the CPolylineSimplifier class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @brief Algorithm used by CPolylineSimplifier.
+     * */
+    enum SimplifyMode_e
+    {
+        /**
+         * @brief Ramer-Douglas-Peucker: keeps every point farther than the tolerance from the simplified line.
+         * */
+        SIMPLIFY_RDP = 0,
+
+        /**
+         * @brief Visvalingam-Whyatt: drops points whose triangle with their neighbours has an area below tolerance^2 px^2.
+         * Smoother than SIMPLIFY_RDP, but its heap makes it several times slower on long input. The area
+         * threshold does not bound the distance to the input: a thin spike of any length can be dropped.
+         * */
+        SIMPLIFY_VISVALINGAM,
+
+        /**
+         * @brief Per pixel column keep the first, lowest, highest and last point, in a single pass.
+         * Only for time series, i.e. x must not decrease. The plot looks the same as the full data.
+         * */
+        SIMPLIFY_MINMAX
+    };
+
+    /**
+     * @class CPolylineSimplifier
+     * @brief Reduces dense polylines to what is visible at a screen-space tolerance.
+     *
+     * Input longer than MIN_POINTS_PER_THREAD per thread is split into chunks that are simplified in
+     * parallel. Chunks share their end points, so the result stays connected and, for SIMPLIFY_RDP, within
+     * the tolerance, though it may keep a few points a single pass would have dropped.
+     */
+    class CPolylineSimplifier
+    {
+    public:
+        static constexpr size_t MIN_POINTS_PER_THREAD = 64 * 1024;
+
+    private:
+        SimplifyMode_e m_nMode = SIMPLIFY_RDP;
+
+        /**
+         * @brief The distance in pixels for SIMPLIFY_RDP, the square root of the triangle area for
+         * SIMPLIFY_VISVALINGAM, the column width for SIMPLIFY_MINMAX.
+         * */
+        float m_flTolerance = 0.5f;
+
+        static float DistanceSqrToSegment(const CVector2D<float> &p, const CVector2D<float> &a, const CVector2D<float> &b)
+        {
+            const float flDeltaX = b.GetX() - a.GetX();
+            const float flDeltaY = b.GetY() - a.GetY();
+            const float flLengthSqr = flDeltaX * flDeltaX + flDeltaY * flDeltaY;
+
+            float flT = 0.0f;
+            if (flLengthSqr > 0.0f)
+            {
+                flT = ((p.GetX() - a.GetX()) * flDeltaX + (p.GetY() - a.GetY()) * flDeltaY) / flLengthSqr;
+                flT = flT < 0.0f ? 0.0f : (flT > 1.0f ? 1.0f : flT);
+            }
+
+            const float flX = p.GetX() - a.GetX() - flT * flDeltaX;
+            const float flY = p.GetY() - a.GetY() - flT * flDeltaY;
+            return flX * flX + flY * flY;
+        }
+
+        static float TriangleArea(const CVector2D<float> &a, const CVector2D<float> &b, const CVector2D<float> &c)
+        {
+            return 0.5f * std::fabs((b.GetX() - a.GetX()) * (c.GetY() - a.GetY()) - (b.GetY() - a.GetY()) * (c.GetX() - a.GetX()));
+        }
+
+        /**
+         * @brief Mark the points RDP keeps. The stack replaces recursion so long inputs cannot overflow.
+         * */
+        static void MarkRDP(const CVector2D<float> *pPoints, size_t nCount, float flTolerance, std::vector<uint8_t> &vecKeep)
+        {
+            const float flToleranceSqr = flTolerance * flTolerance;
+            std::vector<std::pair<size_t, size_t>> vecStack;
+            vecStack.emplace_back(0, nCount - 1);
+
+            while (!vecStack.empty())
+            {
+                const std::pair<size_t, size_t> range = vecStack.back();
+                vecStack.pop_back();
+
+                float flMaxDistanceSqr = 0.0f;
+                size_t nFarthest = range.first;
+
+                for (size_t i = range.first + 1; i < range.second; i++)
+                {
+                    const float flDistanceSqr = DistanceSqrToSegment(pPoints[i], pPoints[range.first], pPoints[range.second]);
+                    if (flDistanceSqr > flMaxDistanceSqr)
+                    {
+                        flMaxDistanceSqr = flDistanceSqr;
+                        nFarthest = i;
+                    }
+                }
+
+                if (flMaxDistanceSqr <= flToleranceSqr)
+                    continue;
+
+                vecKeep[nFarthest] = 1;
+                vecStack.emplace_back(range.first, nFarthest);
+                vecStack.emplace_back(nFarthest, range.second);
+            }
+        }
+
+        /**
+         * @brief Mark the points Visvalingam-Whyatt keeps, removing the smallest triangle first in O(n log n).
+         * */
+        static void MarkVisvalingam(const CVector2D<float> *pPoints, size_t nCount, float flTolerance, std::vector<uint8_t> &vecKeep)
+        {
+            const float flMinArea = flTolerance * flTolerance;
+            std::vector<size_t> vecPrev(nCount), vecNext(nCount);
+            std::vector<float> vecArea(nCount, 0.0f);
+
+            typedef std::pair<float, size_t> Entry_t;
+            std::vector<Entry_t> vecEntries;
+            vecEntries.reserve(nCount);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                vecKeep[i] = 1;
+                vecPrev[i] = i - 1;
+                vecNext[i] = i + 1;
+
+                if (i > 0 && i + 1 < nCount)
+                {
+                    vecArea[i] = TriangleArea(pPoints[i - 1], pPoints[i], pPoints[i + 1]);
+                    vecEntries.emplace_back(vecArea[i], i);
+                }
+            }
+
+            // Heapify once instead of pushing every point.
+            std::priority_queue<Entry_t, std::vector<Entry_t>, std::greater<Entry_t>> queue(std::greater<Entry_t>(), std::move(vecEntries));
+
+            while (!queue.empty())
+            {
+                const Entry_t entry = queue.top();
+                queue.pop();
+
+                // Skip entries made stale by a later update of the same point.
+                if (!vecKeep[entry.second] || entry.first != vecArea[entry.second])
+                    continue;
+
+                if (entry.first >= flMinArea)
+                    break;
+
+                const size_t nPrev = vecPrev[entry.second];
+                const size_t nNext = vecNext[entry.second];
+                vecKeep[entry.second] = 0;
+                vecNext[nPrev] = nNext;
+                vecPrev[nNext] = nPrev;
+
+                // A neighbour never gets a smaller area than the point just removed, so the order stays consistent.
+                if (nPrev > 0)
+                {
+                    vecArea[nPrev] = std::max(entry.first, TriangleArea(pPoints[vecPrev[nPrev]], pPoints[nPrev], pPoints[nNext]));
+                    queue.emplace(vecArea[nPrev], nPrev);
+                }
+
+                if (nNext + 1 < nCount)
+                {
+                    vecArea[nNext] = std::max(entry.first, TriangleArea(pPoints[nPrev], pPoints[nNext], pPoints[vecNext[nNext]]));
+                    queue.emplace(vecArea[nNext], nNext);
+                }
+            }
+        }
+
+        /**
+         * @brief Mark the first, lowest, highest and last point of every column of flColumnWidth pixels.
+         * Columns start at flOrigin, so chunks of one polyline agree on them.
+         * */
+        static void MarkMinMax(const CVector2D<float> *pPoints, size_t nCount, float flOrigin, float flColumnWidth, std::vector<uint8_t> &vecKeep)
+        {
+            const float flInvWidth = 1.0f / flColumnWidth;
+
+            size_t nColumnStart = 0;
+            size_t nMin = 0;
+            size_t nMax = 0;
+            int64_t nColumn = static_cast<int64_t>(std::floor((pPoints[0].GetX() - flOrigin) * flInvWidth));
+
+            for (size_t i = 1; i <= nCount; i++)
+            {
+                const int64_t nPointColumn = i < nCount ? static_cast<int64_t>(std::floor((pPoints[i].GetX() - flOrigin) * flInvWidth)) : nColumn + 1;
+
+                if (nPointColumn != nColumn)
+                {
+                    vecKeep[nColumnStart] = 1;
+                    vecKeep[nMin] = 1;
+                    vecKeep[nMax] = 1;
+                    vecKeep[i - 1] = 1;
+
+                    nColumn = nPointColumn;
+                    nColumnStart = nMin = nMax = i;
+                    continue;
+                }
+
+                if (pPoints[i].GetY() < pPoints[nMin].GetY())
+                    nMin = i;
+                if (pPoints[i].GetY() > pPoints[nMax].GetY())
+                    nMax = i;
+            }
+        }
+
+        void SimplifyChunk(const CVector2D<float> *pPoints, size_t nCount, float flOrigin, std::vector<CVector2D<float>> &vecOut) const
+        {
+            vecOut.clear();
+            if (nCount < 3)
+            {
+                vecOut.assign(pPoints, pPoints + nCount);
+                return;
+            }
+
+            std::vector<uint8_t> vecKeep(nCount, 0);
+
+            switch (m_nMode)
+            {
+            case SIMPLIFY_RDP:
+                MarkRDP(pPoints, nCount, m_flTolerance, vecKeep);
+                break;
+            case SIMPLIFY_VISVALINGAM:
+                MarkVisvalingam(pPoints, nCount, m_flTolerance, vecKeep);
+                break;
+            case SIMPLIFY_MINMAX:
+                MarkMinMax(pPoints, nCount, flOrigin, m_flTolerance, vecKeep);
+                break;
+            }
+
+            vecKeep[0] = 1;
+            vecKeep[nCount - 1] = 1;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                if (vecKeep[i])
+                    vecOut.push_back(pPoints[i]);
+            }
+        }
+
+    public:
+        CPolylineSimplifier(SimplifyMode_e nMode = SIMPLIFY_RDP, float flTolerance = 0.5f) : m_nMode(nMode) { SetTolerance(flTolerance); }
+
+        void SetMode(SimplifyMode_e nMode) { m_nMode = nMode; }
+        SimplifyMode_e GetMode() const { return m_nMode; }
+
+        /**
+         * @brief Set the tolerance in pixels: the maximum deviation for SIMPLIFY_RDP, the square root of the
+         * smallest kept triangle area for SIMPLIFY_VISVALINGAM, or the column width for SIMPLIFY_MINMAX.
+         * */
+        void SetTolerance(float flTolerance) { m_flTolerance = flTolerance > 1e-6f ? flTolerance : 1e-6f; }
+        float GetTolerance() const { return m_flTolerance; }
+
+        /**
+         * @brief Simplify a polyline. The first and last point are always kept.
+         * @param pPoints The points, in screen space.
+         * @param nCount The number of points.
+         * @param vecOut Receives the simplified polyline, ready for CDrawCommandList::DrawPolyline().
+         * */
+        void Simplify(const CVector2D<float> *pPoints, size_t nCount, std::vector<CVector2D<float>> &vecOut) const
+        {
+            CALI_PROFILE_SCOPE("CPolylineSimplifier::Simplify");
+
+            const size_t nChunks = nCount > 1 ? std::max<size_t>(1, std::min(CParallel::GetThreadCount(), nCount / MIN_POINTS_PER_THREAD)) : 1;
+            if (nChunks == 1)
+            {
+                SimplifyChunk(pPoints, nCount, nCount ? pPoints[0].GetX() : 0.0f, vecOut);
+                return;
+            }
+
+            // Chunk i covers segments [i * nSegments / nChunks, (i + 1) * nSegments / nChunks], sharing end points.
+            const size_t nSegments = nCount - 1;
+            std::vector<std::vector<CVector2D<float>>> vecChunks(nChunks);
+
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t i = nBegin; i < nEnd; i++)
+                               {
+                                   const size_t nFirst = i * nSegments / nChunks;
+                                   const size_t nLast = (i + 1) * nSegments / nChunks;
+                                   SimplifyChunk(pPoints + nFirst, nLast - nFirst + 1, pPoints[0].GetX(), vecChunks[i]);
+                               } });
+
+            size_t nTotal = 1;
+            for (const std::vector<CVector2D<float>> &vecChunk : vecChunks)
+                nTotal += vecChunk.size() - 1;
+
+            vecOut.clear();
+            vecOut.reserve(nTotal);
+            vecOut.push_back(pPoints[0]);
+
+            for (const std::vector<CVector2D<float>> &vecChunk : vecChunks)
+                vecOut.insert(vecOut.end(), vecChunk.begin() + 1, vecChunk.end());
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,339 @@
+#pragma once
+
+/**
+ * @file CProfiler.h
+ * @brief Contains the declaration of the CProfiler class and the profiling macros.
+ *
+ * Instrumentation is only compiled in when CALI_ENABLE_PROFILING is defined. Otherwise every
+ * CALI_PROFILE_* macro expands to nothing and this header declares no types.
+ *
+ * - CALI_PROFILE_SCOPE(name) times the enclosing scope.
+ * - CALI_PROFILE_COUNT(counter, value) adds to one of the per-frame ProfileCounter_e counters.
+ * - CALI_PROFILE_FRAME() closes the frame, emitting and resetting the counters.
+ *
+ * Events are written into lock-free per-thread ring buffers and exported as Chrome trace JSON,
+ * which chrome://tracing and Perfetto can open. A thread's buffer is recycled for the next thread
+ * once it exits, and events dropped because a buffer was full are reported in the trace.
+ */
+
+#ifdef CALI_ENABLE_PROFILING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Cali
+{
+    /**
+     * @brief Per-frame counters.
+     * */
+    enum ProfileCounter_e
+    {
+        PROFILE_COUNTER_PRIMITIVES = 0,
+        PROFILE_COUNTER_BATCHES,
+        PROFILE_COUNTER_VERTICES,
+        PROFILE_COUNTER_CULLED,
+        PROFILE_COUNTER_BYTES_UPLOADED,
+        PROFILE_COUNTER_COUNT
+    };
+
+    /**
+     * @brief A recorded profiling event.
+     * */
+    struct SProfileEvent
+    {
+        enum Type_e : uint8_t
+        {
+            TYPE_SCOPE = 0,
+            TYPE_COUNTER
+        };
+
+        const char *m_szName = nullptr;
+        uint64_t m_nTimestamp = 0;
+
+        /**
+         * @brief Duration in nanoseconds for scopes, the value for counters.
+         * */
+        uint64_t m_nValue = 0;
+
+        Type_e m_nType = TYPE_SCOPE;
+    };
+
+    /**
+     * @class CProfilerThreadBuffer
+     * @brief Single-producer single-consumer ring of events owned by one thread.
+     *
+     * The owning thread pushes without locking; events are dropped, and counted, while the ring is full.
+     * After the owning thread exits the buffer is drained and handed to the next new thread.
+     */
+    class CProfilerThreadBuffer
+    {
+    public:
+        static constexpr size_t CAPACITY = 1 << 16;
+
+    private:
+        std::array<SProfileEvent, CAPACITY> m_Events;
+        std::atomic<size_t> m_nHead = 0;
+        std::atomic<size_t> m_nTail = 0;
+        std::atomic<size_t> m_nDropped = 0;
+        uint32_t m_nThreadId;
+
+    public:
+        explicit CProfilerThreadBuffer(uint32_t nThreadId) : m_nThreadId(nThreadId) {}
+
+        uint32_t GetThreadId() const { return m_nThreadId; }
+        void SetThreadId(uint32_t nThreadId) { m_nThreadId = nThreadId; }
+
+        /**
+         * @brief Get the number of events dropped since the last call and reset it.
+         * */
+        size_t TakeDropped() { return m_nDropped.exchange(0, std::memory_order_relaxed); }
+
+        void Push(const SProfileEvent &event)
+        {
+            const size_t nHead = m_nHead.load(std::memory_order_relaxed);
+            if (nHead - m_nTail.load(std::memory_order_acquire) >= CAPACITY)
+            {
+                m_nDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            m_Events[nHead % CAPACITY] = event;
+            m_nHead.store(nHead + 1, std::memory_order_release);
+        }
+
+        template <typename TFunc>
+        void Drain(TFunc fnConsume)
+        {
+            const size_t nHead = m_nHead.load(std::memory_order_acquire);
+            size_t nTail = m_nTail.load(std::memory_order_relaxed);
+
+            for (; nTail != nHead; nTail++)
+                fnConsume(m_Events[nTail % CAPACITY]);
+
+            m_nTail.store(nTail, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @class CProfiler
+     * @brief Collects scoped timings and per-frame counters and exports them as a Chrome trace.
+     */
+    class CProfiler
+    {
+    private:
+        /**
+         * @brief Owns the calling thread's claim on a buffer and gives it back when the thread exits.
+         * */
+        class CThreadBufferSlot
+        {
+        public:
+            CProfilerThreadBuffer *m_pBuffer = nullptr;
+
+            ~CThreadBufferSlot()
+            {
+                if (m_pBuffer)
+                    CProfiler::Get().ReleaseThreadBuffer(*m_pBuffer);
+            }
+        };
+
+        std::mutex m_BuffersMutex;
+        std::vector<std::unique_ptr<CProfilerThreadBuffer>> m_vecBuffers = {};
+        std::vector<CProfilerThreadBuffer *> m_vecFreeBuffers = {};
+        uint32_t m_nNextThreadId = 0;
+        uint64_t m_nDropped = 0;
+        std::array<std::atomic<uint64_t>, PROFILE_COUNTER_COUNT> m_Counters = {};
+        std::vector<std::pair<uint32_t, SProfileEvent>> m_vecCollected = {};
+        const std::chrono::steady_clock::time_point m_Epoch = std::chrono::steady_clock::now();
+
+        static const char *GetCounterName(ProfileCounter_e nCounter)
+        {
+            static const char *const s_szNames[PROFILE_COUNTER_COUNT] = {"Primitives", "Batches", "Vertices", "Culled", "BytesUploaded"};
+            return s_szNames[nCounter];
+        }
+
+        CProfilerThreadBuffer &GetThreadBuffer()
+        {
+            thread_local CThreadBufferSlot s_Slot;
+            if (!s_Slot.m_pBuffer)
+            {
+                std::lock_guard<std::mutex> lock(m_BuffersMutex);
+
+                // Threads get a new id even when they reuse a buffer, so the trace tells them apart.
+                if (!m_vecFreeBuffers.empty())
+                {
+                    s_Slot.m_pBuffer = m_vecFreeBuffers.back();
+                    s_Slot.m_pBuffer->SetThreadId(m_nNextThreadId++);
+                    m_vecFreeBuffers.pop_back();
+                }
+                else
+                {
+                    m_vecBuffers.push_back(std::make_unique<CProfilerThreadBuffer>(m_nNextThreadId++));
+                    s_Slot.m_pBuffer = m_vecBuffers.back().get();
+                }
+            }
+
+            return *s_Slot.m_pBuffer;
+        }
+
+        /**
+         * @brief Move the events of a buffer into the collected ones. m_BuffersMutex must be held.
+         * */
+        void CollectBuffer(CProfilerThreadBuffer &buffer)
+        {
+            const uint32_t nThreadId = buffer.GetThreadId();
+            buffer.Drain([this, nThreadId](const SProfileEvent &event)
+                         { m_vecCollected.emplace_back(nThreadId, event); });
+
+            m_nDropped += buffer.TakeDropped();
+        }
+
+        /**
+         * @brief Collect the events of an exiting thread and make its buffer available to the next one.
+         * */
+        void ReleaseThreadBuffer(CProfilerThreadBuffer &buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_BuffersMutex);
+            CollectBuffer(buffer);
+            m_vecFreeBuffers.push_back(&buffer);
+        }
+
+        /**
+         * @brief Move the events of every buffer into the collected ones. m_BuffersMutex must be held.
+         * */
+        void Collect()
+        {
+            for (const std::unique_ptr<CProfilerThreadBuffer> &pBuffer : m_vecBuffers)
+                CollectBuffer(*pBuffer);
+        }
+
+    public:
+        /**
+         * @brief Get the process wide profiler.
+         * @return The profiler.
+         * */
+        static CProfiler &Get()
+        {
+            static CProfiler s_Profiler;
+            return s_Profiler;
+        }
+
+        /**
+         * @brief Get the time since the profiler was created.
+         * @return The time in nanoseconds.
+         * */
+        uint64_t Now() const
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Epoch).count());
+        }
+
+        void RecordScope(const char *szName, uint64_t nStart, uint64_t nEnd)
+        {
+            GetThreadBuffer().Push({szName, nStart, nEnd - nStart, SProfileEvent::TYPE_SCOPE});
+        }
+
+        void AddCounter(ProfileCounter_e nCounter, uint64_t nValue)
+        {
+            m_Counters[nCounter].fetch_add(nValue, std::memory_order_relaxed);
+        }
+
+        uint64_t GetCounter(ProfileCounter_e nCounter) const
+        {
+            return m_Counters[nCounter].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Emit the counters of the finished frame and reset them.
+         * */
+        void EndFrame()
+        {
+            const uint64_t nTimestamp = Now();
+            CProfilerThreadBuffer &buffer = GetThreadBuffer();
+
+            for (int i = 0; i < PROFILE_COUNTER_COUNT; i++)
+            {
+                const ProfileCounter_e nCounter = static_cast<ProfileCounter_e>(i);
+                buffer.Push({GetCounterName(nCounter), nTimestamp, m_Counters[i].exchange(0, std::memory_order_relaxed), SProfileEvent::TYPE_COUNTER});
+            }
+        }
+
+        /**
+         * @brief Write every event recorded so far as Chrome trace JSON and discard them.
+         * The number of events dropped because a thread's buffer was full is written to
+         * otherData.droppedEvents, so a truncated trace can be told from a complete one.
+         * @param szPath The output file.
+         * @return False if the file could not be written.
+         * */
+        bool ExportChromeTrace(const std::string &szPath)
+        {
+            // Exiting threads collect their events concurrently, so hold the lock until they are written.
+            std::lock_guard<std::mutex> lock(m_BuffersMutex);
+            Collect();
+
+            FILE *pFile = std::fopen(szPath.c_str(), "w");
+            if (!pFile)
+                return false;
+
+            std::fputs("{\"traceEvents\":[", pFile);
+
+            for (size_t i = 0; i < m_vecCollected.size(); i++)
+            {
+                const uint32_t nThreadId = m_vecCollected[i].first;
+                const SProfileEvent &event = m_vecCollected[i].second;
+                const double flTimestamp = static_cast<double>(event.m_nTimestamp) / 1000.0;
+
+                if (event.m_nType == SProfileEvent::TYPE_SCOPE)
+                    std::fprintf(pFile, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", i ? "," : "",
+                                 event.m_szName, nThreadId, flTimestamp, static_cast<double>(event.m_nValue) / 1000.0);
+                else
+                    std::fprintf(pFile, "%s\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%llu}}", i ? "," : "",
+                                 event.m_szName, nThreadId, flTimestamp, static_cast<unsigned long long>(event.m_nValue));
+            }
+
+            std::fprintf(pFile, "\n],\"otherData\":{\"droppedEvents\":%llu}}\n", static_cast<unsigned long long>(m_nDropped));
+            m_vecCollected.clear();
+            m_nDropped = 0;
+
+            return std::fclose(pFile) == 0;
+        }
+    };
+
+    /**
+     * @class CProfileScope
+     * @brief Records the lifetime of a scope, see CALI_PROFILE_SCOPE.
+     */
+    class CProfileScope
+    {
+    private:
+        const char *m_szName;
+        uint64_t m_nStart;
+
+    public:
+        explicit CProfileScope(const char *szName) : m_szName(szName), m_nStart(CProfiler::Get().Now()) {}
+        ~CProfileScope() { CProfiler::Get().RecordScope(m_szName, m_nStart, CProfiler::Get().Now()); }
+
+        CProfileScope(const CProfileScope &) = delete;
+        CProfileScope &operator=(const CProfileScope &) = delete;
+    };
+
+} // namespace Cali
+
+#define CALI_PROFILE_CONCAT_INNER(a, b) a##b
+#define CALI_PROFILE_CONCAT(a, b) CALI_PROFILE_CONCAT_INNER(a, b)
+#define CALI_PROFILE_SCOPE(name) ::Cali::CProfileScope CALI_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define CALI_PROFILE_COUNT(counter, value) ::Cali::CProfiler::Get().AddCounter(::Cali::counter, static_cast<uint64_t>(value))
+#define CALI_PROFILE_FRAME() ::Cali::CProfiler::Get().EndFrame()
+
+#else
+
+#define CALI_PROFILE_SCOPE(name)
+#define CALI_PROFILE_COUNT(counter, value)
+#define CALI_PROFILE_FRAME()
+
+#endif
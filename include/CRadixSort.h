@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file CRadixSort.h
+ * @brief Contains the declaration of the CRadixSort class.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CParallel.h"
+
+namespace Cali
+{
+    /**
+     * @class CRadixSort
+     * @brief Stable LSD radix sort of 64-bit keys carrying a value each.
+     *
+     * Sorts one byte per pass and skips passes in which every key has the same byte, so keys that
+     * only use a few of their bits cost only a few passes. Scratch storage is kept between calls.
+     *
+     * Inputs of at least MIN_KEYS_PER_THREAD keys per thread are split into chunks. Each chunk counts
+     * and scatters its keys on its own thread. The chunks' offsets into every bucket follow chunk
+     * order, so the sort stays stable.
+     *
+     * @tparam TValue The value type moved along with each key, typically an index.
+     */
+    template <typename TValue = uint32_t>
+    class CRadixSort
+    {
+    public:
+        static constexpr size_t MIN_KEYS_PER_THREAD = 64 * 1024;
+
+    private:
+        typedef std::array<std::array<size_t, 256>, 8> Histograms_t;
+
+        std::vector<uint64_t> m_vecKeysScratch = {};
+        std::vector<TValue> m_vecValuesScratch = {};
+        std::vector<Histograms_t> m_vecHistograms = {};
+
+    public:
+        /**
+         * @brief Sort keys ascending, keeping equal keys in their original order.
+         * @param vecKeys The keys.
+         * @param vecValues The values, reordered along with the keys.
+         * */
+        void Sort(std::vector<uint64_t> &vecKeys, std::vector<TValue> &vecValues)
+        {
+            const size_t nCount = vecKeys.size();
+            const size_t nChunks = std::max<size_t>(1, std::min(CParallel::GetThreadCount(), nCount / MIN_KEYS_PER_THREAD));
+            const size_t nChunkSize = (nCount + nChunks - 1) / nChunks;
+
+            m_vecKeysScratch.resize(nCount);
+            m_vecValuesScratch.resize(nCount);
+            m_vecHistograms.assign(nChunks, Histograms_t());
+
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                               {
+                                   Histograms_t &histograms = m_vecHistograms[nChunk];
+                                   const size_t nLast = std::min(nCount, (nChunk + 1) * nChunkSize);
+
+                                   for (size_t i = nChunk * nChunkSize; i < nLast; i++)
+                                   {
+                                       for (size_t nByte = 0; nByte < 8; nByte++)
+                                           histograms[nByte][(vecKeys[i] >> (nByte * 8)) & 0xFF]++;
+                                   }
+                               } });
+
+            bool bReordered = false;
+
+            for (size_t nByte = 0; nByte < 8; nByte++)
+            {
+                const size_t nFirstBucket = (vecKeys.empty() ? 0 : vecKeys[0] >> (nByte * 8)) & 0xFF;
+                size_t nFirstBucketSize = 0;
+                for (const Histograms_t &histograms : m_vecHistograms)
+                    nFirstBucketSize += histograms[nByte][nFirstBucket];
+
+                if (nFirstBucketSize == nCount)
+                    continue;
+
+                // Chunk counts only stay valid until a pass moves keys between chunks.
+                if (bReordered && nChunks > 1)
+                {
+                    CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                                   {
+                                       for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                                       {
+                                           std::array<size_t, 256> &histogram = m_vecHistograms[nChunk][nByte];
+                                           const size_t nLast = std::min(nCount, (nChunk + 1) * nChunkSize);
+
+                                           histogram.fill(0);
+                                           for (size_t i = nChunk * nChunkSize; i < nLast; i++)
+                                               histogram[(vecKeys[i] >> (nByte * 8)) & 0xFF]++;
+                                       } });
+                }
+
+                // Turn the counts into start offsets, bucket-major and chunk-minor.
+                size_t nOffset = 0;
+                for (size_t nBucket = 0; nBucket < 256; nBucket++)
+                {
+                    for (Histograms_t &histograms : m_vecHistograms)
+                    {
+                        const size_t nSize = histograms[nByte][nBucket];
+                        histograms[nByte][nBucket] = nOffset;
+                        nOffset += nSize;
+                    }
+                }
+
+                CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                               {
+                                   for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                                   {
+                                       std::array<size_t, 256> &offsets = m_vecHistograms[nChunk][nByte];
+                                       const size_t nLast = std::min(nCount, (nChunk + 1) * nChunkSize);
+
+                                       for (size_t i = nChunk * nChunkSize; i < nLast; i++)
+                                       {
+                                           const size_t nTarget = offsets[(vecKeys[i] >> (nByte * 8)) & 0xFF]++;
+                                           m_vecKeysScratch[nTarget] = vecKeys[i];
+                                           m_vecValuesScratch[nTarget] = vecValues[i];
+                                       }
+                                   } });
+
+                std::swap(vecKeys, m_vecKeysScratch);
+                std::swap(vecValues, m_vecValuesScratch);
+                bReordered = true;
+            }
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,574 @@
+#pragma once
+
+/**
+ * @file CRetainedScene.h
+ * @brief Contains the declaration of the CRetainedScene class.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "CDrawCommand.h"
+#include "CDrawManager.h"
+#include "CViewportCuller.h"
+#include "CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @brief Axis aligned rectangle in screen space.
+     * */
+    struct SSceneRect
+    {
+        float m_flMinX = 0.0f;
+        float m_flMinY = 0.0f;
+        float m_flMaxX = 0.0f;
+        float m_flMaxY = 0.0f;
+
+        bool IsEmpty() const { return m_flMinX >= m_flMaxX || m_flMinY >= m_flMaxY; }
+
+        bool Contains(const SSceneRect &other) const
+        {
+            return m_flMinX <= other.m_flMinX && m_flMinY <= other.m_flMinY && other.m_flMaxX <= m_flMaxX && other.m_flMaxY <= m_flMaxY;
+        }
+
+        /**
+         * @brief Check whether two rectangles overlap or touch.
+         * */
+        bool Intersects(const SSceneRect &other) const
+        {
+            return m_flMinX <= other.m_flMaxX && other.m_flMinX <= m_flMaxX && m_flMinY <= other.m_flMaxY && other.m_flMinY <= m_flMaxY;
+        }
+
+        void Merge(const SSceneRect &other)
+        {
+            m_flMinX = std::min(m_flMinX, other.m_flMinX);
+            m_flMinY = std::min(m_flMinY, other.m_flMinY);
+            m_flMaxX = std::max(m_flMaxX, other.m_flMaxX);
+            m_flMaxY = std::max(m_flMaxY, other.m_flMaxY);
+        }
+    };
+
+    /**
+     * @brief Stable reference to a primitive of a CRetainedScene.
+     * A handle stays valid until its primitive is removed; a slot reused afterwards gets a new generation,
+     * so stale handles are detected instead of aliasing the new primitive.
+     * */
+    struct SSceneHandle
+    {
+        uint32_t m_nIndex = UINT32_MAX;
+        uint32_t m_nGeneration = 0;
+
+        bool IsNull() const { return m_nIndex == UINT32_MAX; }
+    };
+
+    /**
+     * @class CRetainedScene
+     * @brief Optional retained layer on top of CDrawManager that only resubmits what changed.
+     *
+     * Primitives persist between frames. Adding, updating or removing one marks its old and new bounds
+     * dirty. Submit() then emits, for each dirty rectangle, a background rect followed by every primitive
+     * that intersects it, clipped to it and in the order the primitives were added. Primitives are found
+     * through a uniform grid over their bounds. When nothing changed Submit() returns without touching
+     * the manager, so a static screen costs nothing.
+     *
+     * Partial redraws rely on the render target keeping its contents between frames. Circles cannot be
+     * clipped (see CViewportCuller), so before a repaint every dirty rectangle is grown until it covers
+     * the bounds of each circle it touches, and nothing is painted outside the dirty rectangles.
+     * Emitted commands carry the scene's own sort keys, BACKGROUND_SORT_KEY for backgrounds and
+     * PRIMITIVE_SORT_KEY for primitives, so a manager sorting by state keeps backgrounds first and
+     * primitives in add order; the keys of the added commands are ignored.
+     */
+    class CRetainedScene
+    {
+    public:
+        static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+
+        /**
+         * @brief Above this many dirty rectangles they are collapsed into their union.
+         * */
+        static constexpr size_t MAX_DIRTY_RECTS = 16;
+
+        /**
+         * @brief Upper bound on the spatial index columns and rows; larger areas get larger cells.
+         * */
+        static constexpr size_t MAX_GRID_CELLS_PER_AXIS = 1024;
+
+        /**
+         * @brief Sort key of the background rects, the lowest possible one.
+         * CDrawBatcher sorts stably, so backgrounds stay ahead of every primitive of their region.
+         * */
+        static constexpr uint64_t BACKGROUND_SORT_KEY = 0;
+
+        /**
+         * @brief Sort key of every emitted primitive. All equal, so the stable sort leaves them in add order.
+         * */
+        static constexpr uint64_t PRIMITIVE_SORT_KEY = BACKGROUND_SORT_KEY + 1;
+
+    private:
+        struct SSlot
+        {
+            SDrawCommand m_Command;
+            SSceneRect m_Bounds;
+            uint64_t m_nSequence = 0;
+            uint32_t m_nGeneration = 0;
+            uint32_t m_nQueryStamp = 0;
+            bool m_bAlive = false;
+        };
+
+        std::vector<SSlot> m_vecSlots = {};
+        std::vector<uint32_t> m_vecFreeSlots = {};
+        uint64_t m_nNextSequence = 0;
+        uint32_t m_nQueryStamp = 0;
+        size_t m_nCount = 0;
+
+        SSceneRect m_SceneBounds = {};
+        float m_flCellSize = DEFAULT_CELL_SIZE;
+        size_t m_nColumns = 1;
+        size_t m_nRows = 1;
+        std::vector<std::vector<uint32_t>> m_vecCells = {};
+
+        std::vector<SSceneRect> m_vecDirtyRects = {};
+        uint32_t m_nBackgroundColor = 0xFF000000;
+
+        CViewportCuller m_Clipper;
+        std::vector<uint32_t> m_vecQuery = {};
+        std::vector<SDrawCommand> m_vecRegion = {};
+        std::vector<SDrawCommand> m_vecFrame = {};
+
+        static SSceneRect GetBounds(const SDrawCommand &command)
+        {
+            const CVector2D<float> *pPoints = command.m_Points;
+            SSceneRect bounds;
+
+            switch (command.m_nType)
+            {
+            case DRAW_COMMAND_CIRCLE:
+                bounds = {pPoints[0].GetX() - command.m_flRadius, pPoints[0].GetY() - command.m_flRadius,
+                          pPoints[0].GetX() + command.m_flRadius, pPoints[0].GetY() + command.m_flRadius};
+                break;
+            case DRAW_COMMAND_TRIANGLE:
+                bounds = {std::min({pPoints[0].GetX(), pPoints[1].GetX(), pPoints[2].GetX()}), std::min({pPoints[0].GetY(), pPoints[1].GetY(), pPoints[2].GetY()}),
+                          std::max({pPoints[0].GetX(), pPoints[1].GetX(), pPoints[2].GetX()}), std::max({pPoints[0].GetY(), pPoints[1].GetY(), pPoints[2].GetY()})};
+                break;
+            default:
+                bounds = {std::min(pPoints[0].GetX(), pPoints[1].GetX()), std::min(pPoints[0].GetY(), pPoints[1].GetY()),
+                          std::max(pPoints[0].GetX(), pPoints[1].GetX()), std::max(pPoints[0].GetY(), pPoints[1].GetY())};
+                break;
+            }
+
+            // Lines and outlines cover a pixel beyond their geometric bounds.
+            bounds.m_flMinX -= 1.0f;
+            bounds.m_flMinY -= 1.0f;
+            bounds.m_flMaxX += 1.0f;
+            bounds.m_flMaxY += 1.0f;
+            return bounds;
+        }
+
+        /**
+         * @brief Clamp a fractional cell coordinate to [0, nCells - 1] before converting it, so NaN and
+         * huge coordinates cannot overflow the conversion.
+         * */
+        static size_t ClampCell(float flCell, size_t nCells)
+        {
+            if (!(flCell > 0.0f))
+                return 0;
+
+            return flCell < static_cast<float>(nCells - 1) ? static_cast<size_t>(flCell) : nCells - 1;
+        }
+
+        size_t GetCellX(float flX) const { return ClampCell((flX - m_SceneBounds.m_flMinX) / m_flCellSize, m_nColumns); }
+        size_t GetCellY(float flY) const { return ClampCell((flY - m_SceneBounds.m_flMinY) / m_flCellSize, m_nRows); }
+
+        /**
+         * @brief Get the number of cells of edge flCellSize covering flExtent, at most MAX_GRID_CELLS_PER_AXIS.
+         * */
+        static size_t GetCellCount(float flExtent, float flCellSize)
+        {
+            return ClampCell(flExtent / flCellSize, MAX_GRID_CELLS_PER_AXIS) + 1;
+        }
+
+        /**
+         * @brief Grow the dirty rectangles until each contains every circle it intersects.
+         * Merging can pull in further circles, so this repeats until nothing grows.
+         * */
+        void CoverDirtyCircles()
+        {
+            for (size_t i = 0; i < m_vecDirtyRects.size();)
+            {
+                const SSceneRect rect = m_vecDirtyRects[i];
+                bool bGrown = false;
+
+                Query(rect, m_vecQuery);
+                for (uint32_t nSlot : m_vecQuery)
+                {
+                    const SSlot &slot = m_vecSlots[nSlot];
+                    if (slot.m_Command.m_nType != DRAW_COMMAND_CIRCLE)
+                        continue;
+
+                    const SSceneRect bounds = ClampToScene(slot.m_Bounds);
+                    if (bounds.IsEmpty() || rect.Contains(bounds))
+                        continue;
+
+                    MarkDirty(slot.m_Bounds);
+                    bGrown = true;
+                    break;
+                }
+
+                // MarkDirty() reorders the rectangles, so start over after any growth.
+                i = bGrown ? 0 : i + 1;
+            }
+        }
+
+        /**
+         * @brief Clamp a rectangle to the scene area. NaN coordinates become the scene's.
+         * */
+        SSceneRect ClampToScene(SSceneRect rect) const
+        {
+            rect.m_flMinX = std::max(m_SceneBounds.m_flMinX, rect.m_flMinX);
+            rect.m_flMinY = std::max(m_SceneBounds.m_flMinY, rect.m_flMinY);
+            rect.m_flMaxX = std::min(m_SceneBounds.m_flMaxX, rect.m_flMaxX);
+            rect.m_flMaxY = std::min(m_SceneBounds.m_flMaxY, rect.m_flMaxY);
+            return rect;
+        }
+
+        template <typename TFunc>
+        void ForEachCell(const SSceneRect &rect, TFunc fnVisit)
+        {
+            const size_t nMaxX = GetCellX(rect.m_flMaxX);
+            const size_t nMaxY = GetCellY(rect.m_flMaxY);
+
+            for (size_t y = GetCellY(rect.m_flMinY); y <= nMaxY; y++)
+                for (size_t x = GetCellX(rect.m_flMinX); x <= nMaxX; x++)
+                    fnVisit(m_vecCells[y * m_nColumns + x]);
+        }
+
+        void InsertIntoGrid(uint32_t nSlot)
+        {
+            ForEachCell(m_vecSlots[nSlot].m_Bounds, [nSlot](std::vector<uint32_t> &vecCell)
+                        { vecCell.push_back(nSlot); });
+        }
+
+        void RemoveFromGrid(uint32_t nSlot)
+        {
+            ForEachCell(m_vecSlots[nSlot].m_Bounds, [nSlot](std::vector<uint32_t> &vecCell)
+                        {
+                            const std::vector<uint32_t>::iterator it = std::find(vecCell.begin(), vecCell.end(), nSlot);
+                            if (it != vecCell.end())
+                            {
+                                *it = vecCell.back();
+                                vecCell.pop_back();
+                            } });
+        }
+
+        SSlot *Resolve(SSceneHandle handle)
+        {
+            if (handle.m_nIndex >= m_vecSlots.size())
+                return nullptr;
+
+            SSlot &slot = m_vecSlots[handle.m_nIndex];
+            return slot.m_bAlive && slot.m_nGeneration == handle.m_nGeneration ? &slot : nullptr;
+        }
+
+    public:
+        /**
+         * @brief Construct a scene.
+         * @param vecMin The top left corner of the screen area the scene covers.
+         * @param vecMax The bottom right corner of that area.
+         * @param flCellSize The edge length of a spatial index cell in pixels.
+         * */
+        CRetainedScene(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax, float flCellSize = DEFAULT_CELL_SIZE)
+        {
+            Resize(vecMin, vecMax, flCellSize);
+        }
+
+        /**
+         * @brief Change the screen area, rebuild the spatial index and mark everything dirty.
+         *
+         * Non-finite coordinates are replaced by 0 and swapped corners are put in order. Areas wider or
+         * taller than MAX_GRID_CELLS_PER_AXIS cells get larger cells instead of more of them.
+         *
+         * @param vecMin The top left corner.
+         * @param vecMax The bottom right corner.
+         * @param flCellSize The edge length of a spatial index cell in pixels, at least 1.
+         * */
+        void Resize(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax, float flCellSize = DEFAULT_CELL_SIZE)
+        {
+            const auto fnFinite = [](float flValue)
+            { return std::isfinite(flValue) ? flValue : 0.0f; };
+
+            const float flX0 = fnFinite(vecMin.GetX()), flX1 = fnFinite(vecMax.GetX());
+            const float flY0 = fnFinite(vecMin.GetY()), flY1 = fnFinite(vecMax.GetY());
+            m_SceneBounds = {std::min(flX0, flX1), std::min(flY0, flY1), std::max(flX0, flX1), std::max(flY0, flY1)};
+
+            // The extent of huge areas can overflow to infinity; the cell size then stays finite.
+            const float flWidth = std::min(m_SceneBounds.m_flMaxX - m_SceneBounds.m_flMinX, FLT_MAX);
+            const float flHeight = std::min(m_SceneBounds.m_flMaxY - m_SceneBounds.m_flMinY, FLT_MAX);
+            const float flMaxExtent = std::max(flWidth, flHeight);
+
+            m_flCellSize = flCellSize > 1.0f && std::isfinite(flCellSize) ? flCellSize : 1.0f;
+            m_flCellSize = std::max(m_flCellSize, flMaxExtent / static_cast<float>(MAX_GRID_CELLS_PER_AXIS));
+            m_nColumns = GetCellCount(flWidth, m_flCellSize);
+            m_nRows = GetCellCount(flHeight, m_flCellSize);
+
+            m_vecCells.assign(m_nColumns * m_nRows, {});
+            for (uint32_t i = 0; i < m_vecSlots.size(); i++)
+            {
+                if (m_vecSlots[i].m_bAlive)
+                    InsertIntoGrid(i);
+            }
+
+            m_Clipper.SetViewport(CVector2D<float>(m_SceneBounds.m_flMinX, m_SceneBounds.m_flMinY),
+                                  CVector2D<float>(m_SceneBounds.m_flMaxX, m_SceneBounds.m_flMaxY));
+            MarkAllDirty();
+        }
+
+        /**
+         * @brief Set the color dirty rectangles are cleared to before they are redrawn.
+         * @param nColor The packed ARGB color.
+         * */
+        void SetBackgroundColor(uint32_t nColor)
+        {
+            m_nBackgroundColor = nColor;
+            MarkAllDirty();
+        }
+
+        /**
+         * @brief Add a primitive on top of all existing ones.
+         * @param command The primitive.
+         * @return The handle of the primitive.
+         * */
+        SSceneHandle Add(const SDrawCommand &command)
+        {
+            uint32_t nSlot;
+            if (!m_vecFreeSlots.empty())
+            {
+                nSlot = m_vecFreeSlots.back();
+                m_vecFreeSlots.pop_back();
+            }
+            else
+            {
+                nSlot = static_cast<uint32_t>(m_vecSlots.size());
+                m_vecSlots.emplace_back();
+            }
+
+            SSlot &slot = m_vecSlots[nSlot];
+            slot.m_Command = command;
+            slot.m_Bounds = GetBounds(command);
+            slot.m_nSequence = m_nNextSequence++;
+            slot.m_bAlive = true;
+            m_nCount++;
+
+            InsertIntoGrid(nSlot);
+            MarkDirty(slot.m_Bounds);
+
+            return {nSlot, slot.m_nGeneration};
+        }
+
+        /**
+         * @brief Replace a primitive, keeping its place in the draw order.
+         * @param handle The handle of the primitive.
+         * @param command The new primitive.
+         * @return False if the handle is stale.
+         * */
+        bool Update(SSceneHandle handle, const SDrawCommand &command)
+        {
+            SSlot *pSlot = Resolve(handle);
+            if (!pSlot)
+                return false;
+
+            MarkDirty(pSlot->m_Bounds);
+            RemoveFromGrid(handle.m_nIndex);
+
+            pSlot->m_Command = command;
+            pSlot->m_Bounds = GetBounds(command);
+
+            InsertIntoGrid(handle.m_nIndex);
+            MarkDirty(pSlot->m_Bounds);
+            return true;
+        }
+
+        /**
+         * @brief Remove a primitive. Its handle, and every copy of it, becomes stale.
+         * @param handle The handle of the primitive.
+         * @return False if the handle is stale.
+         * */
+        bool Remove(SSceneHandle handle)
+        {
+            SSlot *pSlot = Resolve(handle);
+            if (!pSlot)
+                return false;
+
+            MarkDirty(pSlot->m_Bounds);
+            RemoveFromGrid(handle.m_nIndex);
+
+            pSlot->m_bAlive = false;
+            pSlot->m_nGeneration++;
+            m_vecFreeSlots.push_back(handle.m_nIndex);
+            m_nCount--;
+            return true;
+        }
+
+        /**
+         * @brief Check whether a handle still refers to a primitive.
+         * */
+        bool IsValid(SSceneHandle handle) { return Resolve(handle) != nullptr; }
+
+        /**
+         * @brief Get a primitive.
+         * @return The primitive, or nullptr if the handle is stale.
+         * */
+        const SDrawCommand *Get(SSceneHandle handle)
+        {
+            const SSlot *pSlot = Resolve(handle);
+            return pSlot ? &pSlot->m_Command : nullptr;
+        }
+
+        /**
+         * @brief Get the number of primitives in the scene.
+         * */
+        size_t GetCount() const { return m_nCount; }
+
+        /**
+         * @brief Force a region to be redrawn by the next Submit().
+         * @param rect The region, clamped to the scene area.
+         * */
+        void MarkDirty(SSceneRect rect)
+        {
+            rect = ClampToScene(rect);
+
+            if (rect.IsEmpty())
+                return;
+
+            // Absorb every rectangle the new one touches; a merge can grow it into further ones.
+            for (size_t i = 0; i < m_vecDirtyRects.size();)
+            {
+                if (m_vecDirtyRects[i].Intersects(rect))
+                {
+                    rect.Merge(m_vecDirtyRects[i]);
+                    m_vecDirtyRects[i] = m_vecDirtyRects.back();
+                    m_vecDirtyRects.pop_back();
+                    i = 0;
+                    continue;
+                }
+
+                i++;
+            }
+
+            m_vecDirtyRects.push_back(rect);
+
+            if (m_vecDirtyRects.size() > MAX_DIRTY_RECTS)
+            {
+                for (size_t i = 1; i < m_vecDirtyRects.size(); i++)
+                    m_vecDirtyRects[0].Merge(m_vecDirtyRects[i]);
+
+                m_vecDirtyRects.resize(1);
+            }
+        }
+
+        /**
+         * @brief Force the whole scene to be redrawn by the next Submit().
+         * */
+        void MarkAllDirty()
+        {
+            m_vecDirtyRects.assign(1, m_SceneBounds);
+        }
+
+        /**
+         * @brief Get the regions marked dirty. They never overlap.
+         * The next Submit() redraws them, grown to cover the circles they touch.
+         * */
+        const std::vector<SSceneRect> &GetDirtyRects() const { return m_vecDirtyRects; }
+
+        /**
+         * @brief Collect the primitives intersecting a region, in draw order.
+         * @param rect The region.
+         * @param vecSlots Receives the slot indices of the primitives.
+         * */
+        void Query(const SSceneRect &rect, std::vector<uint32_t> &vecSlots)
+        {
+            vecSlots.clear();
+
+            if (++m_nQueryStamp == 0)
+            {
+                for (SSlot &slot : m_vecSlots)
+                    slot.m_nQueryStamp = 0;
+
+                m_nQueryStamp = 1;
+            }
+
+            ForEachCell(rect, [this, &rect, &vecSlots](const std::vector<uint32_t> &vecCell)
+                        {
+                            for (uint32_t nSlot : vecCell)
+                            {
+                                SSlot &slot = m_vecSlots[nSlot];
+                                if (slot.m_nQueryStamp == m_nQueryStamp)
+                                    continue;
+
+                                slot.m_nQueryStamp = m_nQueryStamp;
+                                if (slot.m_Bounds.Intersects(rect))
+                                    vecSlots.push_back(nSlot);
+                            } });
+
+            std::sort(vecSlots.begin(), vecSlots.end(), [this](uint32_t nLeft, uint32_t nRight)
+                      { return m_vecSlots[nLeft].m_nSequence < m_vecSlots[nRight].m_nSequence; });
+        }
+
+        /**
+         * @brief Build the commands that repaint the dirty rectangles and clear them.
+         * @param vecCommands Receives the commands, empty if nothing changed.
+         * */
+        void BuildDirtyFrame(std::vector<SDrawCommand> &vecCommands)
+        {
+            vecCommands.clear();
+            CoverDirtyCircles();
+
+            for (const SSceneRect &rect : m_vecDirtyRects)
+            {
+                m_vecRegion.clear();
+
+                SDrawCommand background;
+                background.m_nType = DRAW_COMMAND_RECT;
+                background.m_Points[0] = CVector2D<float>(rect.m_flMinX, rect.m_flMinY);
+                background.m_Points[1] = CVector2D<float>(rect.m_flMaxX, rect.m_flMaxY);
+                background.m_nColor = m_nBackgroundColor;
+                background.m_nSortKey = BACKGROUND_SORT_KEY;
+                m_vecRegion.push_back(background);
+
+                Query(rect, m_vecQuery);
+                for (uint32_t nSlot : m_vecQuery)
+                {
+                    SDrawCommand &command = m_vecRegion.emplace_back(m_vecSlots[nSlot].m_Command);
+                    command.m_nSortKey = PRIMITIVE_SORT_KEY;
+                }
+
+                m_Clipper.SetViewport(CVector2D<float>(rect.m_flMinX, rect.m_flMinY), CVector2D<float>(rect.m_flMaxX, rect.m_flMaxY));
+                m_Clipper.Cull(m_vecRegion);
+
+                vecCommands.insert(vecCommands.end(), m_vecRegion.begin(), m_vecRegion.end());
+            }
+
+            m_vecDirtyRects.clear();
+        }
+
+        /**
+         * @brief Submit the repaint of the dirty rectangles as one frame.
+         * @param manager The manager.
+         * @return False if nothing changed and nothing was submitted.
+         * */
+        template <typename TBackend>
+        bool Submit(CDrawManager<TBackend> &manager)
+        {
+            if (m_vecDirtyRects.empty())
+                return false;
+
+            BuildDirtyFrame(m_vecFrame);
+            manager.SubmitFrame(m_vecFrame);
+            return true;
+        }
+    };
+
+} // namespace Cali
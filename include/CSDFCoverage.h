@@ -0,0 +1,384 @@
+#pragma once
+
+/**
+ * @file CSDFCoverage.h
+ * @brief Contains the declaration of the CSDFCoverage class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CDrawCommand.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @class CSDFCoverage
+     * @brief Anti-aliased software rasterizer based on analytic signed distance.
+     *
+     * Each pixel takes one sample at its centre. The signed distance d from that sample to the shape edge
+     * gives the coverage clamp(0.5 - d, 0, 1), i.e. the fraction of a one pixel wide box filter that
+     * lies inside. The shapes are rounded rects, circles, capsule lines and triangles.
+     *
+     * Distances are evaluated four pixels at a time along a row when SSE2 is available. Pixels are
+     * 0xAARRGGBB and blended source-over.
+     */
+    class CSDFCoverage
+    {
+    private:
+#ifdef CALI_SIMD_SSE2
+        /**
+         * @brief Four lanes of floats, so one distance function serves the scalar and SIMD paths.
+         * */
+        struct SFloat4
+        {
+            __m128 m_Value;
+
+            SFloat4(__m128 value) : m_Value(value) {}
+            SFloat4(float flValue) : m_Value(_mm_set1_ps(flValue)) {}
+
+            friend SFloat4 operator+(SFloat4 a, SFloat4 b) { return _mm_add_ps(a.m_Value, b.m_Value); }
+            friend SFloat4 operator-(SFloat4 a, SFloat4 b) { return _mm_sub_ps(a.m_Value, b.m_Value); }
+            friend SFloat4 operator*(SFloat4 a, SFloat4 b) { return _mm_mul_ps(a.m_Value, b.m_Value); }
+        };
+
+        static SFloat4 Min(SFloat4 a, SFloat4 b) { return _mm_min_ps(a.m_Value, b.m_Value); }
+        static SFloat4 Max(SFloat4 a, SFloat4 b) { return _mm_max_ps(a.m_Value, b.m_Value); }
+        static SFloat4 Sqrt(SFloat4 a) { return _mm_sqrt_ps(a.m_Value); }
+        static SFloat4 Abs(SFloat4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.m_Value); }
+
+        /**
+         * @brief -value where condition > 0, value elsewhere.
+         * */
+        static SFloat4 NegateWherePositive(SFloat4 value, SFloat4 condition)
+        {
+            const __m128 mask = _mm_cmpgt_ps(condition.m_Value, _mm_setzero_ps());
+            return _mm_xor_ps(value.m_Value, _mm_and_ps(mask, _mm_set1_ps(-0.0f)));
+        }
+#endif
+
+        static float Min(float a, float b) { return a < b ? a : b; }
+        static float Max(float a, float b) { return a > b ? a : b; }
+        static float Sqrt(float a) { return std::sqrt(a); }
+        static float Abs(float a) { return std::fabs(a); }
+        static float NegateWherePositive(float value, float condition) { return condition > 0.0f ? -value : value; }
+
+        template <typename T>
+        static T Clamp01(T value) { return Min(Max(value, T(0.0f)), T(1.0f)); }
+
+        struct SCircle
+        {
+            float m_flCenterX, m_flCenterY, m_flRadius;
+
+            template <typename T>
+            T Distance(T x, T y) const
+            {
+                const T dx = x - T(m_flCenterX);
+                const T dy = y - T(m_flCenterY);
+                return Sqrt(dx * dx + dy * dy) - T(m_flRadius);
+            }
+        };
+
+        struct SRoundedRect
+        {
+            float m_flCenterX, m_flCenterY, m_flInnerHalfX, m_flInnerHalfY, m_flRadius;
+
+            template <typename T>
+            T Distance(T x, T y) const
+            {
+                const T qx = Abs(x - T(m_flCenterX)) - T(m_flInnerHalfX);
+                const T qy = Abs(y - T(m_flCenterY)) - T(m_flInnerHalfY);
+                const T ox = Max(qx, T(0.0f));
+                const T oy = Max(qy, T(0.0f));
+                return Sqrt(ox * ox + oy * oy) + Min(Max(qx, qy), T(0.0f)) - T(m_flRadius);
+            }
+        };
+
+        struct SCapsule
+        {
+            float m_flStartX, m_flStartY, m_flDeltaX, m_flDeltaY, m_flInvLengthSqr, m_flRadius;
+
+            template <typename T>
+            T Distance(T x, T y) const
+            {
+                const T px = x - T(m_flStartX);
+                const T py = y - T(m_flStartY);
+                const T h = Clamp01((px * T(m_flDeltaX) + py * T(m_flDeltaY)) * T(m_flInvLengthSqr));
+                const T dx = px - T(m_flDeltaX) * h;
+                const T dy = py - T(m_flDeltaY) * h;
+                return Sqrt(dx * dx + dy * dy) - T(m_flRadius);
+            }
+        };
+
+        struct STriangle
+        {
+            float m_flPointX[3], m_flPointY[3];
+            float m_flEdgeX[3], m_flEdgeY[3];
+            float m_flInvEdgeLengthSqr[3];
+            float m_flWinding;
+
+            template <typename T>
+            T Distance(T x, T y) const
+            {
+                T flMinDistanceSqr = T(3.402823e38f);
+                T flMinSide = T(3.402823e38f);
+
+                for (int i = 0; i < 3; i++)
+                {
+                    const T vx = x - T(m_flPointX[i]);
+                    const T vy = y - T(m_flPointY[i]);
+                    const T h = Clamp01((vx * T(m_flEdgeX[i]) + vy * T(m_flEdgeY[i])) * T(m_flInvEdgeLengthSqr[i]));
+                    const T qx = vx - T(m_flEdgeX[i]) * h;
+                    const T qy = vy - T(m_flEdgeY[i]) * h;
+
+                    flMinDistanceSqr = Min(flMinDistanceSqr, qx * qx + qy * qy);
+                    flMinSide = Min(flMinSide, T(m_flWinding) * (vx * T(m_flEdgeY[i]) - vy * T(m_flEdgeX[i])));
+                }
+
+                // Outside of any edge the side term is negative, inside all of them it is positive.
+                return NegateWherePositive(Sqrt(flMinDistanceSqr), flMinSide);
+            }
+        };
+
+        std::vector<uint32_t> m_vecPixels = {};
+        size_t m_nWidth = 0;
+        size_t m_nHeight = 0;
+
+        float m_flLineWidth = 1.0f;
+        float m_flCornerRadius = 0.0f;
+
+        static float SafeInverse(float flValue) { return flValue > 1e-12f ? 1.0f / flValue : 0.0f; }
+
+        static void Blend(uint32_t &nDestination, uint32_t nColor, float flCoverage)
+        {
+            const float flAlpha = static_cast<float>(nColor >> 24) * (1.0f / 255.0f) * flCoverage;
+            const float flInverse = 1.0f - flAlpha;
+
+            const auto Channel = [&](int nShift)
+            {
+                const float flSource = static_cast<float>((nColor >> nShift) & 0xFF);
+                const float flDest = static_cast<float>((nDestination >> nShift) & 0xFF);
+                return static_cast<uint32_t>(flSource * flAlpha + flDest * flInverse + 0.5f) << nShift;
+            };
+
+            const float flDestAlpha = static_cast<float>(nDestination >> 24) * (1.0f / 255.0f);
+            const uint32_t nAlpha = static_cast<uint32_t>((flAlpha + flDestAlpha * flInverse) * 255.0f + 0.5f);
+
+            nDestination = (nAlpha << 24) | Channel(16) | Channel(8) | Channel(0);
+        }
+
+        /**
+         * @brief Evaluate and blend a shape over its bounds, grown by the one pixel filter footprint.
+         * */
+        template <typename TShape>
+        void Fill(const TShape &shape, float flMinX, float flMinY, float flMaxX, float flMaxY, uint32_t nColor)
+        {
+            if (!m_nWidth || !m_nHeight || !(nColor >> 24))
+                return;
+
+            const long nStartX = std::max(0L, static_cast<long>(std::floor(flMinX - 1.0f)));
+            const long nStartY = std::max(0L, static_cast<long>(std::floor(flMinY - 1.0f)));
+            const long nEndX = std::min(static_cast<long>(m_nWidth), static_cast<long>(std::ceil(flMaxX + 1.0f)));
+            const long nEndY = std::min(static_cast<long>(m_nHeight), static_cast<long>(std::ceil(flMaxY + 1.0f)));
+
+            for (long y = nStartY; y < nEndY; y++)
+            {
+                uint32_t *pRow = &m_vecPixels[static_cast<size_t>(y) * m_nWidth];
+                const float flY = static_cast<float>(y) + 0.5f;
+                long x = nStartX;
+
+#ifdef CALI_SIMD_SSE2
+                const SFloat4 vecY(flY);
+                const __m128 vecLanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                alignas(16) float arrCoverage[4];
+
+                for (; x + 4 <= nEndX; x += 4)
+                {
+                    const SFloat4 vecX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), vecLanes);
+                    const SFloat4 vecCoverage = Clamp01(SFloat4(0.5f) - shape.Distance(vecX, vecY));
+
+                    // Skip spans the shape does not touch without leaving the vector path.
+                    if (_mm_movemask_ps(_mm_cmpgt_ps(vecCoverage.m_Value, _mm_setzero_ps())) == 0)
+                        continue;
+
+                    _mm_store_ps(arrCoverage, vecCoverage.m_Value);
+                    for (int i = 0; i < 4; i++)
+                    {
+                        if (arrCoverage[i] > 0.0f)
+                            Blend(pRow[x + i], nColor, arrCoverage[i]);
+                    }
+                }
+#endif
+
+                for (; x < nEndX; x++)
+                {
+                    const float flCoverage = Clamp01(0.5f - shape.Distance(static_cast<float>(x) + 0.5f, flY));
+                    if (flCoverage > 0.0f)
+                        Blend(pRow[x], nColor, flCoverage);
+                }
+            }
+        }
+
+    public:
+        CSDFCoverage() = default;
+        CSDFCoverage(size_t nWidth, size_t nHeight) { Resize(nWidth, nHeight); }
+
+        /**
+         * @brief Resize the target. The contents are cleared to transparent black.
+         * */
+        void Resize(size_t nWidth, size_t nHeight)
+        {
+            m_nWidth = nWidth;
+            m_nHeight = nHeight;
+            m_vecPixels.assign(nWidth * nHeight, 0);
+        }
+
+        void Clear(uint32_t nColor = 0) { std::fill(m_vecPixels.begin(), m_vecPixels.end(), nColor); }
+
+        size_t GetWidth() const { return m_nWidth; }
+        size_t GetHeight() const { return m_nHeight; }
+
+        /**
+         * @brief Get the pixels, row by row, as 0xAARRGGBB.
+         * */
+        const uint32_t *GetPixels() const { return m_vecPixels.data(); }
+
+        /**
+         * @brief Set the width of lines drawn by DrawLine(), Draw() and DrawCommands(). Defaults to one pixel.
+         * */
+        void SetLineWidth(float flLineWidth) { m_flLineWidth = flLineWidth; }
+
+        /**
+         * @brief Set the corner radius of rects drawn by DrawRect(), Draw() and DrawCommands(). Defaults to square corners.
+         * */
+        void SetCornerRadius(float flCornerRadius) { m_flCornerRadius = flCornerRadius; }
+
+        void FillCircle(const CVector2D<float> &vecCenter, float flRadius, uint32_t nColor)
+        {
+            const SCircle circle = {vecCenter.GetX(), vecCenter.GetY(), flRadius};
+            Fill(circle, vecCenter.GetX() - flRadius, vecCenter.GetY() - flRadius, vecCenter.GetX() + flRadius, vecCenter.GetY() + flRadius, nColor);
+        }
+
+        /**
+         * @brief Fill a rect with rounded corners.
+         * @param vecMin One corner.
+         * @param vecMax The opposite corner.
+         * @param flRadius The corner radius, limited to half the shorter side.
+         * @param nColor The color.
+         * */
+        void FillRoundedRect(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax, float flRadius, uint32_t nColor)
+        {
+            const float flMinX = std::min(vecMin.GetX(), vecMax.GetX());
+            const float flMinY = std::min(vecMin.GetY(), vecMax.GetY());
+            const float flMaxX = std::max(vecMin.GetX(), vecMax.GetX());
+            const float flMaxY = std::max(vecMin.GetY(), vecMax.GetY());
+            const float flHalfX = 0.5f * (flMaxX - flMinX);
+            const float flHalfY = 0.5f * (flMaxY - flMinY);
+
+            flRadius = std::max(0.0f, std::min(flRadius, std::min(flHalfX, flHalfY)));
+
+            const SRoundedRect rect = {flMinX + flHalfX, flMinY + flHalfY, flHalfX - flRadius, flHalfY - flRadius, flRadius};
+            Fill(rect, flMinX, flMinY, flMaxX, flMaxY, nColor);
+        }
+
+        /**
+         * @brief Fill a line with round caps.
+         * @param vecStart The start point.
+         * @param vecEnd The end point.
+         * @param flWidth The line width.
+         * @param nColor The color.
+         * */
+        void FillCapsule(const CVector2D<float> &vecStart, const CVector2D<float> &vecEnd, float flWidth, uint32_t nColor)
+        {
+            const float flDeltaX = vecEnd.GetX() - vecStart.GetX();
+            const float flDeltaY = vecEnd.GetY() - vecStart.GetY();
+            const float flRadius = 0.5f * flWidth;
+
+            const SCapsule capsule = {vecStart.GetX(), vecStart.GetY(), flDeltaX, flDeltaY, SafeInverse(flDeltaX * flDeltaX + flDeltaY * flDeltaY), flRadius};
+            Fill(capsule, std::min(vecStart.GetX(), vecEnd.GetX()) - flRadius, std::min(vecStart.GetY(), vecEnd.GetY()) - flRadius,
+                 std::max(vecStart.GetX(), vecEnd.GetX()) + flRadius, std::max(vecStart.GetY(), vecEnd.GetY()) + flRadius, nColor);
+        }
+
+        void FillTriangle(const CVector2D<float> &v1, const CVector2D<float> &v2, const CVector2D<float> &v3, uint32_t nColor)
+        {
+            const CVector2D<float> *pPoints[3] = {&v1, &v2, &v3};
+            STriangle triangle;
+
+            for (int i = 0; i < 3; i++)
+            {
+                triangle.m_flPointX[i] = pPoints[i]->GetX();
+                triangle.m_flPointY[i] = pPoints[i]->GetY();
+                triangle.m_flEdgeX[i] = pPoints[(i + 1) % 3]->GetX() - pPoints[i]->GetX();
+                triangle.m_flEdgeY[i] = pPoints[(i + 1) % 3]->GetY() - pPoints[i]->GetY();
+                triangle.m_flInvEdgeLengthSqr[i] = SafeInverse(triangle.m_flEdgeX[i] * triangle.m_flEdgeX[i] + triangle.m_flEdgeY[i] * triangle.m_flEdgeY[i]);
+            }
+
+            // Make the side test independent of the vertex order.
+            triangle.m_flWinding = triangle.m_flEdgeX[0] * triangle.m_flEdgeY[2] - triangle.m_flEdgeY[0] * triangle.m_flEdgeX[2] > 0.0f ? 1.0f : -1.0f;
+
+            Fill(triangle, std::min({v1.GetX(), v2.GetX(), v3.GetX()}), std::min({v1.GetY(), v2.GetY(), v3.GetY()}),
+                 std::max({v1.GetX(), v2.GetX(), v3.GetX()}), std::max({v1.GetY(), v2.GetY(), v3.GetY()}), nColor);
+        }
+
+        /**
+         * @brief Draw a line as a capsule of the configured line width.
+         * */
+        void DrawLine(const CVector2D<float> &vecStart, const CVector2D<float> &vecEnd, uint32_t nColor)
+        {
+            FillCapsule(vecStart, vecEnd, m_flLineWidth, nColor);
+        }
+
+        /**
+         * @brief Draw a rect with the configured corner radius.
+         * */
+        void DrawRect(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax, uint32_t nColor)
+        {
+            FillRoundedRect(vecMin, vecMax, m_flCornerRadius, nColor);
+        }
+
+        /**
+         * @brief Rasterize a draw command: lines as capsules, rects as rounded rects.
+         * @param command The command.
+         * */
+        void Draw(const SDrawCommand &command)
+        {
+            switch (command.m_nType)
+            {
+            case DRAW_COMMAND_LINE:
+                DrawLine(command.m_Points[0], command.m_Points[1], command.m_nColor);
+                break;
+            case DRAW_COMMAND_RECT:
+                DrawRect(command.m_Points[0], command.m_Points[1], command.m_nColor);
+                break;
+            case DRAW_COMMAND_CIRCLE:
+                FillCircle(command.m_Points[0], command.m_flRadius, command.m_nColor);
+                break;
+            case DRAW_COMMAND_TRIANGLE:
+                FillTriangle(command.m_Points[0], command.m_Points[1], command.m_Points[2], command.m_nColor);
+                break;
+            case DRAW_COMMAND_INDEXED_TRIANGLES:
+                // The triangles live in the frame's geometry, see ExpandIndexedTriangles().
+                break;
+            }
+        }
+
+        /**
+         * @brief Rasterize draw commands in order.
+         * @param vecCommands The commands.
+         * */
+        void DrawCommands(const std::vector<SDrawCommand> &vecCommands)
+        {
+            CALI_PROFILE_SCOPE("CSDFCoverage::DrawCommands");
+
+            for (const SDrawCommand &command : vecCommands)
+                Draw(command);
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,258 @@
+#pragma once
+
+/**
+ * @file CSpatialOrder.h
+ * @brief Contains the declaration of the CSpatialOrder class.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CProfiler.h"
+#include "CRadixSort.h"
+#include "CVector2D.h"
+#include "CVector3D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief Space-filling curve used by CSpatialOrder.
+     * */
+    enum SpatialCurve_e
+    {
+        /**
+         * @brief Z-order: interleaves the coordinate bits. Cheapest to encode.
+         * */
+        SPATIAL_CURVE_MORTON = 0,
+
+        /**
+         * @brief Hilbert curve: never jumps between distant cells, so neighbours in the order stay closer. 2D only;
+         * 3D input falls back to SPATIAL_CURVE_MORTON.
+         * */
+        SPATIAL_CURVE_HILBERT
+    };
+
+    /**
+     * @class CSpatialOrder
+     * @brief Encodes points as Morton or Hilbert keys and reorders collections along the curve.
+     *
+     * Coordinates are quantised to the bounds of the collection, 32 bits per axis in 2D and 21 in 3D, so
+     * every key fits 64 bits. Sorting by key puts points that are close in space close in memory, which
+     * helps the spatial indexing, tiling and rendering that follow. The keys are sorted with CRadixSort,
+     * which runs in parallel on large collections.
+     */
+    class CSpatialOrder
+    {
+    private:
+        CRadixSort<uint32_t> m_RadixSort;
+        std::vector<uint64_t> m_vecKeys = {};
+        std::vector<uint32_t> m_vecIndices = {};
+
+        template <typename TVector>
+        static void GetBounds(const TVector *pPoints, size_t nCount, double (&arrMin)[3], double (&arrScale)[3], int nDimensions, double flMaxCell)
+        {
+            double arrMax[3];
+            for (int i = 0; i < 3; i++)
+            {
+                arrMin[i] = 0.0;
+                arrMax[i] = 0.0;
+            }
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const double arrPoint[3] = {static_cast<double>(pPoints[i].GetX()), static_cast<double>(pPoints[i].GetY()), GetZ(pPoints[i])};
+                for (int j = 0; j < nDimensions; j++)
+                {
+                    arrMin[j] = i == 0 ? arrPoint[j] : std::min(arrMin[j], arrPoint[j]);
+                    arrMax[j] = i == 0 ? arrPoint[j] : std::max(arrMax[j], arrPoint[j]);
+                }
+            }
+
+            for (int j = 0; j < nDimensions; j++)
+                arrScale[j] = arrMax[j] > arrMin[j] ? flMaxCell / (arrMax[j] - arrMin[j]) : 0.0;
+        }
+
+        template <typename T>
+        static double GetZ(const CVector2D<T> &) { return 0.0; }
+
+        template <typename T>
+        static double GetZ(const CVector3D<T> &v) { return static_cast<double>(v.GetZ()); }
+
+        static uint32_t Quantize(double flValue, double flMin, double flScale, double flMaxCell)
+        {
+            const double flCell = (flValue - flMin) * flScale;
+            return static_cast<uint32_t>(flCell > 0.0 ? (flCell < flMaxCell ? flCell : flMaxCell) : 0.0);
+        }
+
+        template <typename T>
+        static uint64_t ComputeKey(const CVector2D<T> &v, const double (&arrMin)[3], const double (&arrScale)[3], SpatialCurve_e nCurve)
+        {
+            const uint32_t nX = Quantize(static_cast<double>(v.GetX()), arrMin[0], arrScale[0], 4294967295.0);
+            const uint32_t nY = Quantize(static_cast<double>(v.GetY()), arrMin[1], arrScale[1], 4294967295.0);
+            return nCurve == SPATIAL_CURVE_HILBERT ? EncodeHilbert2D(nX, nY) : EncodeMorton2D(nX, nY);
+        }
+
+        template <typename T>
+        static uint64_t ComputeKey(const CVector3D<T> &v, const double (&arrMin)[3], const double (&arrScale)[3], SpatialCurve_e)
+        {
+            const double flMaxCell = static_cast<double>(MAX_CELL_3D);
+            return EncodeMorton3D(Quantize(static_cast<double>(v.GetX()), arrMin[0], arrScale[0], flMaxCell),
+                                  Quantize(static_cast<double>(v.GetY()), arrMin[1], arrScale[1], flMaxCell),
+                                  Quantize(static_cast<double>(v.GetZ()), arrMin[2], arrScale[2], flMaxCell));
+        }
+
+        template <typename T>
+        static constexpr int GetDimensions(const CVector2D<T> *) { return 2; }
+
+        template <typename T>
+        static constexpr int GetDimensions(const CVector3D<T> *) { return 3; }
+
+    public:
+        /**
+         * @brief The largest quantised coordinate per axis in 3D.
+         * */
+        static constexpr uint32_t MAX_CELL_3D = (1u << 21) - 1;
+
+        /**
+         * @brief Spread the 32 bits of x to the even bits of the result.
+         * */
+        static uint64_t Part1By1(uint32_t x)
+        {
+#ifdef CALI_SIMD_BMI2
+            return _pdep_u64(x, 0x5555555555555555ull);
+#else
+            uint64_t n = x;
+            n = (n | (n << 16)) & 0x0000FFFF0000FFFFull;
+            n = (n | (n << 8)) & 0x00FF00FF00FF00FFull;
+            n = (n | (n << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            n = (n | (n << 2)) & 0x3333333333333333ull;
+            n = (n | (n << 1)) & 0x5555555555555555ull;
+            return n;
+#endif
+        }
+
+        /**
+         * @brief Spread the low 21 bits of x to every third bit of the result.
+         * */
+        static uint64_t Part1By2(uint32_t x)
+        {
+#ifdef CALI_SIMD_BMI2
+            return _pdep_u64(x, 0x1249249249249249ull);
+#else
+            uint64_t n = x & 0x1FFFFF;
+            n = (n | (n << 32)) & 0x001F00000000FFFFull;
+            n = (n | (n << 16)) & 0x001F0000FF0000FFull;
+            n = (n | (n << 8)) & 0x100F00F00F00F00Full;
+            n = (n | (n << 4)) & 0x10C30C30C30C30C3ull;
+            n = (n | (n << 2)) & 0x1249249249249249ull;
+            return n;
+#endif
+        }
+
+        /**
+         * @brief Interleave two 32-bit coordinates, x in the even bits.
+         * */
+        static uint64_t EncodeMorton2D(uint32_t nX, uint32_t nY) { return Part1By1(nX) | (Part1By1(nY) << 1); }
+
+        /**
+         * @brief Interleave three 21-bit coordinates, x in bits 0, 3, 6 and so on.
+         * */
+        static uint64_t EncodeMorton3D(uint32_t nX, uint32_t nY, uint32_t nZ) { return Part1By2(nX) | (Part1By2(nY) << 1) | (Part1By2(nZ) << 2); }
+
+        /**
+         * @brief The distance along the Hilbert curve through a 2^32 x 2^32 grid.
+         * */
+        static uint64_t EncodeHilbert2D(uint32_t nX, uint32_t nY)
+        {
+            uint64_t nDistance = 0;
+
+            for (uint32_t nSide = 1u << 31; nSide > 0; nSide >>= 1)
+            {
+                const uint32_t nRx = (nX & nSide) ? 1 : 0;
+                const uint32_t nRy = (nY & nSide) ? 1 : 0;
+                nDistance += static_cast<uint64_t>(nSide) * nSide * ((3 * nRx) ^ nRy);
+
+                // Rotate the quadrant so the sub-curve is entered and left at the right corners.
+                if (nRy == 0)
+                {
+                    if (nRx == 1)
+                    {
+                        nX = ~nX;
+                        nY = ~nY;
+                    }
+
+                    std::swap(nX, nY);
+                }
+            }
+
+            return nDistance;
+        }
+
+        /**
+         * @brief Compute the curve key of every point, quantised to the bounds of the collection.
+         * @param pPoints The points, CVector2D or CVector3D.
+         * @param nCount The number of points.
+         * @param vecKeys Receives one key per point.
+         * @param nCurve The curve. 3D points always use SPATIAL_CURVE_MORTON.
+         * */
+        template <typename TVector>
+        static void ComputeKeys(const TVector *pPoints, size_t nCount, std::vector<uint64_t> &vecKeys, SpatialCurve_e nCurve = SPATIAL_CURVE_MORTON)
+        {
+            const int nDimensions = GetDimensions(pPoints);
+            const double flMaxCell = nDimensions == 2 ? 4294967295.0 : static_cast<double>(MAX_CELL_3D);
+
+            double arrMin[3], arrScale[3];
+            GetBounds(pPoints, nCount, arrMin, arrScale, nDimensions, flMaxCell);
+
+            vecKeys.resize(nCount);
+            for (size_t i = 0; i < nCount; i++)
+                vecKeys[i] = ComputeKey(pPoints[i], arrMin, arrScale, nCurve);
+        }
+
+        /**
+         * @brief Compute the order that sorts points along the curve. Points with equal keys keep their order.
+         * @param pPoints The points, CVector2D or CVector3D.
+         * @param nCount The number of points, at most 2^32.
+         * @param vecOrder Receives the index of the point that goes first, then second and so on.
+         * @param nCurve The curve.
+         * */
+        template <typename TVector>
+        void ComputeOrder(const TVector *pPoints, size_t nCount, std::vector<uint32_t> &vecOrder, SpatialCurve_e nCurve = SPATIAL_CURVE_MORTON)
+        {
+            CALI_PROFILE_SCOPE("CSpatialOrder::ComputeOrder");
+
+            ComputeKeys(pPoints, nCount, m_vecKeys, nCurve);
+
+            vecOrder.resize(nCount);
+            for (size_t i = 0; i < nCount; i++)
+                vecOrder[i] = static_cast<uint32_t>(i);
+
+            m_RadixSort.Sort(m_vecKeys, vecOrder);
+        }
+
+        /**
+         * @brief Reorder a collection of points along the curve.
+         * @param vecPoints The points, CVector2D or CVector3D.
+         * @param nCurve The curve.
+         * */
+        template <typename TVector>
+        void Sort(std::vector<TVector> &vecPoints, SpatialCurve_e nCurve = SPATIAL_CURVE_MORTON)
+        {
+            CALI_PROFILE_SCOPE("CSpatialOrder::Sort");
+
+            ComputeOrder(vecPoints.data(), vecPoints.size(), m_vecIndices, nCurve);
+
+            std::vector<TVector> vecSorted;
+            vecSorted.reserve(vecPoints.size());
+            for (uint32_t nIndex : m_vecIndices)
+                vecSorted.push_back(vecPoints[nIndex]);
+
+            vecPoints.swap(vecSorted);
+        }
+    };
+
+} // namespace Cali
@@ -5,14 +5,23 @@
  * @brief Contains the declaration of the CVector2D class.
  */
 
+#ifdef CALI_VECTOR_EXPRESSIONS
+#include "CVectorExpression.h"
+#endif
+
 namespace Cali
 {
     /**
      * @class CVector2D
      * @brief Represents a 2D vector.
+     *
+     * With CALI_VECTOR_EXPRESSIONS defined, +, -, * and / build expression templates instead, see CVectorExpression.h.
      */
     template <typename T = double>
     class CVector2D
+#ifdef CALI_VECTOR_EXPRESSIONS
+        : public CVectorExpression<CVector2D<T>>
+#endif
     {
     private:
         /**
@@ -40,6 +49,36 @@ namespace Cali
          * */
         CVector2D(T x, T y) : m_X(x), m_Y(y) {}
 
+        /**
+         * @brief Copy constructor, declared because operator= is user-provided.
+         * */
+        CVector2D(const CVector2D &) = default;
+
+#ifdef CALI_VECTOR_EXPRESSIONS
+        typedef CVector2D Vector_t;
+        typedef T Value_t;
+        static constexpr size_t DIMENSIONS = 2;
+        static constexpr bool IS_LEAF = true;
+
+        /**
+         * @brief Evaluate a vector expression in one pass.
+         * @param expression The expression.
+         * */
+        template <typename TExpression>
+        CVector2D(const CVectorExpression<TExpression> &expression)
+            : m_X(expression.Derived().template GetComponent<0>()), m_Y(expression.Derived().template GetComponent<1>()) {}
+
+        template <typename TExpression>
+        CVector2D &operator=(const CVectorExpression<TExpression> &expression)
+        {
+            // Evaluate fully first, the expression may read this vector.
+            return *this = CVector2D(expression);
+        }
+
+        template <size_t N>
+        T GetComponent() const { return N == 0 ? m_X : m_Y; }
+#endif
+
         /**
          * @brief Get the X coordinate.
          * @return The X coordinate.
@@ -64,6 +103,7 @@ namespace Cali
          * */
         void SetY(T y) { m_Y = y; }
 
+#ifndef CALI_VECTOR_EXPRESSIONS
         /**
          * @brief Add two vectors.
          * @param vec The vector to add.
@@ -110,6 +150,8 @@ namespace Cali
             return CVector2D(m_X / scalar, m_Y / scalar);
         }
 
+#endif
+
         /**
          * @brief Overloaded addition operator for CVector2D class.
          *
@@ -227,6 +269,7 @@ namespace Cali
             return *this;
         }
 
+#ifndef CALI_VECTOR_EXPRESSIONS
         /**
          * @brief Overloaded negation operator for CVector2D class.
          * @param vec The CVector2D object to be negated.
@@ -235,6 +278,7 @@ namespace Cali
         {
             return CVector2D(-m_X, -m_Y);
         }
+#endif
 
         /**
          * @brief Get the length of the vector.
@@ -344,4 +388,13 @@ namespace Cali
         }
     };
 
+    /**
+     * @brief Convert a vector to the float coordinates the draw managers and backends work in.
+     * */
+    template <typename T>
+    CVector2D<float> ToFloat(const CVector2D<T> &vec)
+    {
+        return CVector2D<float>(static_cast<float>(vec.GetX()), static_cast<float>(vec.GetY()));
+    }
+
 } // namespace Cali
@@ -5,14 +5,26 @@
  * @brief Contains the declaration of the CVector3D class.
  */
 
+#include <cstddef>
+#include <functional>
+
+#ifdef CALI_VECTOR_EXPRESSIONS
+#include "CVectorExpression.h"
+#endif
+
 namespace Cali
 {
     /**
      * @class CVector3D
      * @brief Represents a 3D vector.
+     *
+     * With CALI_VECTOR_EXPRESSIONS defined, +, -, * and / build expression templates instead, see CVectorExpression.h.
      */
     template <typename T = double>
     class CVector3D
+#ifdef CALI_VECTOR_EXPRESSIONS
+        : public CVectorExpression<CVector3D<T>>
+#endif
     {
     private:
         /**
@@ -46,6 +58,37 @@ namespace Cali
          */
         CVector3D(T x, T y, T z) : m_X(x), m_Y(y), m_Z(z) {}
 
+        /**
+         * @brief Copy constructor, declared because operator= is user-provided.
+         */
+        CVector3D(const CVector3D &) = default;
+
+#ifdef CALI_VECTOR_EXPRESSIONS
+        typedef CVector3D Vector_t;
+        typedef T Value_t;
+        static constexpr size_t DIMENSIONS = 3;
+        static constexpr bool IS_LEAF = true;
+
+        /**
+         * @brief Evaluate a vector expression in one pass.
+         * @param expression The expression.
+         */
+        template <typename TExpression>
+        CVector3D(const CVectorExpression<TExpression> &expression)
+            : m_X(expression.Derived().template GetComponent<0>()), m_Y(expression.Derived().template GetComponent<1>()),
+              m_Z(expression.Derived().template GetComponent<2>()) {}
+
+        template <typename TExpression>
+        CVector3D &operator=(const CVectorExpression<TExpression> &expression)
+        {
+            // Evaluate fully first, the expression may read this vector.
+            return *this = CVector3D(expression);
+        }
+
+        template <size_t N>
+        T GetComponent() const { return N == 0 ? m_X : (N == 1 ? m_Y : m_Z); }
+#endif
+
         /**
          * @brief Get the X coordinate.
          * @return The X coordinate.
@@ -82,6 +125,7 @@ namespace Cali
          */
         void SetZ(T z) { m_Z = z; }
 
+#ifndef CALI_VECTOR_EXPRESSIONS
         /**
          * @brief Overloaded addition operator for CVector3D class.
          *
@@ -107,11 +151,7 @@ namespace Cali
 
         CVector3D operator-(const CVector3D &vec) const
         {
-            // Create a new CVector3D object with the differences of the corresponding components
-            CVector3D result(m_X - vec.m_X, m_Y - vec.m_Y, m_Z - vec.m_Z);
-
-            // Return the new CVector3D object
-            return result;
+            return CVector3D(m_X - vec.m_X, m_Y - vec.m_Y, m_Z - vec.m_Z);
         }
 
         /**
@@ -141,6 +181,8 @@ namespace Cali
             return CVector3D(m_X / scalar, m_Y / scalar, m_Z / scalar);
         }
 
+#endif
+
         /**
          * @brief Overloaded equality operator for CVector3D class.
          *
@@ -398,6 +440,7 @@ namespace Cali
             return *this;
         }
 
+#ifndef CALI_VECTOR_EXPRESSIONS
         /**
          * @brief Overloaded negation operator for CVector3D class.
          *
@@ -409,6 +452,7 @@ namespace Cali
         {
             return CVector3D(-m_X, -m_Y, -m_Z);
         }
+#endif
 
         /**
          * @brief Get the angle between two CVector3D objects.
@@ -444,3 +488,24 @@ namespace Cali
         }
     };
 } // namespace Cali
+
+namespace std
+{
+    /**
+     * @brief Hash consistent with CVector3D::operator==, so -0 and +0 hash alike.
+     * */
+    template <typename T>
+    struct hash<Cali::CVector3D<T>>
+    {
+        size_t operator()(const Cali::CVector3D<T> &vec) const
+        {
+            const hash<T> hasher;
+            size_t nSeed = 0;
+
+            for (const T value : {vec.GetX(), vec.GetY(), vec.GetZ()})
+                nSeed ^= hasher(value == T(0) ? T(0) : value) + 0x9E3779B9 + (nSeed << 6) + (nSeed >> 2);
+
+            return nSeed;
+        }
+    };
+} // namespace std
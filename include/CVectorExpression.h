@@ -0,0 +1,263 @@
+#pragma once
+
+/**
+ * @file CVectorExpression.h
+ * @brief Contains the declaration of the CVectorExpression class and its expression nodes.
+ *
+ * Opt-in: define CALI_VECTOR_EXPRESSIONS before including CVector2D.h or CVector3D.h. The arithmetic
+ * operators of both vectors then build expression nodes instead of vectors, so `a + b * s - c` is
+ * evaluated component by component in one pass when it is assigned, with no temporary vectors.
+ *
+ * A multiply followed by an add or subtract is lowered to std::fma when the compiler reports fast
+ * FMA (FP_FAST_FMA and FP_FAST_FMAF, e.g. with -mfma) and CALI_DISABLE_SIMD is not defined. Results
+ * then differ from the plain operators in the last bit.
+ *
+ * Nodes keep references to the vectors they were built from, so an expression must be assigned to a
+ * vector before those go out of scope: `auto x = a + b;` with temporaries a and b dangles.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace Cali
+{
+    /**
+     * @class CVectorExpression
+     * @brief CRTP base of every vector expression, including CVector2D and CVector3D themselves.
+     *
+     * A derived type provides Vector_t, Value_t, DIMENSIONS, IS_LEAF and GetComponent<N>().
+     */
+    template <typename TDerived>
+    class CVectorExpression
+    {
+    public:
+        const TDerived &Derived() const { return static_cast<const TDerived &>(*this); }
+
+        /**
+         * @brief Evaluate the expression into a vector.
+         * */
+        auto Eval() const { return typename TDerived::Vector_t(Derived()); }
+
+        auto GetX() const { return Derived().template GetComponent<0>(); }
+        auto GetY() const { return Derived().template GetComponent<1>(); }
+        auto GetZ() const { return Derived().template GetComponent<2>(); }
+
+        auto LengthSq() const { return Eval().LengthSq(); }
+        auto Length() const { return Eval().Length(); }
+    };
+
+    namespace VectorExpression
+    {
+        /**
+         * @brief Vectors are held by reference, nodes by value so temporaries of a chain stay alive.
+         * */
+        template <typename TExpression>
+        using Storage_t = typename std::conditional<TExpression::IS_LEAF, const TExpression &, const TExpression>::type;
+
+        template <typename T>
+        inline T MultiplyAdd(T a, T b, T c)
+        {
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF) && !defined(CALI_DISABLE_SIMD)
+            return std::fma(a, b, c);
+#else
+            return a * b + c;
+#endif
+        }
+
+        template <typename TLeft, typename TRight>
+        struct SCompatible
+        {
+            static_assert(std::is_same<typename TLeft::Vector_t, typename TRight::Vector_t>::value, "Vector expressions must share one vector type.");
+            typedef typename TLeft::Vector_t Vector_t;
+            typedef typename TLeft::Value_t Value_t;
+            static constexpr size_t DIMENSIONS = TLeft::DIMENSIONS;
+        };
+    } // namespace VectorExpression
+
+    /**
+     * @brief Vector times scalar.
+     * */
+    template <typename TExpression>
+    class CVectorScale : public CVectorExpression<CVectorScale<TExpression>>
+    {
+    public:
+        typedef typename TExpression::Vector_t Vector_t;
+        typedef typename TExpression::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = TExpression::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TExpression> m_Expression;
+        Value_t m_flScalar;
+
+        CVectorScale(const TExpression &expression, Value_t flScalar) : m_Expression(expression), m_flScalar(flScalar) {}
+
+        template <size_t N>
+        Value_t GetComponent() const { return m_Expression.template GetComponent<N>() * m_flScalar; }
+    };
+
+    /**
+     * @brief Vector divided by scalar. Divides rather than multiplying by the reciprocal, like the plain operator.
+     * */
+    template <typename TExpression>
+    class CVectorQuotient : public CVectorExpression<CVectorQuotient<TExpression>>
+    {
+    public:
+        typedef typename TExpression::Vector_t Vector_t;
+        typedef typename TExpression::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = TExpression::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TExpression> m_Expression;
+        Value_t m_flScalar;
+
+        CVectorQuotient(const TExpression &expression, Value_t flScalar) : m_Expression(expression), m_flScalar(flScalar) {}
+
+        template <size_t N>
+        Value_t GetComponent() const { return m_Expression.template GetComponent<N>() / m_flScalar; }
+    };
+
+    /**
+     * @brief Negated vector.
+     * */
+    template <typename TExpression>
+    class CVectorNegate : public CVectorExpression<CVectorNegate<TExpression>>
+    {
+    public:
+        typedef typename TExpression::Vector_t Vector_t;
+        typedef typename TExpression::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = TExpression::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TExpression> m_Expression;
+
+        explicit CVectorNegate(const TExpression &expression) : m_Expression(expression) {}
+
+        template <size_t N>
+        Value_t GetComponent() const { return -m_Expression.template GetComponent<N>(); }
+    };
+
+    /**
+     * @brief Sum of two vectors, fused with a scaled operand.
+     * */
+    template <typename TLeft, typename TRight>
+    class CVectorSum : public CVectorExpression<CVectorSum<TLeft, TRight>>
+    {
+    public:
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Vector_t Vector_t;
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = VectorExpression::SCompatible<TLeft, TRight>::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TLeft> m_Left;
+        VectorExpression::Storage_t<TRight> m_Right;
+
+        CVectorSum(const TLeft &left, const TRight &right) : m_Left(left), m_Right(right) {}
+
+        template <size_t N>
+        Value_t GetComponent() const { return m_Left.template GetComponent<N>() + m_Right.template GetComponent<N>(); }
+    };
+
+    template <typename TLeft, typename TRight>
+    class CVectorSum<CVectorScale<TLeft>, TRight> : public CVectorExpression<CVectorSum<CVectorScale<TLeft>, TRight>>
+    {
+    public:
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Vector_t Vector_t;
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = VectorExpression::SCompatible<TLeft, TRight>::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        const CVectorScale<TLeft> m_Left;
+        VectorExpression::Storage_t<TRight> m_Right;
+
+        CVectorSum(const CVectorScale<TLeft> &left, const TRight &right) : m_Left(left), m_Right(right) {}
+
+        template <size_t N>
+        Value_t GetComponent() const
+        {
+            return VectorExpression::MultiplyAdd(m_Left.m_Expression.template GetComponent<N>(), m_Left.m_flScalar, m_Right.template GetComponent<N>());
+        }
+    };
+
+    /**
+     * @brief Difference of two vectors, fused with a scaled right operand.
+     * */
+    template <typename TLeft, typename TRight>
+    class CVectorDifference : public CVectorExpression<CVectorDifference<TLeft, TRight>>
+    {
+    public:
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Vector_t Vector_t;
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = VectorExpression::SCompatible<TLeft, TRight>::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TLeft> m_Left;
+        VectorExpression::Storage_t<TRight> m_Right;
+
+        CVectorDifference(const TLeft &left, const TRight &right) : m_Left(left), m_Right(right) {}
+
+        template <size_t N>
+        Value_t GetComponent() const { return m_Left.template GetComponent<N>() - m_Right.template GetComponent<N>(); }
+    };
+
+    template <typename TLeft, typename TRight>
+    class CVectorDifference<TLeft, CVectorScale<TRight>> : public CVectorExpression<CVectorDifference<TLeft, CVectorScale<TRight>>>
+    {
+    public:
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Vector_t Vector_t;
+        typedef typename VectorExpression::SCompatible<TLeft, TRight>::Value_t Value_t;
+        static constexpr size_t DIMENSIONS = VectorExpression::SCompatible<TLeft, TRight>::DIMENSIONS;
+        static constexpr bool IS_LEAF = false;
+
+        VectorExpression::Storage_t<TLeft> m_Left;
+        const CVectorScale<TRight> m_Right;
+
+        CVectorDifference(const TLeft &left, const CVectorScale<TRight> &right) : m_Left(left), m_Right(right) {}
+
+        template <size_t N>
+        Value_t GetComponent() const
+        {
+            return VectorExpression::MultiplyAdd(-m_Right.m_Expression.template GetComponent<N>(), m_Right.m_flScalar, m_Left.template GetComponent<N>());
+        }
+    };
+
+    template <typename TLeft, typename TRight>
+    CVectorSum<TLeft, TRight> operator+(const CVectorExpression<TLeft> &left, const CVectorExpression<TRight> &right)
+    {
+        return CVectorSum<TLeft, TRight>(left.Derived(), right.Derived());
+    }
+
+    /**
+     * @brief Keep a * s on the right so b + a * s fuses like a * s + b.
+     * */
+    template <typename TLeft, typename TRight>
+    CVectorSum<CVectorScale<TRight>, TLeft> operator+(const CVectorExpression<TLeft> &left, const CVectorScale<TRight> &right)
+    {
+        return CVectorSum<CVectorScale<TRight>, TLeft>(right, left.Derived());
+    }
+
+    template <typename TLeft, typename TRight>
+    CVectorDifference<TLeft, TRight> operator-(const CVectorExpression<TLeft> &left, const CVectorExpression<TRight> &right)
+    {
+        return CVectorDifference<TLeft, TRight>(left.Derived(), right.Derived());
+    }
+
+    template <typename TExpression>
+    CVectorScale<TExpression> operator*(const CVectorExpression<TExpression> &expression, typename TExpression::Value_t flScalar)
+    {
+        return CVectorScale<TExpression>(expression.Derived(), flScalar);
+    }
+
+    template <typename TExpression>
+    CVectorQuotient<TExpression> operator/(const CVectorExpression<TExpression> &expression, typename TExpression::Value_t flScalar)
+    {
+        return CVectorQuotient<TExpression>(expression.Derived(), flScalar);
+    }
+
+    template <typename TExpression>
+    CVectorNegate<TExpression> operator-(const CVectorExpression<TExpression> &expression)
+    {
+        return CVectorNegate<TExpression>(expression.Derived());
+    }
+
+} // namespace Cali
@@ -0,0 +1,571 @@
+#pragma once
+
+/**
+ * @file CVectorReduction.h
+ * @brief Contains the declaration of the CVectorReduction class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "CVector3D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief Axis-aligned bounds of N-dimensional points.
+     * */
+    template <size_t N>
+    struct SBoundingBox
+    {
+        double m_arrMin[N];
+        double m_arrMax[N];
+
+        SBoundingBox()
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                m_arrMin[i] = std::numeric_limits<double>::infinity();
+                m_arrMax[i] = -std::numeric_limits<double>::infinity();
+            }
+        }
+
+        bool IsEmpty() const { return m_arrMin[0] > m_arrMax[0]; }
+
+        void Merge(const SBoundingBox &other)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                m_arrMin[i] = std::min(m_arrMin[i], other.m_arrMin[i]);
+                m_arrMax[i] = std::max(m_arrMax[i], other.m_arrMax[i]);
+            }
+        }
+    };
+
+    /**
+     * @brief Centroid and covariance of N-dimensional points.
+     * */
+    template <size_t N>
+    struct SMoments
+    {
+        size_t m_nCount = 0;
+        double m_arrCentroid[N] = {};
+
+        /**
+         * @brief The sums of products of deviations from the centroid; divide by m_nCount for the covariance.
+         * */
+        double m_arrDeviations[N][N] = {};
+
+        double GetCovariance(size_t i, size_t j) const { return m_nCount ? m_arrDeviations[i][j] / static_cast<double>(m_nCount) : 0.0; }
+
+        /**
+         * @brief Combine with the moments of another set, Chan et al.'s pairwise update.
+         * */
+        void Merge(const SMoments &other)
+        {
+            if (!other.m_nCount)
+                return;
+
+            if (!m_nCount)
+            {
+                *this = other;
+                return;
+            }
+
+            const double flCount = static_cast<double>(m_nCount + other.m_nCount);
+            const double flWeight = static_cast<double>(m_nCount) * static_cast<double>(other.m_nCount) / flCount;
+
+            double arrDelta[N];
+            for (size_t i = 0; i < N; i++)
+                arrDelta[i] = other.m_arrCentroid[i] - m_arrCentroid[i];
+
+            for (size_t i = 0; i < N; i++)
+            {
+                m_arrCentroid[i] += arrDelta[i] * static_cast<double>(other.m_nCount) / flCount;
+
+                for (size_t j = 0; j < N; j++)
+                    m_arrDeviations[i][j] += other.m_arrDeviations[i][j] + arrDelta[i] * arrDelta[j] * flWeight;
+            }
+
+            m_nCount += other.m_nCount;
+        }
+    };
+
+    /**
+     * @brief Box aligned to the principal axes of N-dimensional points.
+     * */
+    template <size_t N>
+    struct SOrientedBox
+    {
+        double m_arrCenter[N] = {};
+
+        /**
+         * @brief Unit axes, one per row, by decreasing variance. In 3D they form a right-handed basis.
+         * */
+        double m_arrAxes[N][N] = {};
+
+        double m_arrHalfExtents[N] = {};
+    };
+
+    namespace VectorReduction
+    {
+        template <typename TVector>
+        struct STraits;
+
+        template <typename T>
+        struct STraits<CVector2D<T>>
+        {
+            static constexpr size_t DIMENSIONS = 2;
+
+            static void Load(const CVector2D<T> &v, double (&arr)[2])
+            {
+                arr[0] = static_cast<double>(v.GetX());
+                arr[1] = static_cast<double>(v.GetY());
+            }
+        };
+
+        template <typename T>
+        struct STraits<CVector3D<T>>
+        {
+            static constexpr size_t DIMENSIONS = 3;
+
+            static void Load(const CVector3D<T> &v, double (&arr)[3])
+            {
+                arr[0] = static_cast<double>(v.GetX());
+                arr[1] = static_cast<double>(v.GetY());
+                arr[2] = static_cast<double>(v.GetZ());
+            }
+        };
+    } // namespace VectorReduction
+
+    /**
+     * @class CVectorReduction
+     * @brief Bounds, centroid, covariance and oriented bounds of large CVector2D and CVector3D sets.
+     *
+     * Input is cut into chunks of CHUNK_SIZE points, independent of the thread count, which are reduced
+     * in parallel with SSE2 and then merged in chunk order. The results are therefore the same bit for
+     * bit on every machine. Sums are kept in double and shifted to the first point of every chunk, so
+     * the covariance stays accurate for sets far from the origin.
+     */
+    class CVectorReduction
+    {
+    public:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    private:
+        /**
+         * @brief Reduce every chunk into its own partial result, in parallel.
+         * */
+        template <typename TPartial, typename TFunction>
+        static std::vector<TPartial> ReduceChunks(size_t nCount, TFunction fnChunk)
+        {
+            std::vector<TPartial> vecPartials((nCount + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+            CParallel::For(vecPartials.size(), 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                                   fnChunk(nChunk * CHUNK_SIZE, std::min(nCount, (nChunk + 1) * CHUNK_SIZE), vecPartials[nChunk]);
+                           });
+
+            return vecPartials;
+        }
+
+        template <typename TVector, size_t N>
+        static void BoundsKernel(const TVector *pPoints, size_t nCount, SBoundingBox<N> &box)
+        {
+            for (size_t i = 0; i < nCount; i++)
+            {
+                double arrPoint[N];
+                VectorReduction::STraits<TVector>::Load(pPoints[i], arrPoint);
+
+                for (size_t j = 0; j < N; j++)
+                {
+                    box.m_arrMin[j] = std::min(box.m_arrMin[j], arrPoint[j]);
+                    box.m_arrMax[j] = std::max(box.m_arrMax[j], arrPoint[j]);
+                }
+            }
+        }
+
+#ifdef CALI_SIMD_SSE2
+        static void BoundsKernel(const CVector3D<float> *pPoints, size_t nCount, SBoundingBox<3> &box)
+        {
+            __m128 vecMin = _mm_set1_ps(std::numeric_limits<float>::infinity());
+            __m128 vecMax = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const __m128 vecPoint = _mm_setr_ps(pPoints[i].GetX(), pPoints[i].GetY(), pPoints[i].GetZ(), pPoints[i].GetZ());
+                vecMin = _mm_min_ps(vecMin, vecPoint);
+                vecMax = _mm_max_ps(vecMax, vecPoint);
+            }
+
+            float arrMin[4], arrMax[4];
+            _mm_storeu_ps(arrMin, vecMin);
+            _mm_storeu_ps(arrMax, vecMax);
+
+            for (size_t j = 0; j < 3; j++)
+            {
+                box.m_arrMin[j] = std::min(box.m_arrMin[j], static_cast<double>(arrMin[j]));
+                box.m_arrMax[j] = std::max(box.m_arrMax[j], static_cast<double>(arrMax[j]));
+            }
+        }
+
+        static void BoundsKernel(const CVector2D<float> *pPoints, size_t nCount, SBoundingBox<2> &box)
+        {
+            // Two points per register.
+            __m128 vecMin = _mm_set1_ps(std::numeric_limits<float>::infinity());
+            __m128 vecMax = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+            size_t i = 0;
+            for (; i + 2 <= nCount; i += 2)
+            {
+                const __m128 vecPoints = _mm_setr_ps(pPoints[i].GetX(), pPoints[i].GetY(), pPoints[i + 1].GetX(), pPoints[i + 1].GetY());
+                vecMin = _mm_min_ps(vecMin, vecPoints);
+                vecMax = _mm_max_ps(vecMax, vecPoints);
+            }
+
+            if (i < nCount)
+            {
+                const __m128 vecPoints = _mm_setr_ps(pPoints[i].GetX(), pPoints[i].GetY(), pPoints[i].GetX(), pPoints[i].GetY());
+                vecMin = _mm_min_ps(vecMin, vecPoints);
+                vecMax = _mm_max_ps(vecMax, vecPoints);
+            }
+
+            float arrMin[4], arrMax[4];
+            _mm_storeu_ps(arrMin, vecMin);
+            _mm_storeu_ps(arrMax, vecMax);
+
+            for (size_t j = 0; j < 2; j++)
+            {
+                box.m_arrMin[j] = std::min(box.m_arrMin[j], static_cast<double>(std::min(arrMin[j], arrMin[j + 2])));
+                box.m_arrMax[j] = std::max(box.m_arrMax[j], static_cast<double>(std::max(arrMax[j], arrMax[j + 2])));
+            }
+        }
+
+        static void BoundsKernel(const CVector3D<double> *pPoints, size_t nCount, SBoundingBox<3> &box)
+        {
+            __m128d vecMinXY = _mm_setr_pd(box.m_arrMin[0], box.m_arrMin[1]);
+            __m128d vecMaxXY = _mm_setr_pd(box.m_arrMax[0], box.m_arrMax[1]);
+            __m128d vecMinZ = _mm_set_sd(box.m_arrMin[2]);
+            __m128d vecMaxZ = _mm_set_sd(box.m_arrMax[2]);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const __m128d vecXY = _mm_setr_pd(pPoints[i].GetX(), pPoints[i].GetY());
+                const __m128d vecZ = _mm_set_sd(pPoints[i].GetZ());
+                vecMinXY = _mm_min_pd(vecMinXY, vecXY);
+                vecMaxXY = _mm_max_pd(vecMaxXY, vecXY);
+                vecMinZ = _mm_min_sd(vecMinZ, vecZ);
+                vecMaxZ = _mm_max_sd(vecMaxZ, vecZ);
+            }
+
+            _mm_storeu_pd(box.m_arrMin, vecMinXY);
+            _mm_storeu_pd(box.m_arrMax, vecMaxXY);
+            box.m_arrMin[2] = _mm_cvtsd_f64(vecMinZ);
+            box.m_arrMax[2] = _mm_cvtsd_f64(vecMaxZ);
+        }
+#endif
+
+        /**
+         * @brief Moments of one chunk from sums of deviations from its first point.
+         * */
+        template <typename TVector, size_t N>
+        static void MomentsKernel(const TVector *pPoints, size_t nCount, SMoments<N> &moments)
+        {
+            typedef VectorReduction::STraits<TVector> Traits_t;
+
+            double arrShift[N];
+            Traits_t::Load(pPoints[0], arrShift);
+
+            double arrSum[N] = {};
+            double arrProducts[N][N] = {};
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            // x and y share a register; xy, xz and yz come from the swapped and broadcast lanes.
+            const __m128d vecShiftXY = _mm_setr_pd(arrShift[0], arrShift[1]);
+            const __m128d vecShiftZ = _mm_set1_pd(arrShift[N - 1]);
+            __m128d vecSumXY = _mm_setzero_pd(), vecSumZ = _mm_setzero_pd();
+            __m128d vecXXYY = _mm_setzero_pd(), vecXY = _mm_setzero_pd(), vecXZYZ = _mm_setzero_pd(), vecZZ = _mm_setzero_pd();
+
+            for (; i < nCount; i++)
+            {
+                double arrPoint[N];
+                Traits_t::Load(pPoints[i], arrPoint);
+
+                const __m128d vecDeltaXY = _mm_sub_pd(_mm_setr_pd(arrPoint[0], arrPoint[1]), vecShiftXY);
+                vecSumXY = _mm_add_pd(vecSumXY, vecDeltaXY);
+                vecXXYY = _mm_add_pd(vecXXYY, _mm_mul_pd(vecDeltaXY, vecDeltaXY));
+                vecXY = _mm_add_pd(vecXY, _mm_mul_pd(vecDeltaXY, _mm_shuffle_pd(vecDeltaXY, vecDeltaXY, 1)));
+
+                if constexpr (N == 3)
+                {
+                    const __m128d vecDeltaZ = _mm_sub_pd(_mm_set1_pd(arrPoint[2]), vecShiftZ);
+                    vecSumZ = _mm_add_pd(vecSumZ, vecDeltaZ);
+                    vecXZYZ = _mm_add_pd(vecXZYZ, _mm_mul_pd(vecDeltaXY, vecDeltaZ));
+                    vecZZ = _mm_add_pd(vecZZ, _mm_mul_pd(vecDeltaZ, vecDeltaZ));
+                }
+            }
+
+            double arrLanes[2];
+            _mm_storeu_pd(arrSum, vecSumXY);
+            _mm_storeu_pd(arrLanes, vecXXYY);
+            arrProducts[0][0] = arrLanes[0];
+            arrProducts[1][1] = arrLanes[1];
+            arrProducts[0][1] = arrProducts[1][0] = _mm_cvtsd_f64(vecXY);
+
+            if constexpr (N == 3)
+            {
+                arrSum[2] = _mm_cvtsd_f64(vecSumZ);
+                _mm_storeu_pd(arrLanes, vecXZYZ);
+                arrProducts[0][2] = arrProducts[2][0] = arrLanes[0];
+                arrProducts[1][2] = arrProducts[2][1] = arrLanes[1];
+                arrProducts[2][2] = _mm_cvtsd_f64(vecZZ);
+            }
+#endif
+
+            for (; i < nCount; i++)
+            {
+                double arrPoint[N];
+                Traits_t::Load(pPoints[i], arrPoint);
+
+                for (size_t j = 0; j < N; j++)
+                {
+                    const double flDelta = arrPoint[j] - arrShift[j];
+                    arrSum[j] += flDelta;
+
+                    for (size_t k = 0; k <= j; k++)
+                        arrProducts[j][k] += flDelta * (arrPoint[k] - arrShift[k]);
+                }
+            }
+
+            const double flCount = static_cast<double>(nCount);
+            moments.m_nCount = nCount;
+
+            for (size_t j = 0; j < N; j++)
+            {
+                moments.m_arrCentroid[j] = arrShift[j] + arrSum[j] / flCount;
+
+                for (size_t k = 0; k <= j; k++)
+                    moments.m_arrDeviations[j][k] = moments.m_arrDeviations[k][j] = arrProducts[j][k] - arrSum[j] * arrSum[k] / flCount;
+            }
+        }
+
+        /**
+         * @brief Bounds of points projected onto the axes, relative to the centroid.
+         * */
+        template <typename TVector, size_t N>
+        static void ProjectionKernel(const TVector *pPoints, size_t nCount, const double (&arrCentroid)[N], const double (&arrAxes)[N][N], SBoundingBox<N> &box)
+        {
+            for (size_t i = 0; i < nCount; i++)
+            {
+                double arrPoint[N];
+                VectorReduction::STraits<TVector>::Load(pPoints[i], arrPoint);
+
+                for (size_t j = 0; j < N; j++)
+                    arrPoint[j] -= arrCentroid[j];
+
+                for (size_t nAxis = 0; nAxis < N; nAxis++)
+                {
+                    double flProjection = 0.0;
+                    for (size_t j = 0; j < N; j++)
+                        flProjection += arrPoint[j] * arrAxes[nAxis][j];
+
+                    box.m_arrMin[nAxis] = std::min(box.m_arrMin[nAxis], flProjection);
+                    box.m_arrMax[nAxis] = std::max(box.m_arrMax[nAxis], flProjection);
+                }
+            }
+        }
+
+        /**
+         * @brief Eigenvectors of a symmetric matrix by cyclic Jacobi rotations, as rows by decreasing eigenvalue.
+         * */
+        template <size_t N>
+        static void ComputeEigenvectors(const double (&arrMatrix)[N][N], double (&arrVectors)[N][N])
+        {
+            double arrA[N][N], arrV[N][N];
+            for (size_t i = 0; i < N; i++)
+            {
+                for (size_t j = 0; j < N; j++)
+                {
+                    arrA[i][j] = arrMatrix[i][j];
+                    arrV[i][j] = i == j ? 1.0 : 0.0;
+                }
+            }
+
+            for (int nSweep = 0; nSweep < 32; nSweep++)
+            {
+                double flDiagonal = 0.0, flOffDiagonal = 0.0;
+                for (size_t p = 0; p < N; p++)
+                {
+                    flDiagonal += arrA[p][p] * arrA[p][p];
+                    for (size_t q = p + 1; q < N; q++)
+                        flOffDiagonal += arrA[p][q] * arrA[p][q];
+                }
+
+                if (flOffDiagonal <= 1e-30 * flDiagonal)
+                    break;
+
+                for (size_t p = 0; p < N; p++)
+                {
+                    for (size_t q = p + 1; q < N; q++)
+                    {
+                        if (arrA[p][q] == 0.0)
+                            continue;
+
+                        // Rotate so that arrA[p][q] becomes zero.
+                        const double flTheta = (arrA[q][q] - arrA[p][p]) / (2.0 * arrA[p][q]);
+                        const double flT = (flTheta >= 0.0 ? 1.0 : -1.0) / (std::fabs(flTheta) + std::sqrt(flTheta * flTheta + 1.0));
+                        const double flC = 1.0 / std::sqrt(flT * flT + 1.0);
+                        const double flS = flT * flC;
+
+                        for (size_t k = 0; k < N; k++)
+                        {
+                            const double flKP = arrA[k][p], flKQ = arrA[k][q];
+                            arrA[k][p] = flC * flKP - flS * flKQ;
+                            arrA[k][q] = flS * flKP + flC * flKQ;
+                        }
+
+                        for (size_t k = 0; k < N; k++)
+                        {
+                            const double flPK = arrA[p][k], flQK = arrA[q][k];
+                            arrA[p][k] = flC * flPK - flS * flQK;
+                            arrA[q][k] = flS * flPK + flC * flQK;
+                        }
+
+                        for (size_t k = 0; k < N; k++)
+                        {
+                            const double flKP = arrV[k][p], flKQ = arrV[k][q];
+                            arrV[k][p] = flC * flKP - flS * flKQ;
+                            arrV[k][q] = flS * flKP + flC * flKQ;
+                        }
+                    }
+                }
+            }
+
+            size_t arrOrder[N];
+            for (size_t i = 0; i < N; i++)
+                arrOrder[i] = i;
+
+            std::sort(arrOrder, arrOrder + N, [&](size_t a, size_t b)
+                      { return arrA[a][a] > arrA[b][b]; });
+
+            for (size_t i = 0; i < N; i++)
+            {
+                for (size_t j = 0; j < N; j++)
+                    arrVectors[i][j] = arrV[j][arrOrder[i]];
+            }
+        }
+
+    public:
+        /**
+         * @brief Compute the axis-aligned bounds of a set of points.
+         * @param pPoints The points, CVector2D or CVector3D.
+         * @param nCount The number of points.
+         * @return The bounds, empty if nCount is 0.
+         * */
+        template <typename TVector>
+        static SBoundingBox<VectorReduction::STraits<TVector>::DIMENSIONS> ComputeBounds(const TVector *pPoints, size_t nCount)
+        {
+            CALI_PROFILE_SCOPE("CVectorReduction::ComputeBounds");
+
+            typedef SBoundingBox<VectorReduction::STraits<TVector>::DIMENSIONS> Box_t;
+
+            const std::vector<Box_t> vecPartials = ReduceChunks<Box_t>(nCount, [&](size_t nBegin, size_t nEnd, Box_t &box)
+                                                                       { BoundsKernel(pPoints + nBegin, nEnd - nBegin, box); });
+
+            Box_t box;
+            for (const Box_t &partial : vecPartials)
+                box.Merge(partial);
+
+            return box;
+        }
+
+        /**
+         * @brief Compute the centroid and covariance of a set of points.
+         * @param pPoints The points, CVector2D or CVector3D.
+         * @param nCount The number of points.
+         * @return The moments, with m_nCount 0 if nCount is 0.
+         * */
+        template <typename TVector>
+        static SMoments<VectorReduction::STraits<TVector>::DIMENSIONS> ComputeMoments(const TVector *pPoints, size_t nCount)
+        {
+            CALI_PROFILE_SCOPE("CVectorReduction::ComputeMoments");
+
+            typedef SMoments<VectorReduction::STraits<TVector>::DIMENSIONS> Moments_t;
+
+            const std::vector<Moments_t> vecPartials = ReduceChunks<Moments_t>(nCount, [&](size_t nBegin, size_t nEnd, Moments_t &moments)
+                                                                               { MomentsKernel(pPoints + nBegin, nEnd - nBegin, moments); });
+
+            Moments_t moments;
+            for (const Moments_t &partial : vecPartials)
+                moments.Merge(partial);
+
+            return moments;
+        }
+
+        /**
+         * @brief Compute a box aligned to the principal axes of a set of points.
+         *
+         * The axes are the eigenvectors of the covariance. This is not the smallest oriented box, but
+         * close to it for elongated sets, and it costs two passes over the points.
+         *
+         * @param pPoints The points, CVector2D or CVector3D.
+         * @param nCount The number of points.
+         * @return The box, with zero extents if nCount is 0.
+         * */
+        template <typename TVector>
+        static SOrientedBox<VectorReduction::STraits<TVector>::DIMENSIONS> ComputeOrientedBox(const TVector *pPoints, size_t nCount)
+        {
+            CALI_PROFILE_SCOPE("CVectorReduction::ComputeOrientedBox");
+
+            constexpr size_t N = VectorReduction::STraits<TVector>::DIMENSIONS;
+
+            SOrientedBox<N> box;
+            const SMoments<N> moments = ComputeMoments(pPoints, nCount);
+            if (!moments.m_nCount)
+                return box;
+
+            ComputeEigenvectors(moments.m_arrDeviations, box.m_arrAxes);
+
+            if constexpr (N == 3)
+            {
+                // Make the basis right-handed.
+                double(&arrAxes)[3][3] = box.m_arrAxes;
+                arrAxes[2][0] = arrAxes[0][1] * arrAxes[1][2] - arrAxes[0][2] * arrAxes[1][1];
+                arrAxes[2][1] = arrAxes[0][2] * arrAxes[1][0] - arrAxes[0][0] * arrAxes[1][2];
+                arrAxes[2][2] = arrAxes[0][0] * arrAxes[1][1] - arrAxes[0][1] * arrAxes[1][0];
+            }
+
+            const std::vector<SBoundingBox<N>> vecPartials = ReduceChunks<SBoundingBox<N>>(nCount, [&](size_t nBegin, size_t nEnd, SBoundingBox<N> &partial)
+                                                                                           { ProjectionKernel(pPoints + nBegin, nEnd - nBegin, moments.m_arrCentroid, box.m_arrAxes, partial); });
+
+            SBoundingBox<N> projected;
+            for (const SBoundingBox<N> &partial : vecPartials)
+                projected.Merge(partial);
+
+            for (size_t j = 0; j < N; j++)
+                box.m_arrCenter[j] = moments.m_arrCentroid[j];
+
+            for (size_t nAxis = 0; nAxis < N; nAxis++)
+            {
+                const double flMid = (projected.m_arrMin[nAxis] + projected.m_arrMax[nAxis]) * 0.5;
+                box.m_arrHalfExtents[nAxis] = (projected.m_arrMax[nAxis] - projected.m_arrMin[nAxis]) * 0.5;
+
+                for (size_t j = 0; j < N; j++)
+                    box.m_arrCenter[j] += box.m_arrAxes[nAxis][j] * flMid;
+            }
+
+            return box;
+        }
+    };
+
+} // namespace Cali
@@ -0,0 +1,290 @@
+#pragma once
+
+/**
+ * @file CVertexWelder.h
+ * @brief Contains the declaration of the CVertexWelder class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "CParallel.h"
+#include "CProfiler.h"
+#include "CVector3D.h"
+
+namespace Cali
+{
+    /**
+     * @brief Unique vertices and one index per input vertex, the output of CVertexWelder.
+     * */
+    template <typename T = double>
+    struct SIndexedMesh
+    {
+        std::vector<CVector3D<T>> m_vecVertices = {};
+        std::vector<uint32_t> m_vecIndices = {};
+
+        void Clear()
+        {
+            m_vecVertices.clear();
+            m_vecIndices.clear();
+        }
+    };
+
+    /**
+     * @class CVertexWelder
+     * @brief Turns triangle soup into an indexed mesh by merging vertices closer than an epsilon.
+     *
+     * Vertices are hashed by their cell in a grid of 2 * epsilon, into an open-addressing table with
+     * linear probing. A vertex is looked up in its own cell, then in the 7 others it can reach within
+     * epsilon, and welded to the lowest-index match of the first cell that has one. Otherwise it becomes
+     * a new unique vertex. An epsilon of 0 welds exact copies.
+     *
+     * Input of more than CHUNK_SIZE vertices is welded per chunk in parallel, then the unique vertices of
+     * the chunks are welded again in chunk order. A vertex keeps the result of its chunk only while it is
+     * within epsilon of the unique vertex that leads to, and is welded on its own otherwise, so every
+     * vertex ends up within epsilon of its unique vertex wherever the chunk boundaries fall. The result
+     * is the same on any thread count, though a vertex within epsilon of two others may pick a different
+     * one than a single pass would.
+     */
+    template <typename T = double>
+    class CVertexWelder
+    {
+    public:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    private:
+        static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+        /**
+         * @class CWeldTable
+         * @brief Open-addressing multimap from cell hash to vertex index, sized up front and doubled if
+         * more entries than expected arrive.
+         */
+        class CWeldTable
+        {
+        private:
+            std::vector<uint64_t> m_vecHashes = {};
+            std::vector<uint32_t> m_vecIndices = {};
+            size_t m_nMask = 0;
+            size_t m_nSize = 0;
+
+            void Grow()
+            {
+                std::vector<uint64_t> vecHashes;
+                std::vector<uint32_t> vecIndices;
+                vecHashes.swap(m_vecHashes);
+                vecIndices.swap(m_vecIndices);
+
+                Reset(m_nSize * 2);
+                for (size_t nSlot = 0; nSlot < vecIndices.size(); nSlot++)
+                {
+                    if (vecIndices[nSlot] != EMPTY)
+                        Insert(vecHashes[nSlot], vecIndices[nSlot]);
+                }
+            }
+
+        public:
+            /**
+             * @brief Empty the table and size it for nCount entries at a load factor of at most one half.
+             * */
+            void Reset(size_t nCount)
+            {
+                size_t nCapacity = 16;
+                while (nCapacity < nCount * 2)
+                    nCapacity *= 2;
+
+                m_vecHashes.assign(nCapacity, 0);
+                m_vecIndices.assign(nCapacity, EMPTY);
+                m_nMask = nCapacity - 1;
+                m_nSize = 0;
+            }
+
+            /**
+             * @brief Lower nBest to the smallest index stored under nHash that fnMatches accepts.
+             * */
+            template <typename TFunction>
+            void Find(uint64_t nHash, TFunction &&fnMatches, uint32_t &nBest) const
+            {
+                for (size_t nSlot = nHash & m_nMask; m_vecIndices[nSlot] != EMPTY; nSlot = (nSlot + 1) & m_nMask)
+                {
+                    const uint32_t nIndex = m_vecIndices[nSlot];
+                    if (m_vecHashes[nSlot] == nHash && nIndex < nBest && fnMatches(nIndex))
+                        nBest = nIndex;
+                }
+            }
+
+            void Insert(uint64_t nHash, uint32_t nIndex)
+            {
+                if ((m_nSize + 1) * 2 > m_vecIndices.size())
+                    Grow();
+
+                m_nSize++;
+
+                size_t nSlot = nHash & m_nMask;
+                while (m_vecIndices[nSlot] != EMPTY)
+                    nSlot = (nSlot + 1) & m_nMask;
+
+                m_vecHashes[nSlot] = nHash;
+                m_vecIndices[nSlot] = nIndex;
+            }
+        };
+
+        T m_flEpsilon = T(0);
+
+        std::vector<uint32_t> m_vecRepresentative = {};
+        CWeldTable m_GlobalTable;
+
+        static uint64_t HashCell(int64_t nX, int64_t nY, int64_t nZ)
+        {
+            uint64_t nHash = static_cast<uint64_t>(nX) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(nY) * 0xC2B2AE3D27D4EB4Full ^
+                             static_cast<uint64_t>(nZ) * 0x165667B19E3779F9ull;
+            nHash ^= nHash >> 33;
+            nHash *= 0xFF51AFD7ED558CCDull;
+            nHash ^= nHash >> 33;
+            return nHash;
+        }
+
+        /**
+         * @brief Hash the cells a vertex can reach within epsilon, its own cell first.
+         * @return The number of cells, 8, or 1 when welding exact copies.
+         * */
+        size_t GetCells(const CVector3D<T> &vec, uint64_t (&arrHashes)[8]) const
+        {
+            if (!(m_flEpsilon > T(0)))
+            {
+                arrHashes[0] = static_cast<uint64_t>(std::hash<CVector3D<T>>()(vec));
+                return 1;
+            }
+
+            const double flInvCell = 0.5 / static_cast<double>(m_flEpsilon);
+            const double arrScaled[3] = {static_cast<double>(vec.GetX()) * flInvCell, static_cast<double>(vec.GetY()) * flInvCell,
+                                         static_cast<double>(vec.GetZ()) * flInvCell};
+
+            // Per axis the vertex can only reach the neighbour cell on the side of the half it lies in.
+            int64_t arrCells[3][2];
+            for (size_t j = 0; j < 3; j++)
+            {
+                const double flCell = std::floor(arrScaled[j]);
+                arrCells[j][0] = static_cast<int64_t>(flCell);
+                arrCells[j][1] = arrCells[j][0] + (arrScaled[j] - flCell < 0.5 ? -1 : 1);
+            }
+
+            for (size_t nCorner = 0; nCorner < 8; nCorner++)
+                arrHashes[nCorner] = HashCell(arrCells[0][nCorner & 1], arrCells[1][(nCorner >> 1) & 1], arrCells[2][(nCorner >> 2) & 1]);
+
+            return 8;
+        }
+
+        bool IsMatch(const CVector3D<T> &a, const CVector3D<T> &b) const
+        {
+            if (!(m_flEpsilon > T(0)))
+                return a == b;
+
+            const double flDeltaX = static_cast<double>(a.GetX()) - static_cast<double>(b.GetX());
+            const double flDeltaY = static_cast<double>(a.GetY()) - static_cast<double>(b.GetY());
+            const double flDeltaZ = static_cast<double>(a.GetZ()) - static_cast<double>(b.GetZ());
+            const double flEpsilon = static_cast<double>(m_flEpsilon);
+            return flDeltaX * flDeltaX + flDeltaY * flDeltaY + flDeltaZ * flDeltaZ <= flEpsilon * flEpsilon;
+        }
+
+        /**
+         * @brief Find the unique vertex vec welds to, or insert it as nNewIndex.
+         * @param pUnique The positions of the indices stored in the table, including nNewIndex.
+         * */
+        uint32_t FindOrInsert(CWeldTable &table, const CVector3D<T> *pUnique, const CVector3D<T> &vec, uint32_t nNewIndex) const
+        {
+            uint64_t arrHashes[8];
+            const size_t nCells = GetCells(vec, arrHashes);
+
+            // Most duplicates share the home cell, so the neighbours are only searched when it has no match.
+            uint32_t nBest = EMPTY;
+            for (size_t nCell = 0; nCell < nCells && nBest == EMPTY; nCell++)
+            {
+                table.Find(arrHashes[nCell], [&](uint32_t nIndex)
+                           { return IsMatch(pUnique[nIndex], vec); },
+                           nBest);
+            }
+
+            if (nBest != EMPTY)
+                return nBest;
+
+            table.Insert(arrHashes[0], nNewIndex);
+            return nNewIndex;
+        }
+
+    public:
+        /**
+         * @param flEpsilon The largest distance between vertices that are merged, 0 for exact copies only.
+         * */
+        explicit CVertexWelder(T flEpsilon = T(0)) : m_flEpsilon(flEpsilon) {}
+
+        void SetEpsilon(T flEpsilon) { m_flEpsilon = flEpsilon; }
+        T GetEpsilon() const { return m_flEpsilon; }
+
+        /**
+         * @brief Weld a triangle soup, or any vertex list, into an indexed mesh.
+         * @param pVertices The vertices.
+         * @param nCount The number of vertices, below 2^32 - 1.
+         * @param mesh Receives the unique vertices, in order of first use, and one index per input vertex.
+         * */
+        void Weld(const CVector3D<T> *pVertices, size_t nCount, SIndexedMesh<T> &mesh)
+        {
+            CALI_PROFILE_SCOPE("CVertexWelder::Weld");
+
+            mesh.Clear();
+            m_vecRepresentative.resize(nCount);
+
+            // Weld every chunk on its own; m_vecRepresentative[i] is the input index vertex i welds to.
+            const size_t nChunks = (nCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            CParallel::For(nChunks, 1, [&](size_t nBegin, size_t nEnd)
+                           {
+                               CWeldTable table;
+
+                               for (size_t nChunk = nBegin; nChunk < nEnd; nChunk++)
+                               {
+                                   const size_t nFirst = nChunk * CHUNK_SIZE;
+                                   const size_t nLast = std::min(nCount, nFirst + CHUNK_SIZE);
+                                   table.Reset(nLast - nFirst);
+
+                                   for (size_t i = nFirst; i < nLast; i++)
+                                       m_vecRepresentative[i] = FindOrInsert(table, pVertices, pVertices[i], static_cast<uint32_t>(i));
+                               } });
+
+            // Weld across chunks, in order. Welding is not transitive, so a vertex only follows its chunk
+            // representative while the unique vertex that one welded to is still within epsilon of it.
+            size_t nLocalUnique = 0;
+            for (size_t i = 0; i < nCount; i++)
+                nLocalUnique += m_vecRepresentative[i] == i;
+
+            m_GlobalTable.Reset(nLocalUnique);
+            mesh.m_vecVertices.reserve(nLocalUnique);
+            mesh.m_vecIndices.resize(nCount);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const uint32_t nRepresentative = m_vecRepresentative[i];
+                if (nRepresentative != i)
+                {
+                    const uint32_t nIndex = mesh.m_vecIndices[nRepresentative];
+                    if (IsMatch(mesh.m_vecVertices[nIndex], pVertices[i]))
+                    {
+                        mesh.m_vecIndices[i] = nIndex;
+                        continue;
+                    }
+                }
+
+                const uint32_t nNewIndex = static_cast<uint32_t>(mesh.m_vecVertices.size());
+                mesh.m_vecVertices.push_back(pVertices[i]);
+
+                mesh.m_vecIndices[i] = FindOrInsert(m_GlobalTable, mesh.m_vecVertices.data(), pVertices[i], nNewIndex);
+                if (mesh.m_vecIndices[i] != nNewIndex)
+                    mesh.m_vecVertices.pop_back();
+            }
+        }
+    };
+
+} // namespace Cali
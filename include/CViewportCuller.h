@@ -0,0 +1,377 @@
+#pragma once
+
+/**
+ * @file CViewportCuller.h
+ * @brief Contains the declaration of the CViewportCuller class.
+ */
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "CDrawCommand.h"
+#include "CProfiler.h"
+#include "CVector2D.h"
+#include "Simd.h"
+
+namespace Cali
+{
+    /**
+     * @brief Counters of the last CViewportCuller::Cull() call.
+     * */
+    struct SCullStats
+    {
+        /**
+         * @brief Commands passed in.
+         * */
+        size_t m_nSubmitted = 0;
+
+        /**
+         * @brief Commands rejected because they lie completely outside the viewport.
+         * */
+        size_t m_nCulled = 0;
+
+        /**
+         * @brief Commands that straddle the viewport edge and were clipped.
+         * */
+        size_t m_nClipped = 0;
+
+        /**
+         * @brief Commands handed on, including the extra triangles produced by clipping.
+         * */
+        size_t m_nEmitted = 0;
+    };
+
+    /**
+     * @class CViewportCuller
+     * @brief Rejects and clips recorded draw commands against the viewport rectangle.
+     *
+     * Bounding boxes of all commands are computed into SoA arrays first and tested four at a time.
+     * Commands that straddle the edge are clipped: lines with Liang-Barsky, rects by intersection and
+     * triangles with Sutherland-Hodgman followed by a fan triangulation. Circles and indexed triangle
+     * batches are only culled, by their bounding box.
+     */
+    class CViewportCuller
+    {
+    private:
+        float m_flMinX = 0.0f;
+        float m_flMinY = 0.0f;
+        float m_flMaxX = 0.0f;
+        float m_flMaxY = 0.0f;
+
+        SCullStats m_Stats = {};
+
+        std::vector<float> m_vecBoundsMinX = {};
+        std::vector<float> m_vecBoundsMinY = {};
+        std::vector<float> m_vecBoundsMaxX = {};
+        std::vector<float> m_vecBoundsMaxY = {};
+        std::vector<unsigned char> m_vecVisibility = {};
+        std::vector<SDrawCommand> m_vecOutput = {};
+
+        /**
+         * @brief Visibility of a command's bounding box.
+         * */
+        enum Visibility_e : unsigned char
+        {
+            VISIBILITY_OUTSIDE = 0,
+            VISIBILITY_INSIDE,
+            VISIBILITY_STRADDLING
+        };
+
+        static float Min3(float a, float b, float c) { return a < b ? (a < c ? a : c) : (b < c ? b : c); }
+        static float Max3(float a, float b, float c) { return a > b ? (a > c ? a : c) : (b > c ? b : c); }
+
+        void ComputeBounds(const std::vector<SDrawCommand> &vecCommands)
+        {
+            const size_t nCount = vecCommands.size();
+            m_vecBoundsMinX.resize(nCount);
+            m_vecBoundsMinY.resize(nCount);
+            m_vecBoundsMaxX.resize(nCount);
+            m_vecBoundsMaxY.resize(nCount);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const SDrawCommand &command = vecCommands[i];
+                const CVector2D<float> *pPoints = command.m_Points;
+
+                switch (command.m_nType)
+                {
+                case DRAW_COMMAND_LINE:
+                case DRAW_COMMAND_RECT:
+                case DRAW_COMMAND_INDEXED_TRIANGLES:
+                    m_vecBoundsMinX[i] = pPoints[0].GetX() < pPoints[1].GetX() ? pPoints[0].GetX() : pPoints[1].GetX();
+                    m_vecBoundsMinY[i] = pPoints[0].GetY() < pPoints[1].GetY() ? pPoints[0].GetY() : pPoints[1].GetY();
+                    m_vecBoundsMaxX[i] = pPoints[0].GetX() > pPoints[1].GetX() ? pPoints[0].GetX() : pPoints[1].GetX();
+                    m_vecBoundsMaxY[i] = pPoints[0].GetY() > pPoints[1].GetY() ? pPoints[0].GetY() : pPoints[1].GetY();
+                    break;
+                case DRAW_COMMAND_CIRCLE:
+                    m_vecBoundsMinX[i] = pPoints[0].GetX() - command.m_flRadius;
+                    m_vecBoundsMinY[i] = pPoints[0].GetY() - command.m_flRadius;
+                    m_vecBoundsMaxX[i] = pPoints[0].GetX() + command.m_flRadius;
+                    m_vecBoundsMaxY[i] = pPoints[0].GetY() + command.m_flRadius;
+                    break;
+                case DRAW_COMMAND_TRIANGLE:
+                    m_vecBoundsMinX[i] = Min3(pPoints[0].GetX(), pPoints[1].GetX(), pPoints[2].GetX());
+                    m_vecBoundsMinY[i] = Min3(pPoints[0].GetY(), pPoints[1].GetY(), pPoints[2].GetY());
+                    m_vecBoundsMaxX[i] = Max3(pPoints[0].GetX(), pPoints[1].GetX(), pPoints[2].GetX());
+                    m_vecBoundsMaxY[i] = Max3(pPoints[0].GetY(), pPoints[1].GetY(), pPoints[2].GetY());
+                    break;
+                }
+            }
+        }
+
+        void ClassifyBounds(size_t nCount)
+        {
+            m_vecVisibility.resize(nCount);
+            size_t i = 0;
+
+#ifdef CALI_SIMD_SSE2
+            const __m128 vecViewMinX = _mm_set1_ps(m_flMinX);
+            const __m128 vecViewMinY = _mm_set1_ps(m_flMinY);
+            const __m128 vecViewMaxX = _mm_set1_ps(m_flMaxX);
+            const __m128 vecViewMaxY = _mm_set1_ps(m_flMaxY);
+
+            for (; i + 4 <= nCount; i += 4)
+            {
+                const __m128 vecMinX = _mm_loadu_ps(&m_vecBoundsMinX[i]);
+                const __m128 vecMinY = _mm_loadu_ps(&m_vecBoundsMinY[i]);
+                const __m128 vecMaxX = _mm_loadu_ps(&m_vecBoundsMaxX[i]);
+                const __m128 vecMaxY = _mm_loadu_ps(&m_vecBoundsMaxY[i]);
+
+                const __m128 vecOutside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(vecMaxX, vecViewMinX), _mm_cmpgt_ps(vecMinX, vecViewMaxX)),
+                                                    _mm_or_ps(_mm_cmplt_ps(vecMaxY, vecViewMinY), _mm_cmpgt_ps(vecMinY, vecViewMaxY)));
+                const __m128 vecInside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vecMinX, vecViewMinX), _mm_cmple_ps(vecMaxX, vecViewMaxX)),
+                                                    _mm_and_ps(_mm_cmpge_ps(vecMinY, vecViewMinY), _mm_cmple_ps(vecMaxY, vecViewMaxY)));
+
+                const int nOutside = _mm_movemask_ps(vecOutside);
+                const int nInside = _mm_movemask_ps(vecInside);
+
+                for (int nLane = 0; nLane < 4; nLane++)
+                {
+                    if (nOutside & (1 << nLane))
+                        m_vecVisibility[i + nLane] = VISIBILITY_OUTSIDE;
+                    else if (nInside & (1 << nLane))
+                        m_vecVisibility[i + nLane] = VISIBILITY_INSIDE;
+                    else
+                        m_vecVisibility[i + nLane] = VISIBILITY_STRADDLING;
+                }
+            }
+#endif
+
+            for (; i < nCount; i++)
+            {
+                if (m_vecBoundsMaxX[i] < m_flMinX || m_vecBoundsMinX[i] > m_flMaxX || m_vecBoundsMaxY[i] < m_flMinY || m_vecBoundsMinY[i] > m_flMaxY)
+                    m_vecVisibility[i] = VISIBILITY_OUTSIDE;
+                else if (m_vecBoundsMinX[i] >= m_flMinX && m_vecBoundsMaxX[i] <= m_flMaxX && m_vecBoundsMinY[i] >= m_flMinY && m_vecBoundsMaxY[i] <= m_flMaxY)
+                    m_vecVisibility[i] = VISIBILITY_INSIDE;
+                else
+                    m_vecVisibility[i] = VISIBILITY_STRADDLING;
+            }
+        }
+
+        /**
+         * @brief Clip one polygon edge set against a single viewport boundary.
+         * @param nAxis 0 for X, 1 for Y.
+         * @param flBound The boundary value.
+         * @param bKeepGreater Whether the inside lies above the boundary.
+         * */
+        static size_t ClipPolygonAgainst(const CVector2D<float> *pIn, size_t nIn, CVector2D<float> *pOut, int nAxis, float flBound, bool bKeepGreater)
+        {
+            size_t nOut = 0;
+
+            for (size_t i = 0; i < nIn; i++)
+            {
+                const CVector2D<float> &vecCurrent = pIn[i];
+                const CVector2D<float> &vecNext = pIn[(i + 1) % nIn];
+
+                const float flCurrent = nAxis == 0 ? vecCurrent.GetX() : vecCurrent.GetY();
+                const float flNext = nAxis == 0 ? vecNext.GetX() : vecNext.GetY();
+                const bool bCurrentInside = bKeepGreater ? flCurrent >= flBound : flCurrent <= flBound;
+                const bool bNextInside = bKeepGreater ? flNext >= flBound : flNext <= flBound;
+
+                if (bCurrentInside)
+                    pOut[nOut++] = vecCurrent;
+
+                if (bCurrentInside != bNextInside)
+                {
+                    const float t = (flBound - flCurrent) / (flNext - flCurrent);
+                    pOut[nOut++] = vecCurrent + (vecNext - vecCurrent) * t;
+                }
+            }
+
+            return nOut;
+        }
+
+    public:
+        /**
+         * @brief Set the viewport rectangle commands are tested against.
+         * @param vecMin The top left corner.
+         * @param vecMax The bottom right corner.
+         * */
+        void SetViewport(const CVector2D<float> &vecMin, const CVector2D<float> &vecMax)
+        {
+            m_flMinX = vecMin.GetX();
+            m_flMinY = vecMin.GetY();
+            m_flMaxX = vecMax.GetX();
+            m_flMaxY = vecMax.GetY();
+        }
+
+        CVector2D<float> GetViewportMin() const { return CVector2D<float>(m_flMinX, m_flMinY); }
+        CVector2D<float> GetViewportMax() const { return CVector2D<float>(m_flMaxX, m_flMaxY); }
+
+        /**
+         * @brief Get the counters of the last Cull() call.
+         * @return The counters.
+         * */
+        const SCullStats &GetStats() const { return m_Stats; }
+
+        /**
+         * @brief Clip a line segment against the viewport using Liang-Barsky.
+         * @param vecStart The start point, moved onto the viewport edge if needed.
+         * @param vecEnd The end point, moved onto the viewport edge if needed.
+         * @return False if no part of the line is inside the viewport.
+         * */
+        bool ClipLine(CVector2D<float> &vecStart, CVector2D<float> &vecEnd) const
+        {
+            const float flDeltaX = vecEnd.GetX() - vecStart.GetX();
+            const float flDeltaY = vecEnd.GetY() - vecStart.GetY();
+            const float p[4] = {-flDeltaX, flDeltaX, -flDeltaY, flDeltaY};
+            const float q[4] = {vecStart.GetX() - m_flMinX, m_flMaxX - vecStart.GetX(), vecStart.GetY() - m_flMinY, m_flMaxY - vecStart.GetY()};
+
+            float flEnter = 0.0f;
+            float flExit = 1.0f;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if (p[i] == 0.0f)
+                {
+                    if (q[i] < 0.0f)
+                        return false;
+
+                    continue;
+                }
+
+                const float t = q[i] / p[i];
+                if (p[i] < 0.0f)
+                    flEnter = t > flEnter ? t : flEnter;
+                else
+                    flExit = t < flExit ? t : flExit;
+            }
+
+            if (flEnter > flExit)
+                return false;
+
+            const CVector2D<float> vecOrigin = vecStart;
+            vecStart = CVector2D<float>(vecOrigin.GetX() + flDeltaX * flEnter, vecOrigin.GetY() + flDeltaY * flEnter);
+            vecEnd = CVector2D<float>(vecOrigin.GetX() + flDeltaX * flExit, vecOrigin.GetY() + flDeltaY * flExit);
+            return true;
+        }
+
+        /**
+         * @brief Clip a triangle against the viewport using Sutherland-Hodgman.
+         * @param pTriangle The three vertices.
+         * @param pPolygon Receives the clipped convex polygon, room for at least 7 vertices.
+         * @return The number of vertices of the clipped polygon, less than 3 if nothing is left.
+         * */
+        size_t ClipTriangle(const CVector2D<float> *pTriangle, CVector2D<float> *pPolygon) const
+        {
+            CVector2D<float> scratch[7];
+
+            size_t nCount = ClipPolygonAgainst(pTriangle, 3, scratch, 0, m_flMinX, true);
+            nCount = ClipPolygonAgainst(scratch, nCount, pPolygon, 0, m_flMaxX, false);
+            nCount = ClipPolygonAgainst(pPolygon, nCount, scratch, 1, m_flMinY, true);
+            nCount = ClipPolygonAgainst(scratch, nCount, pPolygon, 1, m_flMaxY, false);
+
+            return nCount;
+        }
+
+        /**
+         * @brief Remove commands outside the viewport and clip the ones crossing its edge.
+         * The order of the remaining commands is preserved.
+         * @param vecCommands The commands, replaced by the visible ones.
+         * */
+        void Cull(std::vector<SDrawCommand> &vecCommands)
+        {
+            CALI_PROFILE_SCOPE("CViewportCuller::Cull");
+
+            const size_t nCount = vecCommands.size();
+
+            m_Stats = {};
+            m_Stats.m_nSubmitted = nCount;
+
+            ComputeBounds(vecCommands);
+            ClassifyBounds(nCount);
+
+            m_vecOutput.clear();
+            m_vecOutput.reserve(nCount);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const SDrawCommand &command = vecCommands[i];
+
+                if (m_vecVisibility[i] == VISIBILITY_OUTSIDE)
+                {
+                    m_Stats.m_nCulled++;
+                    continue;
+                }
+
+                if (m_vecVisibility[i] == VISIBILITY_INSIDE || command.m_nType == DRAW_COMMAND_CIRCLE || command.m_nType == DRAW_COMMAND_INDEXED_TRIANGLES)
+                {
+                    m_vecOutput.push_back(command);
+                    continue;
+                }
+
+                switch (command.m_nType)
+                {
+                case DRAW_COMMAND_LINE:
+                {
+                    SDrawCommand clipped = command;
+                    if (!ClipLine(clipped.m_Points[0], clipped.m_Points[1]))
+                    {
+                        m_Stats.m_nCulled++;
+                        continue;
+                    }
+
+                    m_vecOutput.push_back(clipped);
+                    break;
+                }
+                case DRAW_COMMAND_RECT:
+                {
+                    SDrawCommand clipped = command;
+                    clipped.m_Points[0] = CVector2D<float>(m_vecBoundsMinX[i] < m_flMinX ? m_flMinX : m_vecBoundsMinX[i], m_vecBoundsMinY[i] < m_flMinY ? m_flMinY : m_vecBoundsMinY[i]);
+                    clipped.m_Points[1] = CVector2D<float>(m_vecBoundsMaxX[i] > m_flMaxX ? m_flMaxX : m_vecBoundsMaxX[i], m_vecBoundsMaxY[i] > m_flMaxY ? m_flMaxY : m_vecBoundsMaxY[i]);
+                    m_vecOutput.push_back(clipped);
+                    break;
+                }
+                case DRAW_COMMAND_TRIANGLE:
+                {
+                    CVector2D<float> polygon[7];
+                    const size_t nVertices = ClipTriangle(command.m_Points, polygon);
+                    if (nVertices < 3)
+                    {
+                        m_Stats.m_nCulled++;
+                        continue;
+                    }
+
+                    for (size_t j = 1; j + 1 < nVertices; j++)
+                    {
+                        SDrawCommand clipped = command;
+                        clipped.m_Points[0] = polygon[0];
+                        clipped.m_Points[1] = polygon[j];
+                        clipped.m_Points[2] = polygon[j + 1];
+                        m_vecOutput.push_back(clipped);
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+
+                m_Stats.m_nClipped++;
+            }
+
+            m_Stats.m_nEmitted = m_vecOutput.size();
+            std::swap(vecCommands, m_vecOutput);
+        }
+    };
+
+} // namespace Cali
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Cali
 {
     inline constexpr double CONST_PI = 3.14159265358979323846;
     inline constexpr float CONST_PI_F = 3.14159265358979323846f;
+    inline constexpr uint32_t CONST_COLOR_DEFAULT = 0xFFFFFFFF; // Opaque white, packed as 0xAARRGGBB
 } // namespace Cali
\ No newline at end of file
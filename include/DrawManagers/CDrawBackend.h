@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file CDrawBackend.h
+ * @brief Contains the declaration of the CDrawBackend class.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../CColor.h"
+#include "../Constants.h"
+#include "../CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @class CDrawBackend
+     * @brief CRTP base class for the backends of CDrawManager.
+     *
+     * A backend derives from CDrawBackend<TDerived> and implements Initialize, Shutdown and the single
+     * primitive Draw* calls. The bulk Draw* calls below default to looping over the single primitive
+     * calls; a backend overrides them by declaring a function with the same signature, which the
+     * manager picks at compile time.
+     *
+     * The single primitive calls take no color, so the default bulk calls ignore pColors and draw
+     * everything the way the single calls do. A backend that draws colors must override them.
+     *
+     * Colors are packed as 0xAARRGGBB, see CColorKey::GetColorARGB(). A null color array draws
+     * everything in CONST_COLOR_DEFAULT. Backends read colors with GetColor() and convert points with
+     * ToFloat(), the helpers CDrawCommandList and CDrawManager use as well.
+     *
+     * @tparam TDerived The backend type.
+     */
+    template <typename TDerived>
+    class CDrawBackend
+    {
+    protected:
+        TDerived &Derived() { return static_cast<TDerived &>(*this); }
+
+    public:
+        /**
+         * @brief Draw nCount lines from pStart[i] to pEnd[i]. Ignores the colors.
+         * */
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const uint32_t * /*pColors*/, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                Derived().DrawLine(pStart[i], pEnd[i]);
+        }
+
+        /**
+         * @brief Draw nCount rects spanning pMin[i] to pMax[i]. Ignores the colors.
+         * */
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const uint32_t * /*pColors*/, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                Derived().DrawRect(pMin[i], pMax[i]);
+        }
+
+        /**
+         * @brief Draw nCount circles around pCenters[i] with pRadii[i]. Ignores the colors.
+         * */
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const uint32_t * /*pColors*/, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                Derived().DrawCircle(pCenters[i], pRadii[i]);
+        }
+
+        /**
+         * @brief Draw nCount triangles, three consecutive vertices each. Ignores the colors.
+         * */
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const uint32_t * /*pColors*/, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                Derived().DrawTriangle(pVertices[i * 3], pVertices[i * 3 + 1], pVertices[i * 3 + 2]);
+        }
+
+        /**
+         * @brief Draw nCount triangles through three indices into pVertices each. Ignores the colors.
+         * @param pColors One color per triangle.
+         * */
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, const uint32_t * /*pColors*/, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                Derived().DrawTriangle(pVertices[pIndices[i * 3]], pVertices[pIndices[i * 3 + 1]], pVertices[pIndices[i * 3 + 2]]);
+        }
+    };
+
+} // namespace Cali
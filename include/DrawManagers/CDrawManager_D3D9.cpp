@@ -8,8 +8,11 @@ void Cali::CDrawManager_D3D9::Initialize()
 
 void Cali::CDrawManager_D3D9::Shutdown()
 {
-    m_pD3DDevice->Release();
-    m_pD3D->Release();
+    if (m_pD3DDevice)
+        m_pD3DDevice->Release();
+
+    if (m_pD3D)
+        m_pD3D->Release();
 
     m_pD3DDevice = nullptr;
     m_pD3D = nullptr;
@@ -2,18 +2,68 @@
 
 #include <d3d9.h>
 
+#include <vector>
+
+#include "CDrawBackend.h"
+#include "../CCircleCache.h"
+#include "../CProfiler.h"
 #include "../CVector2D.h"
 
 namespace Cali
 {
-    class CDrawManager_D3D9
+    class CDrawManager_D3D9 : public CDrawBackend<CDrawManager_D3D9>
     {
     private:
-        LPDIRECT3D9 m_pD3D;
-        LPDIRECT3DDEVICE9 m_pD3DDevice;
+        /**
+         * @brief Pre-transformed, colored vertex used by the bulk draw calls.
+         * */
+        struct SVertex
+        {
+            float m_flX, m_flY, m_flZ, m_flRHW;
+            D3DCOLOR m_nColor;
+        };
+
+        static constexpr DWORD VERTEX_FVF = D3DFVF_XYZRHW | D3DFVF_DIFFUSE;
+
+        /**
+         * @brief Upper bound on the primitives per DrawPrimitiveUP call, below MaxPrimitiveCount of common hardware.
+         * */
+        static constexpr size_t MAX_PRIMITIVES_PER_CALL = 65535;
+
+        LPDIRECT3D9 m_pD3D = nullptr;
+        LPDIRECT3DDEVICE9 m_pD3DDevice = nullptr;
+
+        /**
+         * @brief Dynamic vertex storage reused by every bulk draw call.
+         * */
+        std::vector<SVertex> m_vecVertices = {};
+
+        CCircleCache m_CircleCache;
+
+        template <typename T>
+        void PushVertex(const CVector2D<T> &vec, D3DCOLOR nColor)
+        {
+            m_vecVertices.push_back({static_cast<float>(vec.GetX()), static_cast<float>(vec.GetY()), 0.0f, 1.0f, nColor});
+        }
+
+        void Submit(D3DPRIMITIVETYPE nPrimitiveType, size_t nVerticesPerPrimitive)
+        {
+            CALI_PROFILE_SCOPE("CDrawManager_D3D9::Submit");
+            CALI_PROFILE_COUNT(PROFILE_COUNTER_VERTICES, m_vecVertices.size());
+            CALI_PROFILE_COUNT(PROFILE_COUNTER_BYTES_UPLOADED, m_vecVertices.size() * sizeof(SVertex));
+
+            m_pD3DDevice->SetFVF(VERTEX_FVF);
+
+            const size_t nPrimitives = m_vecVertices.size() / nVerticesPerPrimitive;
+            for (size_t nFirst = 0; nFirst < nPrimitives; nFirst += MAX_PRIMITIVES_PER_CALL)
+            {
+                const size_t nBatch = nPrimitives - nFirst < MAX_PRIMITIVES_PER_CALL ? nPrimitives - nFirst : MAX_PRIMITIVES_PER_CALL;
+                m_pD3DDevice->DrawPrimitiveUP(nPrimitiveType, static_cast<UINT>(nBatch), &m_vecVertices[nFirst * nVerticesPerPrimitive], sizeof(SVertex));
+            }
+        }
 
     public:
-        CDrawManager_D3D9() { Initialize(); }
+        CDrawManager_D3D9() = default;
         ~CDrawManager_D3D9() { Shutdown(); }
 
         void Initialize();
@@ -22,10 +72,17 @@ namespace Cali
         LPDIRECT3D9 GetD3D() { return m_pD3D; }
         LPDIRECT3DDEVICE9 GetDevice() { return m_pD3DDevice; }
 
+        /**
+         * @brief Get the cache circles are tessellated with, e.g. to change its maximum error.
+         * @return The circle cache.
+         * */
+        CCircleCache &GetCircleCache() { return m_CircleCache; }
+
         D3DVIEWPORT9 GetViewport() const
         {
             D3DVIEWPORT9 viewport;
             m_pD3DDevice->GetViewport(&viewport);
+            return viewport;
         }
 
         void SetViewport(D3DVIEWPORT9 viewport)
@@ -56,5 +113,95 @@ namespace Cali
         {
             m_pD3DDevice->DrawTriangle(v1.GetX(), v1.GetY(), v2.GetX(), v2.GetY(), v3.GetX(), v3.GetY());
         }
+
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const uint32_t *pColors, size_t nCount)
+        {
+            m_vecVertices.clear();
+            m_vecVertices.reserve(nCount * 2);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                PushVertex(pStart[i], GetColor(pColors, i));
+                PushVertex(pEnd[i], GetColor(pColors, i));
+            }
+
+            Submit(D3DPT_LINELIST, 2);
+        }
+
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const uint32_t *pColors, size_t nCount)
+        {
+            m_vecVertices.clear();
+            m_vecVertices.reserve(nCount * 6);
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const D3DCOLOR nColor = GetColor(pColors, i);
+                const CVector2D<T> vecTopRight(pMax[i].GetX(), pMin[i].GetY());
+                const CVector2D<T> vecBottomLeft(pMin[i].GetX(), pMax[i].GetY());
+
+                PushVertex(pMin[i], nColor);
+                PushVertex(vecTopRight, nColor);
+                PushVertex(vecBottomLeft, nColor);
+                PushVertex(vecBottomLeft, nColor);
+                PushVertex(vecTopRight, nColor);
+                PushVertex(pMax[i], nColor);
+            }
+
+            Submit(D3DPT_TRIANGLELIST, 3);
+        }
+
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const uint32_t *pColors, size_t nCount)
+        {
+            m_vecVertices.clear();
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                const D3DCOLOR nColor = GetColor(pColors, i);
+                const float flCenterX = static_cast<float>(pCenters[i].GetX());
+                const float flCenterY = static_cast<float>(pCenters[i].GetY());
+                const float flRadius = pRadii[i];
+                const float *pUnitCircle = m_CircleCache.GetUnitCircle(flRadius);
+                const size_t nSegments = m_CircleCache.GetSegmentCount(flRadius);
+
+                for (size_t j = 0; j < nSegments; j++)
+                {
+                    m_vecVertices.push_back({flCenterX, flCenterY, 0.0f, 1.0f, nColor});
+                    m_vecVertices.push_back({flCenterX + pUnitCircle[j * 2] * flRadius, flCenterY + pUnitCircle[j * 2 + 1] * flRadius, 0.0f, 1.0f, nColor});
+                    m_vecVertices.push_back({flCenterX + pUnitCircle[j * 2 + 2] * flRadius, flCenterY + pUnitCircle[j * 2 + 3] * flRadius, 0.0f, 1.0f, nColor});
+                }
+            }
+
+            Submit(D3DPT_TRIANGLELIST, 3);
+        }
+
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const uint32_t *pColors, size_t nCount)
+        {
+            m_vecVertices.clear();
+            m_vecVertices.reserve(nCount * 3);
+
+            for (size_t i = 0; i < nCount * 3; i++)
+                PushVertex(pVertices[i], GetColor(pColors, i / 3));
+
+            Submit(D3DPT_TRIANGLELIST, 3);
+        }
+
+        /**
+         * @brief Colors are per triangle while D3D9 colors vertices, so shared vertices are unrolled into the triangle list.
+         * */
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, const uint32_t *pColors, size_t nCount)
+        {
+            m_vecVertices.clear();
+            m_vecVertices.reserve(nCount * 3);
+
+            for (size_t i = 0; i < nCount * 3; i++)
+                PushVertex(pVertices[pIndices[i]], GetColor(pColors, i / 3));
+
+            Submit(D3DPT_TRIANGLELIST, 3);
+        }
     };
 } // namespace Cali
\ No newline at end of file
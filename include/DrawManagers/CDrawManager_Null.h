@@ -0,0 +1,217 @@
+#pragma once
+
+/**
+ * @file CDrawManager_Null.h
+ * @brief Contains the declaration of the CDrawManager_Null class.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "CDrawBackend.h"
+#include "../CDrawCommand.h"
+#include "../CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @class CDrawManager_Null
+     * @brief Headless backend that counts and checksums what it receives instead of drawing it.
+     *
+     * It needs no GPU, so it isolates the cost of CDrawManager's dispatch, batching and culling and lets
+     * two runs be compared for identical output through GetChecksum().
+     */
+    class CDrawManager_Null : public CDrawBackend<CDrawManager_Null>
+    {
+    private:
+        static constexpr uint64_t CHECKSUM_BASIS = 14695981039346656037ull;
+        static constexpr uint64_t CHECKSUM_PRIME = 1099511628211ull;
+
+        uint64_t m_nPrimitives[DRAW_COMMAND_INDEXED_TRIANGLES + 1] = {};
+        uint64_t m_nDrawCalls = 0;
+        uint64_t m_nChecksum = CHECKSUM_BASIS;
+
+        void Mix(uint32_t nValue)
+        {
+            m_nChecksum = (m_nChecksum ^ nValue) * CHECKSUM_PRIME;
+        }
+
+        void Mix(float flValue)
+        {
+            uint32_t nBits;
+            std::memcpy(&nBits, &flValue, sizeof(nBits));
+            Mix(nBits);
+        }
+
+        template <typename T>
+        void Mix(const CVector2D<T> &vec)
+        {
+            Mix(static_cast<float>(vec.GetX()));
+            Mix(static_cast<float>(vec.GetY()));
+        }
+
+        void MixColor(const uint32_t *pColors, size_t nIndex)
+        {
+            Mix(pColors ? pColors[nIndex] : CONST_COLOR_DEFAULT);
+        }
+
+    public:
+        void Initialize() { Reset(); }
+        void Shutdown() {}
+
+        /**
+         * @brief Clear all counters and the checksum.
+         * */
+        void Reset()
+        {
+            std::memset(m_nPrimitives, 0, sizeof(m_nPrimitives));
+            m_nDrawCalls = 0;
+            m_nChecksum = CHECKSUM_BASIS;
+        }
+
+        /**
+         * @brief Get the number of primitives of a type received.
+         * @param nType The primitive type.
+         * @return The number of primitives.
+         * */
+        uint64_t GetPrimitiveCount(DrawCommandType_e nType) const { return m_nPrimitives[nType]; }
+
+        /**
+         * @brief Get the number of primitives received.
+         * @return The number of primitives.
+         * */
+        uint64_t GetPrimitiveCount() const
+        {
+            uint64_t nTotal = 0;
+            for (uint64_t nPrimitives : m_nPrimitives)
+                nTotal += nPrimitives;
+
+            return nTotal;
+        }
+
+        /**
+         * @brief Get the number of backend calls received, single and bulk alike.
+         * @return The number of calls.
+         * */
+        uint64_t GetDrawCallCount() const { return m_nDrawCalls; }
+
+        /**
+         * @brief Get an FNV-1a checksum over the order, geometry and colors of everything received.
+         * @return The checksum.
+         * */
+        uint64_t GetChecksum() const { return m_nChecksum; }
+
+        template <typename T = float>
+        void DrawLine(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_nPrimitives[DRAW_COMMAND_LINE]++;
+            m_nDrawCalls++;
+            Mix(v1);
+            Mix(v2);
+        }
+
+        template <typename T = float>
+        void DrawRect(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_nPrimitives[DRAW_COMMAND_RECT]++;
+            m_nDrawCalls++;
+            Mix(v1);
+            Mix(v2);
+        }
+
+        template <typename T = float>
+        void DrawCircle(CVector2D<T> v1, double radius)
+        {
+            m_nPrimitives[DRAW_COMMAND_CIRCLE]++;
+            m_nDrawCalls++;
+            Mix(v1);
+            Mix(static_cast<float>(radius));
+        }
+
+        template <typename T = float>
+        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3)
+        {
+            m_nPrimitives[DRAW_COMMAND_TRIANGLE]++;
+            m_nDrawCalls++;
+            Mix(v1);
+            Mix(v2);
+            Mix(v3);
+        }
+
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const uint32_t *pColors, size_t nCount)
+        {
+            m_nPrimitives[DRAW_COMMAND_LINE] += nCount;
+            m_nDrawCalls++;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                Mix(pStart[i]);
+                Mix(pEnd[i]);
+                MixColor(pColors, i);
+            }
+        }
+
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const uint32_t *pColors, size_t nCount)
+        {
+            m_nPrimitives[DRAW_COMMAND_RECT] += nCount;
+            m_nDrawCalls++;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                Mix(pMin[i]);
+                Mix(pMax[i]);
+                MixColor(pColors, i);
+            }
+        }
+
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const uint32_t *pColors, size_t nCount)
+        {
+            m_nPrimitives[DRAW_COMMAND_CIRCLE] += nCount;
+            m_nDrawCalls++;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                Mix(pCenters[i]);
+                Mix(pRadii[i]);
+                MixColor(pColors, i);
+            }
+        }
+
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const uint32_t *pColors, size_t nCount)
+        {
+            m_nPrimitives[DRAW_COMMAND_TRIANGLE] += nCount;
+            m_nDrawCalls++;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                Mix(pVertices[i * 3]);
+                Mix(pVertices[i * 3 + 1]);
+                Mix(pVertices[i * 3 + 2]);
+                MixColor(pColors, i);
+            }
+        }
+
+        /**
+         * @brief Count indexed triangles separately, but checksum them like DrawTriangles() so both paths compare equal.
+         * */
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, const uint32_t *pColors, size_t nCount)
+        {
+            m_nPrimitives[DRAW_COMMAND_INDEXED_TRIANGLES] += nCount;
+            m_nDrawCalls++;
+
+            for (size_t i = 0; i < nCount; i++)
+            {
+                Mix(pVertices[pIndices[i * 3]]);
+                Mix(pVertices[pIndices[i * 3 + 1]]);
+                Mix(pVertices[pIndices[i * 3 + 2]]);
+                MixColor(pColors, i);
+            }
+        }
+    };
+
+} // namespace Cali
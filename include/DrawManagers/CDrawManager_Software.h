@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * @file CDrawManager_Software.h
+ * @brief Contains the declaration of the CDrawManager_Software class.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CDrawBackend.h"
+#include "../CSDFCoverage.h"
+#include "../CVector2D.h"
+
+namespace Cali
+{
+    /**
+     * @class CDrawManager_Software
+     * @brief Backend that rasterizes into memory with analytic anti-aliasing, see CSDFCoverage.
+     *
+     * Edges are smooth at one sample per pixel, so no multisampled target is needed. Set the target size
+     * through GetTarget().Resize() before drawing and read the result from GetTarget().GetPixels().
+     */
+    class CDrawManager_Software : public CDrawBackend<CDrawManager_Software>
+    {
+    private:
+        CSDFCoverage m_Target;
+
+    public:
+        void Initialize() { m_Target.Clear(); }
+        void Shutdown() {}
+
+        /**
+         * @brief Get the render target, e.g. to resize, clear or read it or to set the line width.
+         * @return The render target.
+         * */
+        CSDFCoverage &GetTarget() { return m_Target; }
+
+        template <typename T = float>
+        void DrawLine(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_Target.DrawLine(ToFloat(v1), ToFloat(v2), CONST_COLOR_DEFAULT);
+        }
+
+        template <typename T = float>
+        void DrawRect(CVector2D<T> v1, CVector2D<T> v2)
+        {
+            m_Target.DrawRect(ToFloat(v1), ToFloat(v2), CONST_COLOR_DEFAULT);
+        }
+
+        template <typename T = float>
+        void DrawCircle(CVector2D<T> v1, double radius)
+        {
+            m_Target.FillCircle(ToFloat(v1), static_cast<float>(radius), CONST_COLOR_DEFAULT);
+        }
+
+        template <typename T = float>
+        void DrawTriangle(CVector2D<T> v1, CVector2D<T> v2, CVector2D<T> v3)
+        {
+            m_Target.FillTriangle(ToFloat(v1), ToFloat(v2), ToFloat(v3), CONST_COLOR_DEFAULT);
+        }
+
+        template <typename T = float>
+        void DrawLines(const CVector2D<T> *pStart, const CVector2D<T> *pEnd, const uint32_t *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                m_Target.DrawLine(ToFloat(pStart[i]), ToFloat(pEnd[i]), GetColor(pColors, i));
+        }
+
+        template <typename T = float>
+        void DrawRects(const CVector2D<T> *pMin, const CVector2D<T> *pMax, const uint32_t *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                m_Target.DrawRect(ToFloat(pMin[i]), ToFloat(pMax[i]), GetColor(pColors, i));
+        }
+
+        template <typename T = float>
+        void DrawCircles(const CVector2D<T> *pCenters, const float *pRadii, const uint32_t *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                m_Target.FillCircle(ToFloat(pCenters[i]), pRadii[i], GetColor(pColors, i));
+        }
+
+        template <typename T = float>
+        void DrawTriangles(const CVector2D<T> *pVertices, const uint32_t *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                m_Target.FillTriangle(ToFloat(pVertices[i * 3]), ToFloat(pVertices[i * 3 + 1]), ToFloat(pVertices[i * 3 + 2]), GetColor(pColors, i));
+        }
+
+        template <typename T = float>
+        void DrawIndexedTriangles(const CVector2D<T> *pVertices, const uint32_t *pIndices, const uint32_t *pColors, size_t nCount)
+        {
+            for (size_t i = 0; i < nCount; i++)
+                m_Target.FillTriangle(ToFloat(pVertices[pIndices[i * 3]]), ToFloat(pVertices[pIndices[i * 3 + 1]]), ToFloat(pVertices[pIndices[i * 3 + 2]]), GetColor(pColors, i));
+        }
+    };
+
+} // namespace Cali
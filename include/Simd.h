@@ -0,0 +1,27 @@
+#pragma once
+
+/**
+ * @file Simd.h
+ * @brief Detects the SIMD instruction sets the batched kernels can use.
+ *
+ * CALI_SIMD_SSE2 is defined when SSE2 intrinsics are available. CALI_SIMD_BMI2 and CALI_SIMD_F16C are
+ * defined when the BMI2 bit deposit and the F16C half-float conversion instructions are, which needs
+ * e.g. -mbmi2 -mf16c or -march=haswell; MSVC has no macro for either, so AVX2 stands in for them
+ * there. Every kernel keeps a scalar path for other targets, and defining CALI_DISABLE_SIMD forces
+ * that path.
+ */
+
+#if !defined(CALI_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CALI_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if !defined(CALI_DISABLE_SIMD) && (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define CALI_SIMD_BMI2
+#include <immintrin.h>
+#endif
+
+#if !defined(CALI_DISABLE_SIMD) && (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define CALI_SIMD_F16C
+#include <immintrin.h>
+#endif